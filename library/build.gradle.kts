@@ -40,6 +40,11 @@ android {
         targetCompatibility = JavaVersion.toVersion(jdkVersion)
     }
 
+    testOptions {
+        // JVM 单元测试里 Log、SystemClock 等 Android 桩方法返回默认值，不抛 "not mocked"
+        unitTests.isReturnDefaultValues = true
+    }
+
     publishing {
         singleVariant("release") {
 //            withSourcesJar()
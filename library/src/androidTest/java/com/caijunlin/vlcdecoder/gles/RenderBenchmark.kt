@@ -0,0 +1,443 @@
+package com.caijunlin.vlcdecoder.gles
+
+import android.graphics.PixelFormat
+import android.hardware.HardwareBuffer
+import android.media.ImageReader
+import android.os.Build
+import android.os.Debug
+import android.os.Handler
+import android.os.HandlerThread
+import android.os.Looper
+import android.util.Log
+import android.view.Surface
+import com.caijunlin.vlcdecoder.core.CpuTopology
+import com.caijunlin.vlcdecoder.core.VLCEngineManager
+import org.json.JSONArray
+import org.json.JSONObject
+import java.util.concurrent.CompletableFuture
+import java.util.concurrent.atomic.AtomicBoolean
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 渲染池基准测试配置
+ * @param sources 测试源，推荐循环播放的本地文件(H.264/HEVC 按需要的分辨率与帧率各备一份)，也可以是网络地址
+ * @param streamCount 解码路数，源不够时循环复用；本地文件会被改写为互不相同的等价路径，保证每一路独立解码
+ * @param windowsPerStream 每路流扇出的离屏窗口数
+ * @param width 离屏窗口宽度(物理像素)
+ * @param height 离屏窗口高度(物理像素)
+ * @param warmupMs 开始统计前的预热时长，首帧耗时从绑定时刻起算，不受预热影响
+ * @param durationMs 统计时长
+ * @param sampleIntervalMs 指标采样间隔
+ * @param captureIntervalMs 截图延迟探测间隔，0 表示不探测
+ */
+data class BenchmarkConfig @JvmOverloads constructor(
+    val sources: List<String>,
+    val streamCount: Int = sources.size,
+    val windowsPerStream: Int = 1,
+    val width: Int = 640,
+    val height: Int = 360,
+    val warmupMs: Long = 5_000L,
+    val durationMs: Long = 60_000L,
+    val sampleIntervalMs: Long = 1_000L,
+    val captureIntervalMs: Long = 2_000L
+) {
+    fun toJson(): JSONObject = JSONObject()
+        .put("sources", JSONArray(sources))
+        .put("streamCount", streamCount)
+        .put("windowsPerStream", windowsPerStream)
+        .put("width", width)
+        .put("height", height)
+        .put("warmupMs", warmupMs)
+        .put("durationMs", durationMs)
+        .put("sampleIntervalMs", sampleIntervalMs)
+        .put("captureIntervalMs", captureIntervalMs)
+}
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 渲染池基准与浸泡测试。在当前渲染模式下把 N 路循环播放的源绑定到离屏 ImageReader 画布，
+ * 预热后按间隔采集节点循环耗时、每路流的解码/上屏帧率与拥塞丢帧、交换耗时、截图延迟、首帧耗时以及内存与显存占用，
+ * 结束时解绑全部画布并输出一份 JSON 报告，便于跨版本跟踪回归、横向对比设备。
+ * 渲染模式在引擎初始化时确定，对比 RK 与 MOBILE 需分别以对应模式启动进程各跑一次。同一时刻只允许一个测试。
+ * 只随仪器测试打包，由 RenderBenchmarkTest 驱动，不进入发布的库。
+ */
+object RenderBenchmark {
+
+    private const val REPORT_VERSION = 1
+
+    private val isRunning = AtomicBoolean(false)
+
+    @Volatile
+    private var session: Session? = null
+
+    /** 是否有测试正在进行 */
+    val isActive: Boolean get() = isRunning.get()
+
+    /**
+     * 开始一次测试
+     * @param config 测试配置
+     * @param callback 报告回调，在主线程回调；被取消时同样回调已采集的部分
+     * @return 已有测试在进行、引擎未初始化或配置无效时返回 false
+     */
+    fun run(config: BenchmarkConfig, callback: (JSONObject) -> Unit): Boolean {
+        if (config.sources.isEmpty() || config.streamCount <= 0 || config.windowsPerStream <= 0) return false
+        if (VLCEngineManager.libVLC == null) return false
+        if (!isRunning.compareAndSet(false, true)) return false
+        val current = Session(config, callback)
+        session = current
+        current.start()
+        return true
+    }
+
+    /**
+     * 提前结束正在进行的测试
+     */
+    fun cancel() {
+        session?.finish("cancelled")
+    }
+
+    /**
+     * 本地文件的等价路径，在文件名前插入若干个 "/." 使每一路的地址互不相同，调度池按地址去重时不会合并为同一路
+     */
+    private fun uniqueSource(source: String, copy: Int): String {
+        if (copy == 0) return source
+        if (!source.startsWith("/") && !source.startsWith("file://")) return source
+        val slash = source.lastIndexOf('/')
+        return source.substring(0, slash) + "/.".repeat(copy) + source.substring(slash)
+    }
+
+    /**
+     * 离屏画布客户端，画面交换到 ImageReader 后立即丢弃
+     */
+    private class BenchClient(
+        val index: Int,
+        val url: String,
+        private val width: Int,
+        private val height: Int,
+        handler: Handler
+    ) : IVideoRenderClient {
+
+        private val reader = if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.Q) {
+            ImageReader.newInstance(width, height, PixelFormat.RGBA_8888, 3, HardwareBuffer.USAGE_GPU_COLOR_OUTPUT)
+        } else {
+            ImageReader.newInstance(width, height, PixelFormat.RGBA_8888, 3)
+        }
+
+        @Volatile var bindAtNs = 0L
+        @Volatile var firstFrameAtNs = 0L
+        @Volatile var isFailed = false
+        @Volatile var status: BindStatus? = null
+
+        init {
+            reader.setOnImageAvailableListener({ it.acquireLatestImage()?.close() }, handler)
+        }
+
+        override fun getElementId(): String = "benchmark-$index"
+        override fun getTargetSurface(): Surface? = reader.surface
+        override fun getTargetWidth(): Int = width
+        override fun getTargetHeight(): Int = height
+        override fun getScaleMode(): ScaleMode = ScaleMode.FIT
+
+        override fun onFirstFrameRendered(url: String) {
+            if (firstFrameAtNs == 0L) firstFrameAtNs = System.nanoTime()
+        }
+
+        override fun onPlaybackFailed(url: String) {
+            isFailed = true
+        }
+
+        fun release() {
+            reader.close()
+        }
+    }
+
+    /**
+     * 单次测试的全部状态，只在测试线程访问
+     */
+    private class Session(private val config: BenchmarkConfig, private val callback: (JSONObject) -> Unit) {
+
+        private val thread = HandlerThread("VlcBenchmark").apply { start() }
+        private val handler = Handler(thread.looper)
+        private val isFinished = AtomicBoolean(false)
+
+        private val clients = ArrayList<BenchClient>()
+        private val samples = JSONArray()
+
+        private var measureStartMs = 0L
+        private var captureCursor = 0
+
+        private val tickAvgMs = ArrayList<Float>()
+        private val tickP95Us = ArrayList<Long>()
+        private var tickMaxUs = 0L
+
+        /** 每路流按地址累计的采样 */
+        private class StreamSeries {
+            val presentedFps = ArrayList<Float>()
+            val decodedFps = ArrayList<Float>()
+            val swapP95Us = ArrayList<Long>()
+            var baselineDropped = -1L
+            var lastDropped = 0L
+        }
+        private val streamSeries = LinkedHashMap<String, StreamSeries>()
+
+        private val captureLatencyMs = ArrayList<Float>()
+        private var captureFailures = 0
+
+        private var peakJavaHeap = 0L
+        private var peakNativeHeap = 0L
+        private var peakPssKb = 0L
+        private var peakGraphicsKb = 0L
+        private var peakFboBytes = 0L
+
+        private val sampleRunnable = object : Runnable {
+            override fun run() {
+                sample()
+                handler.postDelayed(this, config.sampleIntervalMs.coerceAtLeast(100L))
+            }
+        }
+
+        private val captureRunnable = object : Runnable {
+            override fun run() {
+                probeCapture()
+                handler.postDelayed(this, config.captureIntervalMs)
+            }
+        }
+
+        fun start() {
+            handler.post {
+                Log.i("VLCDecoder", "Benchmark start (${VLCRenderPool.model}): ${config.streamCount} streams x ${config.windowsPerStream} windows")
+                for (i in 0 until config.streamCount) {
+                    val source = config.sources[i % config.sources.size]
+                    val url = uniqueSource(source, i / config.sources.size)
+                    repeat(config.windowsPerStream) {
+                        val client = BenchClient(clients.size, url, config.width, config.height, handler)
+                        clients.add(client)
+                        client.bindAtNs = System.nanoTime()
+                        VLCRenderPool.bindClientAsync(url, client).thenAccept { client.status = it.status }
+                    }
+                }
+                handler.postDelayed({ beginMeasure() }, config.warmupMs.coerceAtLeast(0L))
+            }
+        }
+
+        private fun beginMeasure() {
+            // 先取一次快照，清掉预热期间累积的区间直方图
+            VLCRenderPool.getMetricsAsync().join().nodes.forEach { node ->
+                node.streams.forEach { series(it.url).baselineDropped = it.droppedByCongestion }
+            }
+            measureStartMs = System.currentTimeMillis()
+            handler.postDelayed(sampleRunnable, config.sampleIntervalMs.coerceAtLeast(100L))
+            if (config.captureIntervalMs > 0L) handler.postDelayed(captureRunnable, config.captureIntervalMs)
+            handler.postDelayed({ finish(null) }, config.durationMs.coerceAtLeast(0L))
+        }
+
+        private fun series(url: String): StreamSeries = streamSeries.getOrPut(url) { StreamSeries() }
+
+        private fun sample() {
+            val metrics = VLCRenderPool.getMetricsAsync().join()
+            val nodesJson = JSONArray()
+            val streamsJson = JSONArray()
+            metrics.nodes.forEach { node ->
+                tickAvgMs.add(node.avgTickMs)
+                tickP95Us.add(node.tick.p95Us)
+                if (node.tick.maxUs > tickMaxUs) tickMaxUs = node.tick.maxUs
+                nodesJson.put(
+                    JSONObject()
+                        .put("node", node.nodeIndex)
+                        .put("activeStreams", node.activeStreams)
+                        .put("avgTickMs", node.avgTickMs.toDouble())
+                        .put("tick", node.tick.toJson())
+                )
+                node.streams.forEach { stream ->
+                    val series = series(stream.url)
+                    series.presentedFps.add(stream.presentedFps)
+                    series.decodedFps.add(stream.decodedFps)
+                    series.swapP95Us.add(stream.swap.p95Us)
+                    if (series.baselineDropped < 0L) series.baselineDropped = stream.droppedByCongestion
+                    series.lastDropped = stream.droppedByCongestion
+                    streamsJson.put(
+                        JSONObject()
+                            .put("url", stream.url)
+                            .put("presentedFps", stream.presentedFps.toDouble())
+                            .put("decodedFps", stream.decodedFps.toDouble())
+                            .put("droppedByCongestion", stream.droppedByCongestion)
+                            .put("swap", stream.swap.toJson())
+                    )
+                }
+            }
+            samples.put(
+                JSONObject()
+                    .put("t", System.currentTimeMillis() - measureStartMs)
+                    .put("nodes", nodesJson)
+                    .put("streams", streamsJson)
+                    .put("memory", sampleMemory())
+            )
+        }
+
+        private fun sampleMemory(): JSONObject {
+            val runtime = Runtime.getRuntime()
+            val javaHeap = runtime.totalMemory() - runtime.freeMemory()
+            val nativeHeap = Debug.getNativeHeapAllocatedSize()
+            val info = Debug.MemoryInfo()
+            Debug.getMemoryInfo(info)
+            val pssKb = info.totalPss.toLong()
+            val graphicsKb = info.getMemoryStat("summary.graphics")?.toLongOrNull() ?: -1L
+            val fboBytes = GpuMemoryBudget.totalBytes
+            peakJavaHeap = maxOf(peakJavaHeap, javaHeap)
+            peakNativeHeap = maxOf(peakNativeHeap, nativeHeap)
+            peakPssKb = maxOf(peakPssKb, pssKb)
+            peakGraphicsKb = maxOf(peakGraphicsKb, graphicsKb)
+            peakFboBytes = maxOf(peakFboBytes, fboBytes)
+            return JSONObject()
+                .put("javaHeapBytes", javaHeap)
+                .put("nativeHeapBytes", nativeHeap)
+                .put("totalPssKb", pssKb)
+                .put("graphicsKb", graphicsKb)
+                .put("fboBytes", fboBytes)
+        }
+
+        /**
+         * 轮流对已出首帧的画布发起一次异步截图，记录从请求到拿到位图的耗时
+         */
+        private fun probeCapture() {
+            val ready = clients.filter { it.firstFrameAtNs != 0L && !it.isFailed }
+            if (ready.isEmpty()) return
+            val client = ready[captureCursor++ % ready.size]
+            val startNs = System.nanoTime()
+            VLCRenderPool.captureClientFrameAsync(client).thenAccept { bitmap ->
+                val costMs = (System.nanoTime() - startNs) / 1_000_000f
+                handler.post {
+                    if (bitmap == null) captureFailures++ else captureLatencyMs.add(costMs)
+                }
+                bitmap?.recycle()
+            }
+        }
+
+        fun finish(reason: String?) {
+            if (!isFinished.compareAndSet(false, true)) return
+            handler.removeCallbacksAndMessages(null)
+            handler.post {
+                val report = buildReport(reason ?: "ok")
+                Log.i("VLCDecoder", "Benchmark finished: ${reason ?: "ok"}")
+                val unbinds = clients.map { VLCRenderPool.unbindClientAsync(it.url, it) }
+                // 画布在节点线程摘除后才能关闭，节点迟迟未响应时兜底关闭
+                val isReleased = AtomicBoolean(false)
+                val releaseAll = Runnable {
+                    if (!isReleased.compareAndSet(false, true)) return@Runnable
+                    clients.forEach { it.release() }
+                    thread.quitSafely()
+                }
+                CompletableFuture.allOf(*unbinds.toTypedArray()).whenComplete { _, _ -> handler.post(releaseAll) }
+                handler.postDelayed(releaseAll, RELEASE_TIMEOUT_MS)
+                session = null
+                isRunning.set(false)
+                Handler(Looper.getMainLooper()).post { callback(report) }
+            }
+        }
+
+        private fun buildReport(status: String): JSONObject {
+            val startupMs = ArrayList<Float>()
+            var failed = 0
+            var rejected = 0
+            val clientsJson = JSONArray()
+            clients.forEach { client ->
+                val firstFrameMs = if (client.firstFrameAtNs != 0L) (client.firstFrameAtNs - client.bindAtNs) / 1_000_000f else -1f
+                if (firstFrameMs >= 0f) startupMs.add(firstFrameMs)
+                if (client.isFailed) failed++
+                val bindStatus = client.status
+                if (bindStatus != null && bindStatus != BindStatus.ACCEPTED) rejected++
+                clientsJson.put(
+                    JSONObject()
+                        .put("url", client.url)
+                        .put("bind", bindStatus?.name ?: "PENDING")
+                        .put("firstFrameMs", firstFrameMs.toDouble())
+                        .put("failed", client.isFailed)
+                )
+            }
+
+            val streamsJson = JSONArray()
+            var totalDropped = 0L
+            streamSeries.forEach { (url, series) ->
+                val dropped = if (series.baselineDropped >= 0L) series.lastDropped - series.baselineDropped else 0L
+                totalDropped += dropped
+                streamsJson.put(
+                    JSONObject()
+                        .put("url", url)
+                        .put("meanPresentedFps", series.presentedFps.average().orZero())
+                        .put("minPresentedFps", (series.presentedFps.minOrNull() ?: 0f).toDouble())
+                        .put("meanDecodedFps", series.decodedFps.average().orZero())
+                        .put("droppedByCongestion", dropped)
+                        .put("swapP95Us", percentile(series.swapP95Us, 0.95f))
+                )
+            }
+
+            return JSONObject()
+                .put("version", REPORT_VERSION)
+                .put("status", status)
+                .put("mode", VLCRenderPool.model.name)
+                .put("timestampMs", System.currentTimeMillis())
+                .put("measuredMs", if (measureStartMs > 0L) System.currentTimeMillis() - measureStartMs else 0L)
+                .put(
+                    "device", JSONObject()
+                        .put("manufacturer", Build.MANUFACTURER)
+                        .put("model", Build.MODEL)
+                        .put("hardware", Build.HARDWARE)
+                        .put("soc", if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.S) Build.SOC_MODEL else "")
+                        .put("sdk", Build.VERSION.SDK_INT)
+                )
+                .put("cpu", CpuTopology.toJson())
+                .put("config", config.toJson())
+                .put(
+                    "startup", JSONObject()
+                        .put("firstFrames", startupMs.size)
+                        .put("p50Ms", percentile(startupMs, 0.5f))
+                        .put("p95Ms", percentile(startupMs, 0.95f))
+                        .put("maxMs", (startupMs.maxOrNull() ?: 0f).toDouble())
+                        .put("failed", failed)
+                        .put("rejected", rejected)
+                )
+                .put(
+                    "tick", JSONObject()
+                        .put("meanAvgMs", tickAvgMs.average().orZero())
+                        .put("p95Us", percentile(tickP95Us, 0.95f))
+                        .put("maxUs", tickMaxUs)
+                )
+                .put(
+                    "capture", JSONObject()
+                        .put("count", captureLatencyMs.size)
+                        .put("failures", captureFailures)
+                        .put("p50Ms", percentile(captureLatencyMs, 0.5f))
+                        .put("p95Ms", percentile(captureLatencyMs, 0.95f))
+                        .put("maxMs", (captureLatencyMs.maxOrNull() ?: 0f).toDouble())
+                )
+                .put(
+                    "memory", JSONObject()
+                        .put("peakJavaHeapBytes", peakJavaHeap)
+                        .put("peakNativeHeapBytes", peakNativeHeap)
+                        .put("peakTotalPssKb", peakPssKb)
+                        .put("peakGraphicsKb", peakGraphicsKb)
+                        .put("peakFboBytes", peakFboBytes)
+                        .put("gpuBudgetBytes", GpuMemoryBudget.budgetBytes)
+                )
+                .put("droppedByCongestion", totalDropped)
+                .put("clients", clientsJson)
+                .put("streams", streamsJson)
+                .put("samples", samples)
+        }
+
+        private fun Double.orZero(): Double = if (isNaN()) 0.0 else this
+
+        private fun <T : Number> percentile(values: List<T>, p: Float): Double {
+            if (values.isEmpty()) return 0.0
+            val sorted = values.map { it.toDouble() }.sorted()
+            val index = ((sorted.size - 1) * p).toInt().coerceIn(0, sorted.size - 1)
+            return sorted[index]
+        }
+
+        private companion object {
+            const val RELEASE_TIMEOUT_MS = 2_000L
+        }
+    }
+}
@@ -0,0 +1,72 @@
+package com.caijunlin.vlcdecoder.gles
+
+import android.util.Log
+import androidx.test.ext.junit.runners.AndroidJUnit4
+import androidx.test.platform.app.InstrumentationRegistry
+import com.caijunlin.vlcdecoder.core.VLCEngineManager
+import org.json.JSONObject
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNotNull
+import org.junit.Assert.assertTrue
+import org.junit.Assume.assumeTrue
+import org.junit.Test
+import org.junit.runner.RunWith
+import java.io.File
+import java.util.concurrent.CountDownLatch
+import java.util.concurrent.TimeUnit
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 在真机上驱动 RenderBenchmark，报告写入应用外部存储的 files 目录并打印到日志。
+ * 测试源经仪器参数传入，未传入时跳过，例如：
+ * adb shell am instrument -w -e class com.caijunlin.vlcdecoder.gles.RenderBenchmarkTest
+ * -e benchmarkSources /sdcard/Movies/720p.mp4 -e benchmarkStreams 9 -e benchmarkMode MOBILE
+ * com.caijunlin.vlcdecoder.test/androidx.test.runner.AndroidJUnitRunner
+ */
+@RunWith(AndroidJUnit4::class)
+class RenderBenchmarkTest {
+
+    @Test
+    fun runBenchmark() {
+        val args = InstrumentationRegistry.getArguments()
+        val sources = args.getString("benchmarkSources").orEmpty()
+            .split(',').map { it.trim() }.filter { it.isNotEmpty() }
+        assumeTrue("benchmarkSources not provided", sources.isNotEmpty())
+
+        val context = InstrumentationRegistry.getInstrumentation().targetContext
+        args.getString("benchmarkMode")?.let { VLCRenderPool.model = EGLRenderMode.valueOf(it.uppercase()) }
+        VLCEngineManager.init(context)
+
+        val config = BenchmarkConfig(
+            sources = sources,
+            streamCount = args.getString("benchmarkStreams")?.toIntOrNull() ?: sources.size,
+            windowsPerStream = args.getString("benchmarkWindows")?.toIntOrNull() ?: 1,
+            warmupMs = args.getString("benchmarkWarmupMs")?.toLongOrNull() ?: 5_000L,
+            durationMs = args.getString("benchmarkDurationMs")?.toLongOrNull() ?: 60_000L
+        )
+
+        val latch = CountDownLatch(1)
+        var report: JSONObject? = null
+        assertTrue("benchmark already running", RenderBenchmark.run(config) { result ->
+            report = result
+            latch.countDown()
+        })
+        val timeoutMs = config.warmupMs + config.durationMs + REPORT_TIMEOUT_MS
+        if (!latch.await(timeoutMs, TimeUnit.MILLISECONDS)) {
+            RenderBenchmark.cancel()
+            latch.await(REPORT_TIMEOUT_MS, TimeUnit.MILLISECONDS)
+        }
+
+        val result = report
+        assertNotNull("benchmark produced no report", result)
+        val json = result!!.toString(2)
+        File(context.getExternalFilesDir(null), "render-benchmark.json").writeText(json)
+        Log.i("VLCDecoder", "Benchmark report: $json")
+        assertEquals("ok", result.getString("status"))
+    }
+
+    private companion object {
+        const val REPORT_TIMEOUT_MS = 30_000L
+    }
+}
@@ -1,13 +1,27 @@
 package com.caijunlin.vlcdecoder
 
+import android.content.ComponentCallbacks2
 import android.content.Context
+import android.content.res.Configuration
 import android.util.Log
+import android.view.Surface
 import com.caijunlin.vlcdecoder.callback.KernelInitCallback
 import com.caijunlin.vlcdecoder.core.KernelManager
+import com.caijunlin.vlcdecoder.core.StartupWarmUp
 import com.caijunlin.vlcdecoder.core.VLCEngineManager
 import com.caijunlin.vlcdecoder.gles.EGLRenderMode
+import com.caijunlin.vlcdecoder.gles.EngineMetrics
+import com.caijunlin.vlcdecoder.gles.ImageEnhancement
+import com.caijunlin.vlcdecoder.gles.LatencyProfile
+import com.caijunlin.vlcdecoder.gles.LingerPolicy
+import com.caijunlin.vlcdecoder.gles.PosterCache
+import com.caijunlin.vlcdecoder.gles.ReconnectPolicy
+import com.caijunlin.vlcdecoder.gles.RenderAffinity
+import com.caijunlin.vlcdecoder.gles.ResolutionTier
+import com.caijunlin.vlcdecoder.gles.StreamVariantResolver
 import com.caijunlin.vlcdecoder.gles.VLCRenderPool
 import com.caijunlin.vlcdecoder.widget.WidgetManager
+import java.util.concurrent.CompletableFuture
 
 /**
  * @author : caijunlin
@@ -34,15 +48,65 @@ object StreamKit {
         KernelManager.initKernel(context, authCode, needAutoSaveLicense)
         VLCRenderPool.model = mode
         VLCEngineManager.init(context)
+        PosterCache.init(context)
+        registerMemoryCallback(context)
+    }
+
+    /**
+     * 分阶段并行初始化，调用线程立即返回：X5 内核安装/授权、LibVLC 创建、全部渲染节点的 EGL 与着色器初始化
+     * 同时在后台线程进行，各阶段就绪经 KernelInitCallback 的 onStageReady 回调，全部结束后回调 onWarmUpFinished。
+     * 首路流绑定须在 ENGINE 阶段就绪之后；RENDER 阶段就绪后首帧不再等待节点建上下文与编译着色器。
+     * @param context 应用上下文对象
+     * @param authCode X5浏览器内核授权码
+     * @param mode 渲染模式
+     * @param needAutoSaveLicense 是否自动缓存授权码到本地，默认为 true
+     */
+    @JvmStatic
+    @JvmOverloads
+    fun initAsync(
+        context: Context,
+        authCode: String,
+        mode: EGLRenderMode,
+        needAutoSaveLicense: Boolean = true
+    ) {
+        VLCRenderPool.model = mode
+        PosterCache.init(context)
+        registerMemoryCallback(context)
+        StartupWarmUp.start(context, authCode, needAutoSaveLicense)
+    }
+
+    @Volatile
+    private var memoryCallback: ComponentCallbacks2? = null
+
+    /**
+     * 监听系统内存告警，内存吃紧时优先淘汰预热池中的流
+     */
+    private fun registerMemoryCallback(context: Context) {
+        if (memoryCallback != null) return
+        val callback = object : ComponentCallbacks2 {
+            override fun onTrimMemory(level: Int) {
+                VLCRenderPool.trimMemory(level)
+            }
+
+            override fun onConfigurationChanged(newConfig: Configuration) {}
+
+            @Deprecated("Deprecated in Java")
+            override fun onLowMemory() {
+                VLCRenderPool.trimMemory(ComponentCallbacks2.TRIM_MEMORY_COMPLETE)
+            }
+        }
+        memoryCallback = callback
+        context.applicationContext.registerComponentCallbacks(callback)
     }
 
     @JvmStatic
     fun registerCallback(callback: KernelInitCallback) {
         KernelManager.registerCallback(callback)
+        StartupWarmUp.registerCallback(callback)
     }
 
     /**
-     * 设置渲染引擎允许同时解析的最大视频流数量，超出此限制的新流将被拒绝，防止榨干硬件算力。
+     * 设置渲染引擎允许同时解析的最大视频流数量（所有节点合计），超出时按优先级抢占低优先级流或拒绝新流。
      * @param maxCount 允许并发解析的最大流数量（默认 16）
      */
     @JvmStatic
@@ -50,6 +114,237 @@ object StreamKit {
         VLCRenderPool.setMaxStreamCount(maxCount)
     }
 
+    /**
+     * 为每个渲染节点创建独立的 LibVLC 实例，减少多路流之间的引擎内部锁竞争，须在首路流播放前调用。
+     * 实例随 releaseAll 一并销毁，releaseRender 只释放播放器、保留实例以便下次秒播。
+     * @param enabled 是否分片
+     * @param argsByNode 节点序号 → 该节点专属的启动参数，未配置的节点沿用全局参数
+     */
+    @JvmStatic
+    @JvmOverloads
+    fun setEnginePerNode(enabled: Boolean, argsByNode: Map<Int, List<String>> = emptyMap()) {
+        VLCEngineManager.setShardedPerNode(enabled, argsByNode)
+    }
+
+    /**
+     * 设置硬件解码会话耗尽后允许同时软解的最大路数（默认 CPU 核数的一半），超出时非聚焦的新流将被拒绝。
+     * @param maxCount 软解路数上限
+     */
+    @JvmStatic
+    fun setMaxSoftwareDecodeCount(maxCount: Int) {
+        VLCRenderPool.setMaxSoftwareDecodeCount(maxCount)
+    }
+
+    /**
+     * 设置全局解码预算（像素/秒），预算不足时低优先级的流先被降档、再被抢占，高优先级的新流才优先获准。
+     * @param pixelsPerSecond 每秒可解码的像素总数（默认相当于 16 路 720p@25）
+     */
+    @JvmStatic
+    fun setDecodeBudget(pixelsPerSecond: Long) {
+        VLCRenderPool.setDecodeBudget(pixelsPerSecond)
+    }
+
+    /**
+     * 设置全局显存预算（字节），默认约为 24 路 720p 的 RGBA 中转缓冲。准入控制据此降档或拒绝新流，
+     * FBO 复用池在总量超出预算时不再保留闲置缓冲，池的使用情况见 printNodeDiagnostics。
+     * @param bytes 预算字节数
+     */
+    @JvmStatic
+    fun setGpuMemoryBudget(bytes: Long) {
+        VLCRenderPool.setGpuMemoryBudget(bytes)
+    }
+
+    /**
+     * 为指定渲染模式开启 OES 单拷贝直出，省去每帧一次整屏的 OES→FBO 中转绘制。
+     * 同一路流被多个窗口订阅或需要截图时会自动回退到 FBO 中转。
+     * @param mode 渲染模式
+     * @param enabled 是否开启（默认关闭）
+     */
+    @JvmStatic
+    fun setDirectRender(mode: EGLRenderMode, enabled: Boolean) {
+        VLCRenderPool.setDirectRender(mode, enabled)
+    }
+
+    /**
+     * 设置解码分辨率档位上限。每路流会跟随其最大的绑定窗口向上取整到 360p/540p/720p/1080p 中的某一档，
+     * 缩略图小窗只按小档位解码与分配 FBO。
+     * @param tier 档位上限（默认 720p）
+     */
+    @JvmStatic
+    fun setMaxResolutionTier(tier: ResolutionTier) {
+        VLCRenderPool.setMaxResolutionTier(tier)
+    }
+
+    /**
+     * 注册多码流源的变体解析器，例如把主码流地址按档位映射为 RTSP 子码流地址。
+     * @param resolver 解析器，传 null 取消
+     */
+    @JvmStatic
+    fun setStreamVariantResolver(resolver: StreamVariantResolver?) {
+        VLCRenderPool.variantResolver = resolver
+    }
+
+    /**
+     * 预热即将播放的流，例如巡检列表中的相邻通道。之后绑定到这些地址时直接接管已缓冲的播放器，实现秒切。
+     * @param urls 预测的下一批流地址
+     */
+    @JvmStatic
+    fun preload(urls: List<String>) {
+        VLCRenderPool.preload(urls)
+    }
+
+    /**
+     * 设置预热池允许同时缓冲的最大流数量，独立于 setMaxStreamCount 的并发上限
+     * @param maxCount 预热上限（默认 4，传 0 关闭预热）
+     */
+    @JvmStatic
+    fun setMaxPreloadCount(maxCount: Int) {
+        VLCRenderPool.setMaxPreloadCount(maxCount)
+    }
+
+    /**
+     * 配置最近解绑流的闲置缓存，翻页来回切换时复用仍在存活期内的播放器与网络会话。
+     * 可按设备档次调优：低端设备缩短存活期或关闭保活解码，高端设备可放宽数量与时长。
+     * @param ttlMs 闲置存活时长（默认 500ms，传 0 表示解绑即释放）
+     * @param maxIdle 每个渲染节点最多缓存的闲置流数量（默认 8）
+     * @param keepDecoding 闲置期间是否继续解码，false 时暂停播放器（默认 true）
+     */
+    @JvmStatic
+    @JvmOverloads
+    fun setLingerPolicy(ttlMs: Long, maxIdle: Int = 8, keepDecoding: Boolean = true) {
+        VLCRenderPool.setLingerPolicy(LingerPolicy(ttlMs, maxIdle, keepDecoding))
+    }
+
+    /**
+     * 设置渲染节点线程的绑核策略（默认不绑核）。大小核异构的 SoC（如 RK3588 4×A76 + 4×A55）上
+     * 可把渲染线程限制在大核，绑核前后的循环耗时对比见 getMetrics() 中各节点的 avgTickBigMs / avgTickLittleMs。
+     * @param affinity 绑核策略
+     */
+    @JvmStatic
+    fun setRenderAffinity(affinity: RenderAffinity) {
+        VLCRenderPool.setRenderAffinity(affinity)
+    }
+
+    /**
+     * 设置断流重连策略：指数退避叠加随机抖动，同一 NVR 主机连续失败后熔断并只放行一路探测流。
+     * @param policy 重连策略
+     * @param url 为 null 时设置全局策略，否则只作用于该地址
+     */
+    @JvmStatic
+    @JvmOverloads
+    fun setReconnectPolicy(policy: ReconnectPolicy, url: String? = null) {
+        if (url == null) VLCRenderPool.setReconnectPolicy(policy) else VLCRenderPool.setStreamReconnectPolicy(url, policy)
+    }
+
+    /**
+     * 设置某一路流的延迟档位。ULTRA_LOW 用最小缓冲、拿到帧立即上屏，适合云台控制等跟手画面；
+     * SMOOTH 加大缓冲并不主动丢帧。各路流的实测上屏延迟与抖动见 getMetrics()。
+     * @param url 视频流地址
+     * @param profile 延迟档位
+     */
+    @JvmStatic
+    fun setLatencyProfile(url: String, profile: LatencyProfile) {
+        VLCRenderPool.setLatencyProfile(url, profile)
+    }
+
+    /**
+     * 设置上屏画质增强：放大到大窗时轻量锐化、缩小到缩略图时多点/mipmap 抗锯齿，以及可选的亮度、对比度与去隔行。
+     * 配合较低的解码档位使用，可在大屏上保持观感的同时降低解码负载。默认关闭（ImageEnhancement.OFF，纯双线性采样），
+     * 开启后画面会经过额外的着色处理，单窗口的 OES 直出也随之停用。
+     * @param enhancement 增强参数，url 非空时传 null 表示改回使用全局参数
+     * @param url 为 null 时设置全局参数，否则只作用于该地址
+     */
+    @JvmStatic
+    @JvmOverloads
+    fun setImageEnhancement(enhancement: ImageEnhancement?, url: String? = null) {
+        VLCRenderPool.setImageEnhancement(enhancement, url)
+    }
+
+    /**
+     * 设置全局上屏帧率上限（默认 30）。源帧率低于上限时按源帧率上屏，高于上限时按 PTS 均匀抽帧。
+     * @param fps 帧率上限，0 表示不设上限
+     */
+    @JvmStatic
+    fun setMaxRenderFps(fps: Float) {
+        VLCRenderPool.setMaxRenderFps(fps)
+    }
+
+    /**
+     * 设置某一路流的目标上屏帧率，例如将后台监看的流降到 10fps，解码不受影响
+     * @param url 视频流地址
+     * @param fps 目标帧率，0 表示取消限制
+     */
+    @JvmStatic
+    fun setStreamTargetFps(url: String, fps: Float) {
+        VLCRenderPool.setStreamTargetFps(url, fps)
+    }
+
+    /**
+     * 开启合成模式。传入一张置于 StreamWebView 之下、与其等大的原生画布（如 SurfaceView 的 Surface），
+     * 之后新绑定的视频组件不再各自 makeCurrent + swapBuffers，而是作为瓦片按页面布局绘制到这张画布上，
+     * 每轮只交换一次。组件自身的同层画布会被清为透明以透出下方图层。
+     * @param surface 图层画布
+     * @param width 图层物理宽度
+     * @param height 图层物理高度
+     */
+    @JvmStatic
+    fun attachCompositorLayer(surface: Surface, width: Int, height: Int) {
+        VLCRenderPool.attachCompositorLayer(surface, width, height)
+    }
+
+    /**
+     * 图层画布尺寸变化时调用
+     */
+    @JvmStatic
+    fun resizeCompositorLayer(width: Int, height: Int) {
+        VLCRenderPool.resizeCompositorLayer(width, height)
+    }
+
+    /**
+     * 关闭合成模式，在图层画布销毁前调用，瓦片会退回各自的同层画布绘制
+     */
+    @JvmStatic
+    fun detachCompositorLayer() {
+        VLCRenderPool.detachCompositorLayer()
+    }
+
+    /**
+     * 获取引擎运行指标快照：每路流的解码/上屏帧率、拥堵丢帧、纹理锁定/绘制/交换耗时分布、首帧耗时与重试次数，
+     * 以及每个节点的循环耗时与节点间负载失衡度。耗时分布与帧率为自上次采样以来的区间值，适合每秒轮询一次。
+     * 不阻塞调用线程：返回上一次采集完成的快照并在后台发起下一次采集，首次调用时节点数据为空。
+     * @return 指标快照，可通过 toJson() 序列化
+     */
+    @JvmStatic
+    fun getMetrics(): EngineMetrics {
+        return VLCRenderPool.getMetrics()
+    }
+
+    /**
+     * 异步采集一次最新的引擎运行指标，各节点在自己的线程上采样后完成
+     * @return 指标快照的 Future，最多等待节点 100ms
+     */
+    @JvmStatic
+    fun getMetricsAsync(): CompletableFuture<EngineMetrics> {
+        return VLCRenderPool.getMetricsAsync()
+    }
+
+    /**
+     * 开启周期性封面快照。每路流按间隔生成缩小的快照并缓存到内存与磁盘，
+     * 重连或重新进入页面时，在首帧到达前先展示最近一次的画面，代替黑屏。
+     * @param intervalMs 快照间隔（毫秒），传 0 关闭
+     * @param maxWidth 快照最大宽度（默认 320）
+     */
+    @JvmStatic
+    @JvmOverloads
+    fun startSnapshots(intervalMs: Long, maxWidth: Int = 320) {
+        VLCRenderPool.startSnapshots(intervalMs, maxWidth)
+    }
+
+    @JvmStatic
+    fun stopSnapshots() {
+        VLCRenderPool.stopSnapshots()
+    }
+
     /**
      * 软释放：关闭当前工程（或退出当前浏览器页面）时调用。
      * 释放渲染资源，但不销毁 EGL 底层环境，保证下次打开秒播。
@@ -67,9 +362,12 @@ object StreamKit {
     @JvmStatic
     fun releaseAll(context: Context) {
         Log.i("VLCDecoder", "Rel X5 & VLC res...")
+        memoryCallback?.let { context.applicationContext.unregisterComponentCallbacks(it) }
+        memoryCallback = null
         WidgetManager.clearAll()
-        VLCRenderPool.release()
-        VLCEngineManager.release()
+        // 播放器在各自的通道上异步释放，全局引擎要等所有节点确认释放完毕才能销毁
+        val engine = VLCEngineManager.detach()
+        VLCRenderPool.release { engine?.release() }
         KernelManager.release(context)
     }
 
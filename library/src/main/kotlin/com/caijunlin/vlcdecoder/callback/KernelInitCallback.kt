@@ -1,5 +1,7 @@
 package com.caijunlin.vlcdecoder.callback
 
+import com.caijunlin.vlcdecoder.core.WarmUpStage
+
 /**
  * @author : caijunlin
  * @date   : 2026/2/25
@@ -11,4 +13,24 @@ abstract class KernelInitCallback {
 
     abstract fun onFailed(code: Int, msg: String?)
 
-}
\ No newline at end of file
+    /**
+     * 分阶段预热中某一阶段就绪，仅 initAsync 启动时回调，在主线程回调
+     * @param stage 阶段
+     * @param costMs 自 initAsync 调用起到该阶段就绪的耗时
+     */
+    open fun onStageReady(stage: WarmUpStage, costMs: Long) {}
+
+    /**
+     * 分阶段预热中某一阶段失败，在主线程回调；X5 内核失败时 onFailed 同样会回调
+     * @param stage 阶段
+     * @param msg 失败原因
+     */
+    open fun onStageFailed(stage: WarmUpStage, msg: String?) {}
+
+    /**
+     * 全部预热阶段均已结束(无论成败)，在主线程回调
+     * @param totalMs 自 initAsync 调用起的总耗时
+     */
+    open fun onWarmUpFinished(totalMs: Long) {}
+
+}
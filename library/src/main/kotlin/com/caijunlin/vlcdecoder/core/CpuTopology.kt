@@ -0,0 +1,156 @@
+package com.caijunlin.vlcdecoder.core
+
+import android.util.Log
+import org.json.JSONArray
+import org.json.JSONObject
+import java.io.File
+import java.util.concurrent.ExecutorService
+import java.util.concurrent.Executors
+import java.util.concurrent.TimeUnit
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 单个 CPU 核心的拓扑信息
+ * @param index 核心编号
+ * @param capacity 内核调度器给出的相对算力(cpu_capacity，满值 1024)，缺失时以最高频率折算
+ * @param maxFreqKhz 最高主频
+ * @param isBig 是否属于大核簇
+ */
+data class CpuCore(
+    val index: Int,
+    val capacity: Int,
+    val maxFreqKhz: Long,
+    val isBig: Boolean
+) {
+    fun toJson(): JSONObject = JSONObject()
+        .put("cpu", index)
+        .put("capacity", capacity)
+        .put("maxFreqKhz", maxFreqKhz)
+        .put("big", isBig)
+}
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 通过 sysfs 探测 big.LITTLE 拓扑。优先读取 cpu_capacity，缺失时退回 cpufreq 的最高主频，
+ * 算力不低于最强核心 80% 的核心归为大核。同构 CPU 上所有核心都视为大核。
+ * 线程绑核借助系统自带的 toybox taskset 完成，同一进程内的线程无需额外权限；失败时静默退回由内核调度。
+ */
+object CpuTopology {
+
+    /** 归为大核的算力阈值(相对最强核心) */
+    private const val BIG_CORE_RATIO = 0.8f
+
+    private const val CPU_ROOT = "/sys/devices/system/cpu"
+
+    /** taskset 需要拉起子进程，放到独立线程执行，不阻塞调用方与渲染线程 */
+    private val affinityExecutor: ExecutorService = Executors.newSingleThreadExecutor { r ->
+        Thread(r, "VlcAffinity").apply { priority = Thread.MIN_PRIORITY }
+    }
+
+    val cores: List<CpuCore> by lazy { probe() }
+
+    /** 大核编号，算力从高到低 */
+    val bigCores: List<Int> by lazy {
+        cores.filter { it.isBig }.sortedByDescending { it.capacity }.map { it.index }
+    }
+
+    val littleCores: List<Int> by lazy { cores.filter { !it.isBig }.map { it.index } }
+
+    /** 是否为大小核异构 CPU */
+    val isHeterogeneous: Boolean get() = littleCores.isNotEmpty() && bigCores.isNotEmpty()
+
+    fun isBigCore(cpu: Int): Boolean = cores.firstOrNull { it.index == cpu }?.isBig ?: true
+
+    private fun probe(): List<CpuCore> {
+        val count = Runtime.getRuntime().availableProcessors()
+        val raw = ArrayList<Triple<Int, Int, Long>>()
+        val dirs = File(CPU_ROOT).listFiles { file -> file.name.matches(Regex("cpu\\d+")) }
+        val indices = dirs?.map { it.name.removePrefix("cpu").toInt() }?.sorted() ?: (0 until count).toList()
+        indices.forEach { cpu ->
+            val capacity = readLong("$CPU_ROOT/cpu$cpu/cpu_capacity")?.toInt() ?: 0
+            val freq = readLong("$CPU_ROOT/cpu$cpu/cpufreq/cpuinfo_max_freq") ?: 0L
+            raw.add(Triple(cpu, capacity, freq))
+        }
+        val hasCapacity = raw.any { it.second > 0 }
+        val maxFreq = raw.maxOfOrNull { it.third } ?: 0L
+        val scored = raw.map { (cpu, capacity, freq) ->
+            val score = when {
+                hasCapacity -> capacity
+                maxFreq > 0L -> (freq * 1024L / maxFreq).toInt()
+                else -> 1024
+            }
+            Triple(cpu, score, freq)
+        }
+        val best = scored.maxOfOrNull { it.second }?.coerceAtLeast(1) ?: 1
+        val result = scored.map { (cpu, score, freq) ->
+            CpuCore(cpu, score, freq, score >= best * BIG_CORE_RATIO)
+        }
+        Log.i("VLCDecoder", "CPU topology: big ${result.filter { it.isBig }.map { it.index }} little ${result.filter { !it.isBig }.map { it.index }}")
+        return result
+    }
+
+    private fun readLong(path: String): Long? {
+        return try {
+            File(path).readText().trim().toLongOrNull()
+        } catch (e: Exception) {
+            null
+        }
+    }
+
+    /**
+     * 读取线程当前所在的核心，/proc/self/task/<tid>/stat 的第 39 个字段
+     * @return 读取失败时返回 -1
+     */
+    fun currentCpuOf(tid: Int): Int {
+        return try {
+            val stat = File("/proc/self/task/$tid/stat").readText()
+            // 第 2 个字段是带括号的线程名，可能含空格，从右括号之后开始计数
+            val fields = stat.substring(stat.lastIndexOf(')') + 2).split(' ')
+            fields.getOrNull(36)?.toIntOrNull() ?: -1
+        } catch (e: Exception) {
+            -1
+        }
+    }
+
+    /**
+     * 异步把线程绑定到指定核心集合
+     * @param tid 线程号
+     * @param cpus 允许运行的核心，为空时解除限制
+     * @param onResult 绑核结果，在绑核线程回调
+     */
+    fun setAffinity(tid: Int, cpus: List<Int>, onResult: (Boolean) -> Unit = {}) {
+        affinityExecutor.execute { onResult(applyAffinity(tid, cpus)) }
+    }
+
+    private fun applyAffinity(tid: Int, cpus: List<Int>): Boolean {
+        val targets = cpus.ifEmpty { cores.map { it.index } }
+        var mask = 0L
+        targets.forEach { if (it in 0..62) mask = mask or (1L shl it) }
+        if (mask == 0L) return false
+        return try {
+            val process = ProcessBuilder("taskset", "-p", java.lang.Long.toHexString(mask), tid.toString())
+                .redirectErrorStream(true)
+                .start()
+            val finished = process.waitFor(1, TimeUnit.SECONDS)
+            if (!finished) process.destroy()
+            val ok = finished && process.exitValue() == 0
+            if (!ok) Log.w("VLCDecoder", "taskset failed for tid $tid -> $targets")
+            ok
+        } catch (e: Exception) {
+            Log.w("VLCDecoder", "Thread affinity unavailable: ${e.message}")
+            false
+        }
+    }
+
+    fun toJson(): JSONObject {
+        val coresJson = JSONArray()
+        cores.forEach { coresJson.put(it.toJson()) }
+        return JSONObject()
+            .put("heterogeneous", isHeterogeneous)
+            .put("bigCores", JSONArray(bigCores))
+            .put("littleCores", JSONArray(littleCores))
+            .put("cores", coresJson)
+    }
+}
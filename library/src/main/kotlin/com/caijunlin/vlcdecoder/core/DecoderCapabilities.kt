@@ -0,0 +1,156 @@
+package com.caijunlin.vlcdecoder.core
+
+import android.media.MediaCodecInfo
+import android.media.MediaCodecList
+import android.os.Build
+import android.util.Log
+import org.json.JSONObject
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 单个编码格式的硬解能力
+ * @param mime 编码格式，如 video/avc
+ * @param codecName 选中的硬件解码器名称
+ * @param maxInstances 解码器允许同时存在的最大实例数
+ * @param maxMacroblocksPerSecond 按解码器宣称的最高 Level 推算出的每秒宏块吞吐上限
+ */
+data class CodecBudget(
+    val mime: String,
+    val codecName: String,
+    val maxInstances: Int,
+    val maxMacroblocksPerSecond: Long
+) {
+    fun toJson(): JSONObject = JSONObject()
+        .put("mime", mime)
+        .put("codec", codecName)
+        .put("maxInstances", maxInstances)
+        .put("maxMacroblocksPerSecond", maxMacroblocksPerSecond)
+}
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 启动时通过 MediaCodecList 探测 SoC 的硬解能力（H.264 / HEVC），
+ * 供调度池在硬件实例耗尽前主动分配软硬解，而不是等 MediaCodec 创建失败后静默退回单线程软解。
+ */
+object DecoderCapabilities {
+
+    const val MIME_AVC = "video/avc"
+    const val MIME_HEVC = "video/hevc"
+
+    private val probedMimes = listOf(MIME_AVC, MIME_HEVC)
+
+    /** 探测结果，没有硬件解码器的格式不会出现在表中 */
+    val budgets: Map<String, CodecBudget> by lazy { probe() }
+
+    /**
+     * 查询指定格式的硬解能力
+     * @return 无硬件解码器时返回 null
+     */
+    fun budgetOf(mime: String): CodecBudget? = budgets[mime]
+
+    /**
+     * 将 VLC 轨道上报的 fourcc 映射到 MediaCodec 的 mime
+     * @return 无法识别时返回 null
+     */
+    fun mimeOfFourcc(fourcc: String?): String? = when (fourcc?.trim()?.lowercase()) {
+        "h264", "avc1", "avc", "x264" -> MIME_AVC
+        "hevc", "h265", "hev1", "hvc1" -> MIME_HEVC
+        else -> null
+    }
+
+    private fun probe(): Map<String, CodecBudget> {
+        val result = HashMap<String, CodecBudget>()
+        val infos = try {
+            MediaCodecList(MediaCodecList.REGULAR_CODECS).codecInfos
+        } catch (e: Exception) {
+            Log.e("VLCDecoder", "MediaCodecList probe failed: ${e.message}")
+            return result
+        }
+        probedMimes.forEach { mime ->
+            var best: CodecBudget? = null
+            infos.forEach { info ->
+                if (info.isEncoder || !isHardware(info)) return@forEach
+                if (info.supportedTypes.none { it.equals(mime, ignoreCase = true) }) return@forEach
+                val caps = try {
+                    info.getCapabilitiesForType(mime)
+                } catch (e: Exception) {
+                    return@forEach
+                }
+                val budget = CodecBudget(mime, info.name, caps.maxSupportedInstances, maxMacroblockRate(mime, caps))
+                if (best == null || budget.maxMacroblocksPerSecond > best!!.maxMacroblocksPerSecond) best = budget
+            }
+            best?.let {
+                result[mime] = it
+                Log.i("VLCDecoder", "HW decoder ${it.codecName} $mime x${it.maxInstances} ${it.maxMacroblocksPerSecond} MB/s")
+            }
+        }
+        return result
+    }
+
+    private fun isHardware(info: MediaCodecInfo): Boolean {
+        if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.Q) return info.isHardwareAccelerated
+        val name = info.name.lowercase()
+        return !name.startsWith("omx.google.") && !name.startsWith("c2.android.") && !name.contains(".sw.")
+    }
+
+    /**
+     * 以解码器宣称的最高 Level 查表得到宏块吞吐，表中没有的 Level 退回按最大尺寸与帧率估算
+     */
+    private fun maxMacroblockRate(mime: String, caps: MediaCodecInfo.CodecCapabilities): Long {
+        var maxLevel = 0
+        caps.profileLevels.forEach { if (it.level > maxLevel) maxLevel = it.level }
+        val fromLevel = when (mime) {
+            MIME_AVC -> avcLevelMacroblocks(maxLevel)
+            MIME_HEVC -> hevcLevelMacroblocks(maxLevel)
+            else -> 0L
+        }
+        if (fromLevel > 0L) return fromLevel
+        val video = caps.videoCapabilities ?: return 0L
+        val width = video.supportedWidths.upper
+        val height = video.supportedHeights.upper
+        val fps = video.getSupportedFrameRatesFor(width, height).upper
+        return ((width + 15) / 16).toLong() * ((height + 15) / 16) * fps.toLong()
+    }
+
+    /** H.264 附录 A 表 A-1 的 MaxMBPS */
+    private fun avcLevelMacroblocks(level: Int): Long = when {
+        level >= MediaCodecInfo.CodecProfileLevel.AVCLevel62 -> 16_711_680L
+        level >= MediaCodecInfo.CodecProfileLevel.AVCLevel61 -> 8_355_840L
+        level >= MediaCodecInfo.CodecProfileLevel.AVCLevel6 -> 4_177_920L
+        level >= MediaCodecInfo.CodecProfileLevel.AVCLevel52 -> 2_073_600L
+        level >= MediaCodecInfo.CodecProfileLevel.AVCLevel51 -> 983_040L
+        level >= MediaCodecInfo.CodecProfileLevel.AVCLevel5 -> 589_824L
+        level >= MediaCodecInfo.CodecProfileLevel.AVCLevel42 -> 522_240L
+        level >= MediaCodecInfo.CodecProfileLevel.AVCLevel4 -> 245_760L
+        level >= MediaCodecInfo.CodecProfileLevel.AVCLevel32 -> 216_000L
+        level >= MediaCodecInfo.CodecProfileLevel.AVCLevel31 -> 108_000L
+        level > 0 -> 40_500L
+        else -> 0L
+    }
+
+    /** HEVC 附录 A 表 A-8 的 MaxLumaSr 换算为 16x16 宏块 */
+    private fun hevcLevelMacroblocks(level: Int): Long {
+        val lumaSamplesPerSecond = when {
+            level >= MediaCodecInfo.CodecProfileLevel.HEVCMainTierLevel62 -> 4_278_190_080L
+            level >= MediaCodecInfo.CodecProfileLevel.HEVCMainTierLevel61 -> 2_139_095_040L
+            level >= MediaCodecInfo.CodecProfileLevel.HEVCMainTierLevel6 -> 1_069_547_520L
+            level >= MediaCodecInfo.CodecProfileLevel.HEVCMainTierLevel52 -> 1_069_547_520L
+            level >= MediaCodecInfo.CodecProfileLevel.HEVCMainTierLevel51 -> 534_773_760L
+            level >= MediaCodecInfo.CodecProfileLevel.HEVCMainTierLevel5 -> 267_386_880L
+            level >= MediaCodecInfo.CodecProfileLevel.HEVCMainTierLevel41 -> 133_693_440L
+            level >= MediaCodecInfo.CodecProfileLevel.HEVCMainTierLevel4 -> 66_846_720L
+            level >= MediaCodecInfo.CodecProfileLevel.HEVCMainTierLevel31 -> 33_177_600L
+            level > 0 -> 16_588_800L
+            else -> 0L
+        }
+        return lumaSamplesPerSecond / 256
+    }
+
+    fun toJson(): JSONObject {
+        val json = JSONObject()
+        budgets.values.forEach { json.put(it.mime, it.toJson()) }
+        return json
+    }
+}
@@ -18,14 +18,17 @@ import java.io.FileOutputStream
  */
 object KernelManager {
 
-    // 内部缓存初始化状态，解决时序和粘性事件问题
+    // 内部缓存初始化状态，解决时序和粘性事件问题；异步安装时结果在后台线程写入
+    @Volatile
     private var isFinished = false
+    @Volatile
     private var isSuccess = false
     private var cachedIsX5Core = false
     private var cachedErrCode = 0
     private var cachedErrMsg: String? = null
 
     // 存储当前注册的回调
+    @Volatile
     private var callback: KernelInitCallback? = null
 
     @Volatile
@@ -35,6 +38,7 @@ object KernelManager {
      * 注册监听回调。
      * 如果注册时内核已经初始化完毕，会立刻将缓存的结果回调出去，解决时序差问题。
      */
+    @Synchronized
     fun registerCallback(callback: KernelInitCallback) {
         // 如果已经执行结束，立即分发缓存的结果
         if (isFinished) {
@@ -49,9 +53,10 @@ object KernelManager {
 
     /**
      * 初始化内核入口
+     * @param async 为 true 时在后台线程完成内核拷贝与安装，调用线程立即返回
      */
     @Synchronized
-    fun initKernel(context: Context, authCode: String, needAutoSaveLicense: Boolean) {
+    fun initKernel(context: Context, authCode: String, needAutoSaveLicense: Boolean, async: Boolean = false) {
         if (onload) {
             return
         }
@@ -64,7 +69,19 @@ object KernelManager {
         // 重置状态
         isFinished = false
         isSuccess = false
-        installX5SelfHosted(context, authCode, needAutoSaveLicense)
+        if (!async) {
+            installX5SelfHosted(context, authCode, needAutoSaveLicense)
+            return
+        }
+        // 首次安装需要从 assets 拷贝数十 MB 的内核文件，放到后台线程避免阻塞启动
+        Thread({
+            try {
+                installX5SelfHosted(context, authCode, needAutoSaveLicense)
+            } catch (e: Exception) {
+                Log.e("VLCDecoder", "Inst fail: ${e.message}")
+                dispatchFailed(-1, e.message)
+            }
+        }, "VlcWarmUp-Kernel").start()
     }
 
     /**
@@ -154,22 +171,26 @@ object KernelManager {
     /**
      * 统一处理成功状态并分发
      */
+    @Synchronized
     private fun dispatchSuccess(isX5Core: Boolean) {
         isFinished = true
         isSuccess = true
         cachedIsX5Core = isX5Core
         callback?.onSuccess(isX5Core)
+        StartupWarmUp.onKernelFinished(null)
     }
 
     /**
      * 统一处理失败状态并分发
      */
+    @Synchronized
     private fun dispatchFailed(code: Int, msg: String?) {
         isFinished = true
         isSuccess = false
         cachedErrCode = code
         cachedErrMsg = msg
         callback?.onFailed(code, msg)
+        StartupWarmUp.onKernelFinished(msg ?: "code $code")
     }
 
     /**
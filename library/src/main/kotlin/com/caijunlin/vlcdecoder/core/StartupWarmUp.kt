@@ -0,0 +1,139 @@
+package com.caijunlin.vlcdecoder.core
+
+import android.content.Context
+import android.os.Handler
+import android.os.Looper
+import android.os.SystemClock
+import android.util.Log
+import com.caijunlin.vlcdecoder.callback.KernelInitCallback
+import com.caijunlin.vlcdecoder.gles.VLCRenderPool
+import java.util.EnumMap
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 分阶段启动预热的阶段
+ */
+enum class WarmUpStage {
+    /** X5 内核安装、授权与 WebView 初始化 */
+    KERNEL,
+
+    /** LibVLC 实例创建与硬解能力探测 */
+    ENGINE,
+
+    /** 全部渲染节点的线程、EGL 上下文与着色器变体 */
+    RENDER
+}
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 冷启动分阶段并行预热。X5 内核的安装/授权、LibVLC 的创建、渲染节点的 EGL 与着色器初始化三者互不依赖，
+ * 分别在后台线程同时进行，调用线程立即返回；各阶段的就绪与失败经 KernelInitCallback 在主线程回调，
+ * 晚注册的回调会补发已结束的阶段。整体耗时约等于最慢的一个阶段，而不是三者之和。
+ */
+object StartupWarmUp {
+
+    private val mainHandler = Handler(Looper.getMainLooper())
+
+    /** 已就绪阶段的耗时，失败阶段记为负数 */
+    private val stageCosts = EnumMap<WarmUpStage, Long>(WarmUpStage::class.java)
+    private val stageErrors = EnumMap<WarmUpStage, String?>(WarmUpStage::class.java)
+
+    private var isStarted = false
+    private var startMs = 0L
+    private var totalMs = -1L
+
+    private var callback: KernelInitCallback? = null
+
+    /** 是否由 start 发起过预热 */
+    val isActive: Boolean
+        @Synchronized get() = isStarted
+
+    /**
+     * 注册阶段回调，已结束的阶段会立即补发
+     */
+    @Synchronized
+    fun registerCallback(callback: KernelInitCallback) {
+        this.callback = callback
+        stageCosts.forEach { (stage, costMs) ->
+            if (costMs >= 0L) {
+                mainHandler.post { callback.onStageReady(stage, costMs) }
+            } else {
+                val msg = stageErrors[stage]
+                mainHandler.post { callback.onStageFailed(stage, msg) }
+            }
+        }
+        val total = totalMs
+        if (total >= 0L) mainHandler.post { callback.onWarmUpFinished(total) }
+    }
+
+    /**
+     * 并行启动三个预热阶段，重复调用无效。须在 VLCRenderPool.model 设定之后调用
+     * @param context 应用上下文
+     * @param authCode X5 授权码
+     * @param needAutoSaveLicense 是否自动缓存授权
+     */
+    fun start(context: Context, authCode: String, needAutoSaveLicense: Boolean) {
+        synchronized(this) {
+            if (isStarted) return
+            isStarted = true
+            startMs = SystemClock.elapsedRealtime()
+        }
+        val appContext = context.applicationContext
+        // 内核结果由 KernelManager 的分发回调到 onKernelFinished
+        KernelManager.initKernel(appContext, authCode, needAutoSaveLicense, async = true)
+        Thread({
+            try {
+                VLCEngineManager.init(appContext)
+                onStageFinished(WarmUpStage.ENGINE, null)
+            } catch (e: Throwable) {
+                Log.e("VLCDecoder", "Engine warm-up failed", e)
+                onStageFinished(WarmUpStage.ENGINE, e.message ?: e.javaClass.simpleName)
+            }
+        }, "VlcWarmUp-Engine").start()
+        Thread({
+            try {
+                VLCRenderPool.warmUpNodes { onStageFinished(WarmUpStage.RENDER, null) }
+            } catch (e: Throwable) {
+                Log.e("VLCDecoder", "Render warm-up failed", e)
+                onStageFinished(WarmUpStage.RENDER, e.message ?: e.javaClass.simpleName)
+            }
+        }, "VlcWarmUp-Render").start()
+    }
+
+    /**
+     * X5 内核初始化结束，由 KernelManager 在分发结果时调用
+     */
+    internal fun onKernelFinished(error: String?) {
+        if (!isActive) return
+        onStageFinished(WarmUpStage.KERNEL, error)
+    }
+
+    private fun onStageFinished(stage: WarmUpStage, error: String?) {
+        val target: KernelInitCallback?
+        val costMs: Long
+        var finishedMs = -1L
+        synchronized(this) {
+            if (stageCosts.containsKey(stage)) return
+            costMs = SystemClock.elapsedRealtime() - startMs
+            stageCosts[stage] = if (error == null) costMs else -1L
+            if (error != null) stageErrors[stage] = error
+            if (stageCosts.size == WarmUpStage.entries.size) {
+                totalMs = costMs
+                finishedMs = costMs
+            }
+            target = callback
+        }
+        if (error == null) {
+            Log.i("VLCDecoder", "Warm-up $stage ready in ${costMs}ms")
+        } else {
+            Log.w("VLCDecoder", "Warm-up $stage failed after ${costMs}ms: $error")
+        }
+        target ?: return
+        mainHandler.post {
+            if (error == null) target.onStageReady(stage, costMs) else target.onStageFailed(stage, error)
+            if (finishedMs >= 0L) target.onWarmUpFinished(finishedMs)
+        }
+    }
+}
@@ -6,14 +6,17 @@ import android.util.AttributeSet
 import android.util.Log
 import android.view.MotionEvent
 import android.webkit.JavascriptInterface
+import com.caijunlin.vlcdecoder.gles.LayoutEntry
 import com.caijunlin.vlcdecoder.gles.VLCRenderPool
 import com.caijunlin.vlcdecoder.widget.VLCVideoSurface
+import com.caijunlin.vlcdecoder.widget.WidgetManager
 import com.tencent.smtt.export.external.embeddedwidget.interfaces.IEmbeddedWidget
 import com.tencent.smtt.export.external.embeddedwidget.interfaces.IEmbeddedWidgetClient
 import com.tencent.smtt.export.external.embeddedwidget.interfaces.IEmbeddedWidgetClientFactory
 import com.tencent.smtt.sdk.CookieManager
 import com.tencent.smtt.sdk.QbSdk
 import com.tencent.smtt.sdk.WebView
+import org.json.JSONArray
 
 /**
  * @author : caijunlin
@@ -48,6 +51,27 @@ class StreamWebView : WebView, IEmbeddedWidgetClientFactory {
             view.overScrollMode = if (value) OVER_SCROLL_ALWAYS else OVER_SCROLL_NEVER
         }
 
+    /**
+     * 在主线程把前端下发的布局映射到组件上，并作为一个事务提交给调度池
+     */
+    private fun dispatchLayout(items: JSONArray) {
+        val widgets = ArrayList<VLCVideoSurface>()
+        val entries = ArrayList<LayoutEntry>()
+        for (i in 0 until items.length()) {
+            val item = items.optJSONObject(i) ?: continue
+            val widget = WidgetManager.getWidget(item.optString("id")) ?: continue
+            val widthDp = if (item.has("width")) item.optDouble("width").toFloat() else null
+            val heightDp = if (item.has("height")) item.optDouble("height").toFloat() else null
+            val entry = widget.prepareLayout(item.optString("src"), widthDp, heightDp) ?: continue
+            widgets.add(widget)
+            entries.add(entry)
+        }
+        if (entries.isEmpty()) return
+        VLCRenderPool.applyLayout(entries).thenAccept { results ->
+            results.forEachIndexed { index, result -> widgets[index].onBindResult(result) }
+        }
+    }
+
     /**
      * 统一的初始化入口，确保在 widgetTag 被赋值之后才执行
      */
@@ -61,6 +85,34 @@ class StreamWebView : WebView, IEmbeddedWidgetClientFactory {
             fun printVLCDiagnostics() {
                 VLCRenderPool.printDiagnostics()
             }
+
+            @JavascriptInterface
+            fun getVLCMetrics(): String {
+                return VLCRenderPool.getMetrics().toJson().toString()
+            }
+
+            /**
+             * 页面整体切换布局，参数为 [{"id":"v1","src":"rtsp://...","width":320,"height":180}]，
+             * width/height 为 CSS 尺寸，可省略；未出现在列表中的组件保持原状
+             */
+            @JavascriptInterface
+            fun applyLayout(json: String) {
+                val items = try {
+                    JSONArray(json)
+                } catch (e: Exception) {
+                    Log.e("VLCDecoder", "applyLayout invalid json: ${e.message}")
+                    return
+                }
+                post { dispatchLayout(items) }
+            }
+
+            /**
+             * 页面弹出或关闭浮层(弹窗、菜单等)时调用，浮层期间拖拽投放的命中测试交给 DOM 判定层叠顺序
+             */
+            @JavascriptInterface
+            fun setOverlayActive(active: Boolean) {
+                post { WidgetManager.setOverlayActive(this@StreamWebView, active) }
+            }
         }, "VLCBridge")
 
         initWebSettings()
@@ -1,7 +1,9 @@
 package com.caijunlin.vlcdecoder.core
 
 import android.content.Context
+import android.util.Log
 import org.videolan.libvlc.LibVLC
+import java.util.concurrent.ConcurrentHashMap
 
 /**
  * @author caijunlin
@@ -36,6 +38,59 @@ object VLCEngineManager {
     var libVLC: LibVLC? = null
         private set
 
+    private var appContext: Context? = null
+    private var sharedArgs: ArrayList<String> = defaultVlcArgs
+
+    /** 是否为每个渲染节点创建独立的 LibVLC 实例 */
+    @Volatile
+    var isShardedPerNode = false
+        private set
+
+    /** 节点独立实例，键为节点序号，首路流拉流时按需创建 */
+    private val nodeEngines = ConcurrentHashMap<Int, LibVLC>()
+
+    /** 节点专属的启动参数，未配置的节点沿用全局参数 */
+    private val nodeArgs = ConcurrentHashMap<Int, ArrayList<String>>()
+
+    /**
+     * 开启或关闭按节点分片的引擎实例。分片后各节点的播放器不再争抢同一个 LibVLC 的内部锁与输入/解码线程，
+     * 一路重负载的流也不会拖慢其他节点。对之后新建的播放器生效，已创建的实例在 releaseAll 时统一销毁。
+     * @param enabled 是否分片
+     * @param argsByNode 节点序号 → 该节点专属的启动参数，例如缩略图节点使用更大的 network-caching
+     */
+    fun setShardedPerNode(enabled: Boolean, argsByNode: Map<Int, List<String>> = emptyMap()) {
+        isShardedPerNode = enabled
+        nodeArgs.clear()
+        argsByNode.forEach { (index, args) -> nodeArgs[index] = ArrayList(args) }
+    }
+
+    /**
+     * 获取指定节点应使用的引擎实例
+     * @param nodeIndex 节点序号，负数表示使用全局实例
+     * @return 未初始化时返回 null
+     */
+    fun engineFor(nodeIndex: Int): LibVLC? {
+        val shared = libVLC ?: return null
+        if (!isShardedPerNode || nodeIndex < 0) return shared
+        nodeEngines[nodeIndex]?.let { return it }
+        synchronized(this) {
+            nodeEngines[nodeIndex]?.let { return it }
+            val context = appContext ?: return shared
+            val engine = LibVLC(context, nodeArgs[nodeIndex] ?: sharedArgs)
+            nodeEngines[nodeIndex] = engine
+            Log.i("VLCDecoder", "Created LibVLC instance for node-$nodeIndex")
+            return engine
+        }
+    }
+
+    /**
+     * 销毁节点独立实例，必须在该节点的全部播放器释放之后、且在节点线程上调用
+     * @param nodeIndex 节点序号
+     */
+    fun releaseNodeEngine(nodeIndex: Int) {
+        nodeEngines.remove(nodeIndex)?.release()
+    }
+
     /**
      * 初始化全局解析引擎实体并装载缺省底层优化参数
      */
@@ -44,17 +99,33 @@ object VLCEngineManager {
         if (libVLC == null) {
             synchronized(this) {
                 if (libVLC == null) {
+                    appContext = context.applicationContext
+                    sharedArgs = args
                     libVLC = LibVLC(context.applicationContext, args)
+                    // 提前完成硬解能力探测，避免首路流在渲染线程上同步查询 MediaCodecList
+                    DecoderCapabilities.budgets
                 }
             }
         }
     }
 
     /**
-     * 销毁 VLC 引擎实例，释放底层 C++ 内存
+     * 摘下全局引擎实例，之后的 init 会重新创建。摘下的实例仍被在途的播放器引用，
+     * 须等基于它创建的播放器全部释放后再调用其 release
+     * @return 摘下的实例，未初始化时返回 null
      */
-    fun release() {
-        libVLC?.release()
+    @Synchronized
+    fun detach(): LibVLC? {
+        val engine = libVLC
         libVLC = null
+        return engine
+    }
+
+    /**
+     * 销毁全局 VLC 引擎实例，释放底层 C++ 内存；节点独立实例由各节点线程在销毁时自行释放。
+     * 仅在确认没有在途播放器时调用，渲染节点仍在运行时应改用 detach 并等节点销毁完成
+     */
+    fun release() {
+        detach()?.release()
     }
 }
\ No newline at end of file
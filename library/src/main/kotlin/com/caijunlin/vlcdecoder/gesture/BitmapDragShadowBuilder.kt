@@ -21,7 +21,15 @@ class BitmapDragShadowBuilder(
         outTouchPoint.set(touchPointX, touchPointY)
     }
 
+    /** 软件画布无法直接绘制 HARDWARE 位图，此时才懒加载一份软件副本 */
+    private var softwareCopy: Bitmap? = null
+
     override fun onDrawShadow(canvas: Canvas) {
+        if (bitmap.config == Bitmap.Config.HARDWARE && !canvas.isHardwareAccelerated) {
+            val copy = softwareCopy ?: bitmap.copy(Bitmap.Config.ARGB_8888, false).also { softwareCopy = it }
+            if (copy != null) canvas.drawBitmap(copy, 0f, 0f, null)
+            return
+        }
         canvas.drawBitmap(bitmap, 0f, 0f, null)
     }
 
@@ -9,13 +9,14 @@ import androidx.core.graphics.scale
 import com.caijunlin.vlcdecoder.core.StreamWebView
 import com.caijunlin.vlcdecoder.gles.IVideoRenderClient
 import com.caijunlin.vlcdecoder.gles.VLCRenderPool
+import com.caijunlin.vlcdecoder.gles.awaitResult
 import com.caijunlin.vlcdecoder.widget.WidgetManager
 import kotlinx.coroutines.CompletableDeferred
-import kotlinx.coroutines.Dispatchers
 import kotlinx.coroutines.Job
 import kotlinx.coroutines.async
 import kotlinx.coroutines.delay
 import kotlinx.coroutines.launch
+import kotlinx.coroutines.withTimeoutOrNull
 import kotlin.math.abs
 
 /**
@@ -71,10 +72,23 @@ class VideoGestureHelper(
                         }
                     }
 
-                    // 使用 async 将阻塞式的同步截帧丢到 IO 线程池并发执行！
-                    // 这样即使 CountDownLatch 阻塞了，也只是阻塞后台的 IO 线程，绝对不卡主线程 UI
-                    val deferredBitmap = async(Dispatchers.IO) {
-                        VLCRenderPool.captureClientFrameSync(client)
+                    // 异步截帧在节点线程完成，这里只是挂起等待，不占用任何线程
+                    // 拿到 DOM 尺寸后直接按阴影尺寸截帧，由 GPU 完成缩放，省掉后续的整帧缩放拷贝
+                    val deferredBitmap = async {
+                        val targetRect = try {
+                            deferredRect.await()
+                        } catch (_: Exception) {
+                            null
+                        }
+                        val capture = VLCRenderPool.captureClientFrameHardwareAsync(
+                            client,
+                            targetRect?.physicalW ?: 0,
+                            targetRect?.physicalH ?: 0
+                        )
+                        val bitmap = withTimeoutOrNull(200L) { capture.awaitResult() }
+                        // 超时后才完成的截帧没人接收，到达时直接回收
+                        if (bitmap == null) capture.thenAccept { it?.recycle() }
+                        bitmap
                     }
 
                     delay(400)
@@ -131,8 +145,11 @@ class VideoGestureHelper(
         width: Int,
         height: Int
     ) {
-        val scaledBitmap = bitmap.scale(width, height)
-        bitmap.recycle()
+        val scaledBitmap = if (bitmap.width == width && bitmap.height == height) {
+            bitmap
+        } else {
+            bitmap.scale(width, height).also { bitmap.recycle() }
+        }
         val shadowBuilder = BitmapDragShadowBuilder(scaledBitmap, touchX.toInt(), touchY.toInt())
         val sessionState = DragSessionState(
             width = width,
@@ -0,0 +1,314 @@
+package com.caijunlin.vlcdecoder.gles
+
+import androidx.annotation.Keep
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 绑定的业务优先级，预算不足时低优先级的流先被降档、再被抢占
+ */
+@Keep
+enum class StreamPriority {
+    /** 后台缩略图、列表预览 */
+    THUMBNAIL,
+
+    /** 普通可见画面 */
+    VISIBLE,
+
+    /** 聚焦的大窗，永远最后被牺牲 */
+    FOCUSED;
+
+    companion object {
+        /**
+         * 解析前端标签属性，无法识别时按普通可见处理
+         */
+        @JvmStatic
+        fun fromAttribute(value: String?): StreamPriority = when (value?.trim()?.lowercase()) {
+            "thumbnail", "low" -> THUMBNAIL
+            "focused", "focus", "high" -> FOCUSED
+            else -> VISIBLE
+        }
+    }
+}
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 准入控制对客户端的处置结果
+ */
+enum class AdmissionState {
+    /** 以请求的档位正常解码（含降档后恢复） */
+    ADMITTED,
+
+    /** 为腾出预算被限制在低档位解码 */
+    DOWNGRADED,
+
+    /** 被更高优先级的流抢占，已解绑 */
+    PREEMPTED,
+
+    /** 预算不足且无可牺牲的低优先级流，绑定被拒绝 */
+    REJECTED
+}
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 全局解码准入控制器。预算以 解码像素/秒 计，而非流的路数，
+ * 使 16 路缩略图与 4 路 1080p 大窗能按真实硬解负载共用同一份额度，且额度在所有节点之间全局共享。
+ * 除解码吞吐外还同时校验显存预算：已占用的显存以 GpuMemoryBudget 记账的在用缓冲为准，只有待准入的新流按档位估算。
+ * 失去全部客户端、仍在节点闲置缓存里的流继续占用额度，新流超出任一预算时依次：
+ * 回收闲置流 → 降档更低优先级的流 → 抢占更低优先级的流 → 降档新流自身 → 拒绝。
+ * 所有方法线程安全，只做记账与决策，真正的解绑/降档由调度池投递到节点执行。
+ */
+class AdmissionController {
+
+    /** 全局解码预算(像素/秒) */
+    @Volatile
+    var budgetPixelsPerSecond = DEFAULT_BUDGET
+
+    /** 全局并发解码路数上限 */
+    @Volatile
+    var maxStreams = 16
+
+    /** 源帧率未知时用于估算开销的帧率 */
+    @Volatile
+    var assumedFps = DEFAULT_ASSUMED_FPS
+
+    /** 闲置流是否继续解码，暂停解码的闲置流只占显存与路数，不占解码预算 */
+    @Volatile
+    var idleKeepsDecoding = true
+
+    private class Entry(val url: String) {
+        val clients = HashMap<IVideoRenderClient, StreamPriority>()
+        var requestedTier = ResolutionTier.P360
+        var cap: ResolutionTier? = null
+
+        val priority: StreamPriority
+            get() = clients.values.maxOrNull() ?: StreamPriority.THUMBNAIL
+
+        /** 已没有客户端，流停留在节点的闲置缓存中 */
+        val isIdle: Boolean
+            get() = clients.isEmpty()
+
+        val effectiveTier: ResolutionTier
+            get() = cap?.takeIf { it.ordinal < requestedTier.ordinal } ?: requestedTier
+    }
+
+    /**
+     * 一次准入决策
+     * @param state 请求方的处置结果（ADMITTED / DOWNGRADED / REJECTED）
+     * @param tierCaps 需要下发到节点的档位上限变化，null 表示解除限制
+     * @param preempted 被整路抢占的流地址及其客户端
+     * @param reclaimed 为腾出额度需要立即释放的闲置流
+     */
+    class Decision(
+        val state: AdmissionState,
+        val tierCaps: List<Pair<String, ResolutionTier?>> = emptyList(),
+        val preempted: List<Pair<String, List<IVideoRenderClient>>> = emptyList(),
+        val reclaimed: List<String> = emptyList()
+    )
+
+    private val entries = LinkedHashMap<String, Entry>()
+
+    /**
+     * 请求准入一个绑定
+     * @param url 视频流地址
+     * @param client 发起绑定的客户端
+     * @param tier 按画布尺寸计算出的期望档位
+     */
+    @Synchronized
+    fun admit(url: String, client: IVideoRenderClient, tier: ResolutionTier): Decision {
+        val priority = client.getPriority()
+        val existing = entries[url]
+        if (existing != null) {
+            existing.clients[client] = priority
+            // 共享流只在额度允许时升档，否则维持现有档位
+            if (tier.ordinal > existing.requestedTier.ordinal) {
+                val delta = cost(tier) - cost(existing.effectiveTier)
+                val deltaBytes = bytes(tier) - bytes(existing.effectiveTier)
+                if (usedLocked() + delta <= budgetPixelsPerSecond && fitsGpu(deltaBytes)) {
+                    existing.requestedTier = tier
+                }
+            }
+            return Decision(if (existing.cap != null) AdmissionState.DOWNGRADED else AdmissionState.ADMITTED)
+        }
+
+        val entry = Entry(url).apply {
+            clients[client] = priority
+            requestedTier = tier
+        }
+        if (fitsAfter(tier, 0L, 0L, 0)) {
+            entries[url] = entry
+            return Decision(AdmissionState.ADMITTED)
+        }
+
+        // 0. 闲置流没有观众，无论请求方优先级如何都最先让出，按闲置先后回收
+        val reclaimed = ArrayList<Entry>()
+        var freed = 0L
+        var freedBytes = 0L
+        var released = 0
+        for (idle in entries.values) {
+            if (fitsAfter(tier, freed, freedBytes, released)) break
+            if (!idle.isIdle) continue
+            freed += costOf(idle)
+            freedBytes += bytes(idle.effectiveTier)
+            reclaimed.add(idle)
+            released++
+        }
+
+        val victims = entries.values.filter { !it.isIdle && it.priority < priority }
+            .sortedWith(compareBy<Entry> { it.priority }.thenByDescending { cost(it.effectiveTier) })
+
+        // 1. 降档低优先级的流
+        val caps = ArrayList<Pair<String, ResolutionTier?>>()
+        for (victim in victims) {
+            if (fitsAfter(tier, freed, freedBytes, released)) break
+            val current = victim.effectiveTier
+            if (current.ordinal <= DOWNGRADE_TIER.ordinal) continue
+            freed += cost(current) - cost(DOWNGRADE_TIER)
+            freedBytes += bytes(current) - bytes(DOWNGRADE_TIER)
+            caps.add(Pair(victim.url, DOWNGRADE_TIER))
+        }
+
+        // 2. 仍然不够则从最低优先级开始整路抢占
+        val preempted = ArrayList<Entry>()
+        for (victim in victims) {
+            if (fitsAfter(tier, freed, freedBytes, released)) break
+            val downgraded = caps.any { it.first == victim.url }
+            freed += if (downgraded) cost(DOWNGRADE_TIER) else cost(victim.effectiveTier)
+            freedBytes += if (downgraded) bytes(DOWNGRADE_TIER) else bytes(victim.effectiveTier)
+            caps.removeAll { it.first == victim.url }
+            preempted.add(victim)
+            released++
+        }
+
+        var state = AdmissionState.ADMITTED
+        if (!fitsAfter(tier, freed, freedBytes, released)) {
+            // 3. 牺牲新流自身的清晰度
+            if (tier.ordinal > DOWNGRADE_TIER.ordinal && fitsAfter(DOWNGRADE_TIER, freed, freedBytes, released)) {
+                entry.cap = DOWNGRADE_TIER
+                state = AdmissionState.DOWNGRADED
+            } else {
+                return Decision(AdmissionState.REJECTED)
+            }
+        }
+
+        caps.forEach { (victimUrl, cap) -> entries[victimUrl]?.cap = cap }
+        preempted.forEach { entries.remove(it.url) }
+        reclaimed.forEach { entries.remove(it.url) }
+        entries[url] = entry
+        val tierCaps = ArrayList(caps)
+        entry.cap?.let { tierCaps.add(Pair(url, it)) }
+        return Decision(
+            state, tierCaps, preempted.map { Pair(it.url, it.clients.keys.toList()) }, reclaimed.map { it.url }
+        )
+    }
+
+    /**
+     * 客户端解绑。流失去全部客户端时，若会进入节点的闲置缓存则保留为闲置条目继续占用额度，
+     * 直到节点上报下线或被新流回收；否则立即归还额度
+     * @param retainIdle 流是否会在节点上闲置保活
+     * @return 因额度归还而解除降档的流
+     */
+    @Synchronized
+    fun release(url: String, client: IVideoRenderClient, retainIdle: Boolean = false): List<String> {
+        val entry = entries[url] ?: return emptyList()
+        entry.clients.remove(client)
+        if (entry.clients.isEmpty() && !retainIdle) entries.remove(url)
+        return restoreCapsLocked()
+    }
+
+    /**
+     * 流已下线（重试耗尽或闲置到期），整路归还额度
+     * @return 因额度归还而解除降档的流
+     */
+    @Synchronized
+    fun releaseStream(url: String): List<String> {
+        entries.remove(url) ?: return emptyList()
+        return restoreCapsLocked()
+    }
+
+    /**
+     * 更新客户端优先级，例如聚焦切换
+     * @return 因优先级变化而解除降档的流
+     */
+    @Synchronized
+    fun updatePriority(url: String, client: IVideoRenderClient, priority: StreamPriority): List<String> {
+        val entry = entries[url] ?: return emptyList()
+        if (!entry.clients.containsKey(client)) return emptyList()
+        entry.clients[client] = priority
+        return restoreCapsLocked()
+    }
+
+    /** 流当前的档位上限，未降档时返回 null */
+    @Synchronized
+    fun tierCapOf(url: String): ResolutionTier? = entries[url]?.cap
+
+    /** 订阅该流的全部客户端 */
+    @Synchronized
+    fun clientsOf(url: String): List<IVideoRenderClient> = entries[url]?.clients?.keys?.toList() ?: emptyList()
+
+    /** 当前已占用的预算(像素/秒) */
+    @Synchronized
+    fun usedPixelsPerSecond(): Long = usedLocked()
+
+    /** 各节点实际在用的显存(字节) */
+    fun usedGpuBytes(): Long = GpuMemoryBudget.usedBytes
+
+    @Synchronized
+    fun admittedStreams(): Int = entries.size
+
+    @Synchronized
+    fun clear() {
+        entries.clear()
+    }
+
+    /**
+     * 按优先级从高到低尝试解除降档，直到额度再次吃紧
+     */
+    private fun restoreCapsLocked(): List<String> {
+        val restored = ArrayList<String>()
+        entries.values.filter { it.cap != null && !it.isIdle }.sortedByDescending { it.priority }.forEach { entry ->
+            val delta = cost(entry.requestedTier) - cost(entry.effectiveTier)
+            val deltaBytes = bytes(entry.requestedTier) - bytes(entry.effectiveTier)
+            if (usedLocked() + delta <= budgetPixelsPerSecond && fitsGpu(deltaBytes)) {
+                entry.cap = null
+                restored.add(entry.url)
+            }
+        }
+        return restored
+    }
+
+    private fun usedLocked(): Long {
+        var used = 0L
+        entries.values.forEach { used += costOf(it) }
+        return used
+    }
+
+    /**
+     * 显存校验：节点实际在用的缓冲加上本次变化的估算值不超过全局预算
+     * @param deltaBytes 本次准入或升降档带来的显存变化估算
+     */
+    private fun fitsGpu(deltaBytes: Long): Boolean = GpuMemoryBudget.usedBytes + deltaBytes <= GpuMemoryBudget.budgetBytes
+
+    private fun fitsAfter(tier: ResolutionTier, freed: Long, freedBytes: Long, releasedStreams: Int): Boolean {
+        return usedLocked() - freed + cost(tier) <= budgetPixelsPerSecond &&
+            fitsGpu(bytes(tier) - freedBytes) &&
+            entries.size - releasedStreams + 1 <= maxStreams
+    }
+
+    private fun costOf(entry: Entry): Long = if (entry.isIdle && !idleKeepsDecoding) 0L else cost(entry.effectiveTier)
+
+    private fun cost(tier: ResolutionTier): Long = (tier.width.toLong() * tier.height * assumedFps).toLong()
+
+    private fun bytes(tier: ResolutionTier): Long = GpuMemoryBudget.bytesOf(tier.width, tier.height)
+
+    companion object {
+        /** 被降档的流统一压到的档位 */
+        val DOWNGRADE_TIER = ResolutionTier.P360
+        const val DEFAULT_ASSUMED_FPS = 25f
+
+        /** 默认预算等价于旧版的 16 路 720p@25fps */
+        const val DEFAULT_BUDGET = 16L * 1280 * 720 * 25
+    }
+}
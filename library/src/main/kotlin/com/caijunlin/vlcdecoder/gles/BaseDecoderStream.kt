@@ -1,13 +1,18 @@
 package com.caijunlin.vlcdecoder.gles
 
+import android.graphics.Bitmap
 import android.graphics.SurfaceTexture
+import android.opengl.Matrix
 import android.os.Handler
+import android.util.Log
 import android.view.Surface
 import androidx.core.net.toUri
+import com.caijunlin.vlcdecoder.core.DecoderCapabilities
 import com.caijunlin.vlcdecoder.core.VLCEngineManager
 import org.videolan.libvlc.LibVLC
 import org.videolan.libvlc.Media
 import org.videolan.libvlc.MediaPlayer
+import org.videolan.libvlc.interfaces.IMedia
 import java.util.concurrent.CopyOnWriteArrayList
 
 /**
@@ -21,7 +26,7 @@ abstract class BaseDecoderStream(
     protected val renderHandler: Handler,
     protected val mediaOptions: ArrayList<String>,
     protected val onStreamDead: (String) -> Unit
-) : SurfaceTexture.OnFrameAvailableListener {
+) : SurfaceTexture.OnFrameAvailableListener, PacedStream {
 
     /** 接收 VLC 硬件解码吐出图形数据的底层 OES 纹理标识符 */
     var oesTextureId = -1
@@ -37,25 +42,168 @@ abstract class BaseDecoderStream(
         protected set
 
     protected var decodeSurface: Surface? = null
-    protected var mediaPlayer: MediaPlayer? = null
+
+    /** 播放器实例，只在生命周期通道的工作线程上访问，渲染线程不直接调用任何可能阻塞的播放器接口 */
+    @Volatile private var mediaPlayer: MediaPlayer? = null
+
+    /** 播放器操作的串行通道 */
+    private val playerLane = PlayerLifecycleExecutor.newLane(url)
+
+    /** 是否已开始拉流且尚未释放，仅在节点线程读写 */
+    private var isStarted = false
+
+    /** 播放器生命周期操作是否正卡在超时里 */
+    val isPlayerQuarantined: Boolean get() = playerLane.isQuarantined
 
     /** OES 纹理坐标变换矩阵 */
     val transformMatrix = FloatArray(16)
     var hasFirstFrame = false
 
-    val maxWidth = 1280
-    val maxHeight = 720
+    /** 换源后轨道尺寸可能变化，等待下一帧到达时重新探测，仅在节点线程读写 */
+    private var isSizeProbePending = false
+
+    /** 是否启用 OES 单拷贝直出：单窗口时跳过 OES→FBO 的中转绘制 */
+    @Volatile var directRender = false
+
+    /** 直出模式下 FBO 内容是否落后于 OES 纹理中的最新帧 */
+    private var isFboStale = true
+
+    /** FBO 内容的版本号，每次从 OES 拷贝后递增 */
+    private var fboVersion = 0L
+
+    /** FBO 纹理当前是否启用了 mipmap 链，以及链对应的内容版本 */
+    private var hasMipmaps = false
+    private var mipmapVersion = -1L
+
+    /** 最近一次有窗口需要 mipmap 缩小时的内容版本 */
+    private var mipmapWantedVersion = 0L
+
+    /** 上屏时的画质增强参数，开始拉流时从调度池读取 */
+    @Volatile var imageEnhancement = ImageEnhancement.OFF
+
+    /** 最近一帧的时间戳(纳秒)，由渲染线程在取帧时写入 */
+    @Volatile var lastPts: Long = 0L
+
+    /** 由帧时间戳间隔估算出的源帧率，0 表示尚未测得 */
+    @Volatile override var sourceFps = 0f
+        private set
+
+    /** 运行指标计数器，仅在节点线程写入 */
+    val counters = StreamCounters()
+
+    /** 流级别的目标上屏帧率，0 表示不限制 */
+    @Volatile override var targetFps = 0f
+
+    /** 延迟档位，开始拉流时从调度池读取 */
+    @Volatile var latencyProfile = LatencyProfile.BALANCED
+        private set
+
+    /** 帧时间戳到显示时钟的映射 */
+    private val presentationClock = PresentationClock()
+
+    /** 最近一帧到达(onFrameAvailable)时的单调时钟，由子类在节点线程写入 */
+    protected var frameArrivalNs = 0L
+
+    /** 最近一帧映射到显示时钟后的目标上屏时刻，提交 eglPresentationTimeANDROID 时使用 */
+    var presentationTimeNs = 0L
+        private set
+
+    /** 最近一帧到达时刻相对基线的抖动(毫秒) */
+    val jitterMs: Float get() = presentationClock.jitterNs / 1_000_000f
+
+    /** 首帧到达前展示的封面纹理 */
+    private var posterTexId = -1
+    private var posterWidth = 0
+    private var posterHeight = 0
+    private val posterMatrix = FloatArray(16)
+    /** 位图按行自上而下上传，而顶点纹理坐标以左下角为原点，需要上下翻转 */
+    private val posterFlipMatrix = FloatArray(16).apply {
+        Matrix.setIdentityM(this, 0)
+        Matrix.scaleM(this, 0, 1f, -1f, 1f)
+    }
+
+    /** 是否处于预热状态：已在后台拉流缓冲，但还没有任何窗口订阅 */
+    @Volatile var isWarm = false
+
+    /** 是否处于闲置缓存中且保持解码 */
+    @Volatile var isLingering = false
+
+    /**
+     * 是否处于挂起状态：全部窗口不可见但仍保持绑定，网络会话保留、解码停止、不做任何 GL 绘制，
+     * 窗口重新可见时在一个 GOP 内恢复出画
+     */
+    @Volatile var isParked = false
+        private set
+
+    /** 进入挂起状态的时间戳，未挂起时为 0 */
+    @Volatile var parkedAtMs = 0L
+        private set
+
+    /** 播放器报告的媒体是否可暂停，直播源普遍不可暂停；收到 PausableChanged 之前按不可暂停处理，挂起走卸轨 */
+    @Volatile private var isPausable = false
+
+    /** 不可暂停的源挂起时卸下的视频轨，恢复时重新选中，-1 表示未卸轨 */
+    private var parkedVideoTrack = -1
+
+    /** 无窗口订阅时是否需要在后台自行消费帧 */
+    val consumesInBackground: Boolean
+        get() = isWarm || isLingering || isParked
+
+    /** 是否被闲置缓存暂停了播放 */
+    @Volatile var isPausedByLinger = false
+        private set
+
+    /** 当前生效的解码分辨率档位，跟随绑定窗口的最大尺寸调整 */
+    @Volatile var resolutionTier = ResolutionTier.P720
+        private set
+
+    /** 所属节点的序号，用于选取分片的引擎实例，-1 表示使用全局实例 */
+    @Volatile var engineIndex = -1
+
+    /** 当前的解码方式，由全局硬解会话账本分配，首帧探明编码后修正 */
+    @Volatile var decodeMode = DecodeMode.UNKNOWN
+        private set
+
+    /** 首帧探测到的编码格式(mime)，未知时为 null */
+    @Volatile var codecMime: String? = null
+        private set
+
+    /** 准入控制下发的档位上限，预算吃紧时低优先级流被压到该档，null 表示不限制 */
+    @Volatile var tierCap: ResolutionTier? = null
+    val maxWidth: Int get() = resolutionTier.width
+    val maxHeight: Int get() = resolutionTier.height
+
+    /** 实际拉流使用的地址，多码流源在切换档位时会指向对应的变体 */
+    @Volatile var playingUrl: String = url
+        private set
     var videoWidth = maxWidth
     var videoHeight = maxHeight
 
+    /** 画面真实的显示宽高（已计入像素宽高比），仅用于窗口的 GPU 适配计算 */
+    @Volatile var sourceWidth = maxWidth
+        protected set
+    @Volatile var sourceHeight = maxHeight
+        protected set
+
+    /** 连续重连次数，成功进入播放后清零 */
     @Volatile protected var retryCount = 0
-    protected val maxRetryLimit = 5
+
+    /** 断流重连策略，按地址从调度池查询 */
+    private val reconnectPolicy: ReconnectPolicy
+        get() = VLCRenderPool.reconnectPolicyFor(url)
+
+    /** 熔断分组所用的主机键 */
+    private val host = HostCircuitBreaker.hostOf(url)
+
+    /** 已排期的重连任务，同一时刻最多一个 */
+    private var isReconnectScheduled = false
+    private val reconnectRunnable = Runnable { performReconnect() }
 
     @Volatile var isDecoding = false
         protected set
 
     /** 生命周期羁绊池：订阅了当前流画面的外部显示窗口集合 */
-    val displayWindows = CopyOnWriteArrayList<DisplayWindow>()
+    override val displayWindows = CopyOnWriteArrayList<DisplayWindow>()
 
     @Volatile protected var startPlayTimeMs: Long = 0L
 
@@ -86,16 +234,61 @@ abstract class BaseDecoderStream(
      * @return 完整配置的 Media
      */
     protected fun createMedia(vlc: LibVLC): Media {
-        val media = Media(vlc, url.toUri())
+        val media = Media(vlc, playingUrl.toUri())
         mediaOptions.forEach { media.addOption(it) }
+        latencyProfile.mediaOptions.forEach { media.addOption(it) }
+        if (decodeMode == DecodeMode.SOFTWARE) {
+            // 硬件会话已耗尽，显式走 avcodec，避免每次重连都先撞一次 MediaCodec 的实例上限
+            media.addOption(":codec=avcodec,all")
+        }
+        if (isAdaptiveSource(playingUrl)) {
+            // HLS/DASH 由 VLC 的 adaptive 模块在上限内自动挑选最匹配的码率档
+            media.addOption(":adaptive-maxwidth=$maxWidth")
+            media.addOption(":adaptive-maxheight=$maxHeight")
+        }
         return media
     }
 
+    private fun isAdaptiveSource(source: String): Boolean {
+        val path = source.substringBefore('?').lowercase()
+        return path.endsWith(".m3u8") || path.endsWith(".mpd")
+    }
+
+    private fun resolveVariantUrl(tier: ResolutionTier): String {
+        val variant = VLCRenderPool.variantResolver?.resolve(url, tier)
+        return if (variant.isNullOrEmpty()) url else variant
+    }
+
+    /**
+     * 切换解码分辨率档位。尚未开播时仅记录档位；播放中则重算缓冲区与 FBO 尺寸，
+     * 若源提供了对应档位的变体（子码流 / HLS 档）则在现有播放器上换源。
+     * @param tier 目标档位
+     */
+    fun updateResolutionTier(tier: ResolutionTier) {
+        if (tier == resolutionTier) return
+        resolutionTier = tier
+        if (!isStarted) {
+            playingUrl = resolveVariantUrl(tier)
+            videoWidth = maxWidth
+            videoHeight = maxHeight
+            return
+        }
+        // HLS/DASH 的档位上限在打开媒体时生效，变体地址不变时不为每次跨档重建媒体，下次重连时自然带上新上限
+        val variantUrl = resolveVariantUrl(tier)
+        if (variantUrl != playingUrl) {
+            playingUrl = variantUrl
+            // 换源后轨道尺寸会变化，下一帧到达时重新探测；首帧状态保持不变，不重复通知窗口
+            isSizeProbePending = true
+            playerLane.post("swap media") { swapMedia(restart = false) }
+        }
+        checkAndUpdateResolution()
+    }
+
     /**
      * 提取的公共拉流逻辑，包含共享的回调与重连机制
      */
     fun start() {
-        val fboData = eglCore.createFBO(videoWidth, videoHeight)
+        val fboData = eglCore.framebufferPool.acquire(videoWidth, videoHeight)
         fboId = fboData[0]
         tex2DId = fboData[1]
 
@@ -105,111 +298,546 @@ abstract class BaseDecoderStream(
             setOnFrameAvailableListener(this@BaseDecoderStream, renderHandler)
         }
         decodeSurface = Surface(surfaceTexture)
+        decodeMode = VLCRenderPool.decodeLedger.acquire(this, videoWidth, videoHeight)
+        latencyProfile = VLCRenderPool.latencyProfileOf(url)
+        imageEnhancement = VLCRenderPool.imageEnhancementOf(url)
 
-        VLCEngineManager.libVLC?.let { vlc ->
-            mediaPlayer = MediaPlayer(vlc)
+        val vlc = VLCEngineManager.engineFor(engineIndex) ?: return
+        isStarted = true
+        val surface = decodeSurface
+        val width = videoWidth
+        val height = videoHeight
+        playerLane.post("create") {
+            val player = MediaPlayer(vlc)
             val media = createMedia(vlc)
-            mediaPlayer?.media = media
+            player.media = media
             media.release()
 
-            mediaPlayer?.scale = 0f
-            mediaPlayer?.vlcVout?.setWindowSize(videoWidth, videoHeight)
-            mediaPlayer?.aspectRatio = "$videoWidth:$videoHeight"
-            mediaPlayer?.vlcVout?.setVideoSurface(decodeSurface, null)
-            mediaPlayer?.setEventListener { event ->
-                when (event.type) {
-                    MediaPlayer.Event.EndReached -> {
-                        isDecoding = false
-                        retryPlay()
-                    }
-                    MediaPlayer.Event.Playing -> {
-                        isDecoding = true
-                        retryCount = 0
-                        startPlayTimeMs = System.currentTimeMillis()
-                        onPlayStarted()
-                    }
-                    MediaPlayer.Event.EncounteredError -> {
-                        isDecoding = false
-                        retryCount++
-                        if (retryCount <= maxRetryLimit) {
-                            renderHandler.postDelayed({ retryPlay() }, 2000L)
-                        } else {
-                            displayWindows.forEach { window ->
-                                window.clientRef.get()?.onPlaybackFailed(url)
-                            }
-                            renderHandler.post { onStreamDead(url) }
-                        }
-                    }
-                    MediaPlayer.Event.Stopped -> {
-                        isDecoding = false
-                    }
+            player.scale = 0f
+            player.vlcVout.setWindowSize(width, height)
+            player.aspectRatio = "$width:$height"
+            player.vlcVout.setVideoSurface(surface, null)
+            player.setEventListener { event ->
+                // 播放器事件统一切回节点线程处理，与看门狗、重连任务共享同一线程
+                val type = event.type
+                if (type == MediaPlayer.Event.PausableChanged) isPausable = event.pausable
+                renderHandler.post { onPlayerEvent(type) }
+            }
+            player.vlcVout.attachViews()
+            mediaPlayer = player
+            player.play()
+        }
+
+        startPlayTimeMs = System.currentTimeMillis()
+        renderHandler.postDelayed(watchdogRunnable, 3000L)
+    }
+
+    private fun onPlayerEvent(type: Int) {
+        if (!isStarted) return
+        when (type) {
+            MediaPlayer.Event.EndReached -> {
+                isDecoding = false
+                scheduleReconnect("end reached")
+            }
+            MediaPlayer.Event.Playing -> {
+                if (isPausedByLinger) return
+                if (isParked) {
+                    // 挂起期间重连成功：会话已重新建立，立即停回挂起状态
+                    retryCount = 0
+                    HostCircuitBreaker.onSuccess(host, reconnectPolicy)
+                    playerLane.post("park") { suspendPlayer() }
+                    return
                 }
+                isDecoding = true
+                retryCount = 0
+                startPlayTimeMs = System.currentTimeMillis()
+                HostCircuitBreaker.onSuccess(host, reconnectPolicy)
+                onPlayStarted()
+            }
+            MediaPlayer.Event.EncounteredError -> {
+                isDecoding = false
+                scheduleReconnect("error")
+            }
+            MediaPlayer.Event.Stopped, MediaPlayer.Event.Paused -> {
+                isDecoding = false
             }
-            mediaPlayer?.vlcVout?.attachViews()
-            mediaPlayer?.play()
+        }
+    }
 
-            startPlayTimeMs = System.currentTimeMillis()
-            renderHandler.postDelayed(watchdogRunnable, 3000L)
+    /**
+     * 在工作线程上为现有播放器换上新的 Media 并起播
+     * @param restart 是否先停止当前播放
+     */
+    private fun swapMedia(restart: Boolean) {
+        val player = mediaPlayer ?: return
+        val vlc = VLCEngineManager.engineFor(engineIndex) ?: return
+        if (restart) player.stop()
+        val media = createMedia(vlc)
+        player.media = media
+        media.release()
+        player.play()
+    }
+
+    /**
+     * 记录一次断流并按重连策略排期重连，连续失败超过上限时宣告流死亡。
+     * 看门狗与播放器事件都走这里，同一时刻最多只有一个重连任务在排队
+     * @param reason 触发原因，仅用于日志
+     */
+    protected fun scheduleReconnect(reason: String) {
+        if (isReconnectScheduled) return
+        isDecoding = false
+        renderHandler.removeCallbacks(watchdogRunnable)
+        val policy = reconnectPolicy
+        HostCircuitBreaker.onFailure(host, this, policy)
+        if (retryCount >= policy.maxAttempts) {
+            Log.e("VLCDecoder", "Reconnect exhausted after $retryCount attempts: $url")
+            HostCircuitBreaker.forget(host, this)
+            displayWindows.forEach { window ->
+                window.notifyPlaybackFailed(url)
+            }
+            renderHandler.post { onStreamDead(url) }
+            return
+        }
+        val delayMs = policy.delayFor(retryCount)
+        Log.w("VLCDecoder", "Reconnect #${retryCount + 1} in ${delayMs}ms ($reason): $url")
+        isReconnectScheduled = true
+        renderHandler.postDelayed(reconnectRunnable, delayMs)
+    }
+
+    private fun performReconnect() {
+        if (!isStarted) {
+            isReconnectScheduled = false
+            return
+        }
+        // 主机熔断中则挂起等待，恢复或轮到本流探测时会被重新唤醒
+        if (!HostCircuitBreaker.tryAcquire(host, this, renderHandler, reconnectRunnable)) return
+        isReconnectScheduled = false
+        retryCount++
+        counters.totalRetries++
+        if (retryCount <= reconnectPolicy.softRetries) softRetry() else retryPlay()
+    }
+
+    /**
+     * 软重试：复用现有播放器与 Media 重新起播，省去重建解复用与解码器的开销
+     */
+    private fun softRetry() {
+        playerLane.post("soft retry") {
+            mediaPlayer?.let { player ->
+                player.stop()
+                player.play()
+            }
         }
+        startPlayTimeMs = System.currentTimeMillis()
+        onPlayRetried()
+        renderHandler.postDelayed(watchdogRunnable, 3000L)
     }
 
     /**
      * 执行统一内部重启媒体源逻辑
      */
-    protected fun retryPlay() {
+    private fun retryPlay() {
         isDecoding = false
-        mediaPlayer?.stop()
-        VLCEngineManager.libVLC?.let { vlc ->
-            val media = createMedia(vlc)
-            mediaPlayer?.media = media
-            media.release()
-            mediaPlayer?.play()
+        playerLane.post("rebuild media") { swapMedia(restart = true) }
+        startPlayTimeMs = System.currentTimeMillis()
+        onPlayRetried()
+        renderHandler.postDelayed(watchdogRunnable, 3000L)
+    }
+
+    /**
+     * 当前是否必须走 FBO 中转：未开启直出，或同一路流被多个窗口订阅时复用一次 OES 采样
+     */
+    fun shouldCopyToFBO(): Boolean = !directRender || displayWindows.size > 1
+
+    /**
+     * 在 updateTexImage 锁定新帧后调用，按需将 OES 画面中转到 FBO
+     */
+    fun commitFrame() {
+        if (shouldCopyToFBO()) {
+            eglCore.drawOESToFBO(fboId, oesTextureId, transformMatrix, videoWidth, videoHeight)
+            isFboStale = false
+            fboVersion++
+        } else {
+            isFboStale = true
+        }
+    }
+
+    /**
+     * 锁定 SurfaceTexture 中的最新帧，同时统计锁定耗时、解码帧数、首帧耗时与源帧率
+     * @param st 产出新帧的 SurfaceTexture
+     */
+    fun latchFrame(st: SurfaceTexture) {
+        val startNs = System.nanoTime()
+        st.updateTexImage()
+        counters.updateTexImage.record(System.nanoTime() - startNs)
+        counters.decodedFrames++
+        if (!hasFirstFrame && counters.firstFrameMs < 0L) {
+            counters.firstFrameMs = System.currentTimeMillis() - startPlayTimeMs
+        }
+        recordFrameTimestamp(st.timestamp)
+        st.getTransformMatrix(transformMatrix)
+        val nowNs = System.nanoTime()
+        val arrivalNs = if (frameArrivalNs > 0L) frameArrivalNs else nowNs
+        presentationTimeNs = presentationClock.map(lastPts, arrivalNs, latencyProfile.presentDelayMs * 1_000_000L, nowNs)
+    }
+
+    /**
+     * 新帧锁定后按需探测轨道尺寸：首帧时探测并返回 true，调用方据此通知窗口首帧上屏；
+     * 换源后的重新探测只更新画布尺寸，返回 false
+     */
+    fun onFrameLatched(): Boolean {
+        if (!hasFirstFrame) {
+            isSizeProbePending = false
+            checkAndUpdateResolution()
+            hasFirstFrame = true
+            return true
+        }
+        if (isSizeProbePending) {
+            isSizeProbePending = false
+            checkAndUpdateResolution()
+        }
+        return false
+    }
+
+    /**
+     * 当前帧已提交到某个窗口，记录从帧到达到提交上屏的延迟
+     */
+    fun recordPresented() {
+        counters.presentedFrames++
+        if (frameArrivalNs > 0L) counters.presentLatency.record(System.nanoTime() - frameArrivalNs)
+    }
+
+    /**
+     * 切换延迟档位。缓冲与丢帧参数只在打开媒体时生效，已在拉流的流会就地重建 Media
+     */
+    fun applyLatencyProfile(profile: LatencyProfile) {
+        if (profile == latencyProfile) return
+        latencyProfile = profile
+        presentationClock.reset()
+        if (isStarted) {
+            playerLane.post("latency profile") { swapMedia(restart = true) }
             startPlayTimeMs = System.currentTimeMillis()
-            retryCount++
-            onPlayRetried()
         }
     }
 
     /**
-     * 精准获取视频轨并执行内部画布换膜
+     * 记录新帧的时间戳并以滑动平均更新源帧率，时间戳无效时退回单调时钟
+     * @param ptsNs SurfaceTexture 给出的帧时间戳
+     */
+    fun recordFrameTimestamp(ptsNs: Long) {
+        val ts = if (ptsNs > 0L) ptsNs else System.nanoTime()
+        val prev = lastPts
+        lastPts = ts
+        if (prev <= 0L || ts <= prev) return
+        val deltaNs = ts - prev
+        // 超过一秒的间隔视为断流或跳变，不参与估算
+        if (deltaNs > 1_000_000_000L) return
+        val fps = 1_000_000_000f / deltaNs
+        sourceFps = if (sourceFps == 0f) fps else sourceFps * 0.9f + fps * 0.1f
+    }
+
+    /**
+     * 挂载首帧前展示的封面，首帧到达后自动卸载
+     * @param bitmap 缓存的封面位图
+     */
+    fun attachPoster(bitmap: Bitmap) {
+        if (hasFirstFrame || posterTexId != -1 || bitmap.isRecycled) return
+        posterTexId = eglCore.uploadBitmapTexture(bitmap)
+        posterWidth = bitmap.width
+        posterHeight = bitmap.height
+        displayWindows.forEach { it.isDirty = true }
+    }
+
+    private fun drawPoster(window: DisplayWindow, width: Int, height: Int) {
+        window.updateMvpMatrix(posterWidth, posterHeight, posterHeight)
+        if (window.needsLetterbox) {
+            eglCore.clearCurrentSurface()
+        }
+        Matrix.multiplyMM(posterMatrix, 0, window.mvpMatrix, 0, posterFlipMatrix, 0)
+        eglCore.drawTex2DScreen(posterTexId, posterMatrix, width, height)
+    }
+
+    private fun releasePoster() {
+        eglCore.deleteTexture(posterTexId)
+        posterTexId = -1
+    }
+
+    /**
+     * 预热或闲置保活状态下直接消费新帧：只锁定纹理不做任何绘制，防止缓冲队列堵满导致 VLC 解码停摆，
+     * 同时提前完成首帧的分辨率探测，被接管时即可立即上屏
+     * @param st 产出新帧的 SurfaceTexture
+     */
+    protected fun consumeBackgroundFrame(st: SurfaceTexture) {
+        try {
+            eglCore.makeCurrentMain()
+            latchFrame(st)
+            onFrameLatched()
+            isFboStale = true
+        } catch (e: Exception) {
+            Log.e("VLCDecoder", "Background consume failed: ${e.message}")
+        }
+    }
+
+    /**
+     * 截图等需要稳定拷贝的场景调用，保证 FBO 与 OES 中的最新帧一致
+     */
+    fun ensureFBOContent() {
+        if (isFboStale && hasFirstFrame && fboId != -1) {
+            eglCore.drawOESToFBO(fboId, oesTextureId, transformMatrix, videoWidth, videoHeight)
+            isFboStale = false
+            fboVersion++
+        }
+    }
+
+    /**
+     * 维护 FBO 纹理的 mipmap 链：有窗口需要大倍率缩小时按内容版本重建，连续一段时间无人需要后关闭
+     * @param wanted 本次绘制是否需要 mipmap
+     */
+    private fun updateMipmaps(wanted: Boolean) {
+        if (wanted) mipmapWantedVersion = fboVersion
+        if (!hasMipmaps && !wanted) return
+        if (hasMipmaps && fboVersion - mipmapWantedVersion > MIPMAP_RETAIN_FRAMES) {
+            eglCore.disableMipmaps(tex2DId)
+            hasMipmaps = false
+            mipmapVersion = -1L
+            return
+        }
+        if (mipmapVersion != fboVersion) {
+            eglCore.generateMipmaps(tex2DId)
+            hasMipmaps = true
+            mipmapVersion = fboVersion
+        }
+    }
+
+    /**
+     * 将当前帧绘制到已经 makeCurrent 的窗口表面上，自动选择直出或 FBO 纹理
+     * @param window 目标显示窗口
+     * @param width 视口宽度
+     * @param height 视口高度
+     */
+    fun drawToWindow(window: DisplayWindow, width: Int, height: Int) {
+        if (posterTexId != -1) {
+            if (!hasFirstFrame) {
+                drawPoster(window, width, height)
+                return
+            }
+            releasePoster()
+        }
+        val startNs = System.nanoTime()
+        window.updateMvpMatrix(sourceWidth, sourceHeight, videoHeight)
+        if (window.needsLetterbox) {
+            eglCore.clearCurrentSurface()
+        }
+        val enhancement = imageEnhancement
+        val stageKey = ShaderStage.keyFor(videoWidth, videoHeight, width, height, enhancement)
+        // 需要着色器阶段处理时即使处于直出模式也经过 FBO，滤波只对二维纹理生效
+        if (shouldCopyToFBO() || stageKey != 0) {
+            ensureFBOContent()
+            updateMipmaps(ShaderStage.scaleOf(stageKey) == ShaderStage.SCALE_MIPMAP)
+            eglCore.drawTex2DStage(tex2DId, window.mvpMatrix, width, height, stageKey, videoWidth, videoHeight, enhancement)
+        } else {
+            eglCore.drawOESScreen(oesTextureId, transformMatrix, window.mvpMatrix, width, height)
+        }
+        counters.draw.record(System.nanoTime() - startNs)
+    }
+
+    /**
+     * 暂停播放器，保留网络会话与解码器实例
+     */
+    fun pauseDecoding() {
+        if (isStarted && isDecoding) {
+            renderHandler.removeCallbacks(watchdogRunnable)
+            isPausedByLinger = true
+            isDecoding = false
+            playerLane.post("pause") { mediaPlayer?.pause() }
+        }
+    }
+
+    /**
+     * 恢复被暂停的播放器
+     */
+    fun resumeDecoding() {
+        if (isPausedByLinger) {
+            isPausedByLinger = false
+            playerLane.post("resume") { mediaPlayer?.play() }
+            startPlayTimeMs = System.currentTimeMillis()
+            renderHandler.removeCallbacks(watchdogRunnable)
+            renderHandler.postDelayed(watchdogRunnable, 3000L)
+        }
+    }
+
+    /**
+     * 进入挂起状态：可暂停的源暂停解复用，不可暂停的直播源卸下视频轨停止解码，
+     * 两种方式都保留网络会话；挂起期间不再有新帧进入渲染循环
+     */
+    fun park() {
+        if (isParked || !isStarted) return
+        isParked = true
+        parkedAtMs = System.currentTimeMillis()
+        renderHandler.removeCallbacks(watchdogRunnable)
+        isDecoding = false
+        playerLane.post("park") { suspendPlayer() }
+    }
+
+    /**
+     * 退出挂起状态并恢复全速解码，解码器从下一个关键帧开始出画；
+     * 恢复期间窗口先重绘挂起前的最后一帧
+     */
+    fun unpark() {
+        if (!isParked) return
+        isParked = false
+        parkedAtMs = 0L
+        playerLane.post("unpark") {
+            val player = mediaPlayer ?: return@post
+            if (parkedVideoTrack != -1) {
+                player.setVideoTrack(parkedVideoTrack)
+                parkedVideoTrack = -1
+                // 重新选轨不会再收到 Playing 事件，由这里恢复解码状态
+                renderHandler.post { if (isStarted && !isParked) isDecoding = true }
+            } else if (!player.isPlaying) {
+                player.play()
+            }
+        }
+        if (!isStarted) return
+        startPlayTimeMs = System.currentTimeMillis()
+        onPlayRetried()
+        renderHandler.removeCallbacks(watchdogRunnable)
+        renderHandler.postDelayed(watchdogRunnable, 3000L)
+    }
+
+    /**
+     * 在播放器通道上执行挂起，只能由通道任务调用
+     */
+    private fun suspendPlayer() {
+        val player = mediaPlayer ?: return
+        if (!isParked) return
+        if (isPausable) {
+            player.pause()
+        } else if (parkedVideoTrack == -1) {
+            val track = player.videoTrack
+            if (track != -1) {
+                parkedVideoTrack = track
+                player.setVideoTrack(-1)
+            }
+        }
+    }
+
+    /**
+     * 精准获取视频轨并执行内部画布换膜。轨道查询在播放器通道上执行，结果切回节点线程重建 GL 资源
      */
     fun checkAndUpdateResolution() {
-        val track = mediaPlayer?.currentVideoTrack ?: return
+        if (!isStarted) return
+        playerLane.post("query track") {
+            val track = mediaPlayer?.currentVideoTrack ?: return@post
+            renderHandler.post {
+                if (!isStarted) return@post
+                try {
+                    eglCore.makeCurrentMain()
+                    applyVideoTrack(track)
+                } catch (e: Exception) {
+                    Log.e("VLCDecoder", "Apply video track failed: ${e.message}")
+                }
+            }
+        }
+    }
+
+    private fun applyVideoTrack(track: IMedia.VideoTrack) {
+        if (codecMime == null) codecMime = DecoderCapabilities.mimeOfFourcc(track.codec)
+        if (track.width > 0 && track.height > 0) {
+            val displayW = if (track.sarNum > 0 && track.sarDen > 0) track.width * track.sarNum / track.sarDen else track.width
+            if (displayW != sourceWidth || track.height != sourceHeight) {
+                sourceWidth = displayW
+                sourceHeight = track.height
+                displayWindows.forEach { it.isDirty = true }
+            }
+        }
         val (realW, realH) = getSafeResolution(track.width, track.height)
 
         if (realW > 0 && realH > 0 && (realW != videoWidth || realH != videoHeight)) {
             videoWidth = realW
             videoHeight = realH
-            mediaPlayer?.vlcVout?.setWindowSize(videoWidth, videoHeight)
-            mediaPlayer?.aspectRatio = "$videoWidth:$videoHeight"
+            // 仅用于让 VLC 把画面铺满解码缓冲区，窗口级的适配统一交给 DisplayWindow 的 MVP 矩阵
+            playerLane.post("window size") {
+                mediaPlayer?.let { player ->
+                    player.vlcVout.setWindowSize(realW, realH)
+                    player.aspectRatio = "$realW:$realH"
+                }
+            }
 
-            eglCore.deleteFBO(fboId, tex2DId)
-            val newFboData = eglCore.createFBO(videoWidth, videoHeight)
+            eglCore.framebufferPool.recycle(fboId, tex2DId, reusable = !hasMipmaps)
+            val newFboData = eglCore.framebufferPool.acquire(videoWidth, videoHeight)
             fboId = newFboData[0]
             tex2DId = newFboData[1]
+            isFboStale = true
+            hasMipmaps = false
+            mipmapVersion = -1L
             surfaceTexture?.setDefaultBufferSize(videoWidth, videoHeight)
 
             displayWindows.forEach { it.isDirty = true }
         }
+        if (track.width > 0 && track.height > 0) {
+            decodeMode = VLCRenderPool.decodeLedger.confirm(this, codecMime, track.width, track.height, sourceFps)
+            val softCap = DecodeSessionLedger.SOFTWARE_MAX_TIER
+            if (decodeMode == DecodeMode.SOFTWARE && resolutionTier.ordinal > softCap.ordinal) {
+                renderHandler.post { updateResolutionTier(softCap) }
+            }
+        }
     }
 
     /**
-     * 彻底释放当前流占用的全部内存
+     * 彻底释放当前流占用的全部内存。播放器在通道上停止释放期间仍可能向 SurfaceTexture 写帧，
+     * 因此 SurfaceTexture、GL 纹理、FBO 与解码会话都保留到通道任务结束，再投递回节点线程释放
+     * @param onReleased 全部资源释放完毕后在节点线程回调，节点线程已退出时不会回调
      */
-    open fun release() {
+    open fun release(onReleased: (() -> Unit)? = null) {
+        isStarted = false
         renderHandler.removeCallbacks(watchdogRunnable)
-        mediaPlayer?.stop()
-        mediaPlayer?.vlcVout?.detachViews()
-        mediaPlayer?.release()
-        mediaPlayer = null
-        decodeSurface?.release()
-        surfaceTexture?.release()
-        eglCore.deleteTexture(oesTextureId)
-        eglCore.deleteFBO(fboId, tex2DId)
+        renderHandler.removeCallbacks(reconnectRunnable)
+        isReconnectScheduled = false
+        HostCircuitBreaker.forget(host, this)
+        // 先摘掉帧回调，释放期间到达的帧不再驱动任何绘制
+        val texture = surfaceTexture
+        surfaceTexture = null
+        texture?.setOnFrameAvailableListener(null)
+        val oesId = oesTextureId
+        val fbo = fboId
+        val tex2D = tex2DId
+        val reusable = !hasMipmaps
+        oesTextureId = -1
+        fboId = -1
+        tex2DId = -1
+        decodeMode = DecodeMode.UNKNOWN
+        // 停止与拆链可能阻塞数秒，交给播放器通道；解码 Surface 须在播放器释放后才能销毁
+        val surface = decodeSurface
+        decodeSurface = null
+        playerLane.post("release") {
+            mediaPlayer?.let { player ->
+                mediaPlayer = null
+                player.setEventListener(null)
+                player.stop()
+                player.vlcVout.detachViews()
+                player.release()
+            }
+            surface?.release()
+            renderHandler.post {
+                eglCore.makeCurrentMain()
+                texture?.release()
+                eglCore.deleteTexture(oesId)
+                // 生成过 mipmap 链的纹理占用更多显存且过滤状态已改变，不放回池中
+                eglCore.framebufferPool.recycle(fbo, tex2D, reusable)
+                releasePoster()
+                VLCRenderPool.decodeLedger.release(this)
+                onReleased?.invoke()
+            }
+        }
     }
 
     /** 子类补充播放开始时的变量状态重置 */
     protected abstract fun onPlayStarted()
     /** 子类补充重试时的变量状态重置 */
     protected abstract fun onPlayRetried()
+
+    companion object {
+        /** 连续多少帧没有窗口需要 mipmap 后关闭 mipmap 链 */
+        private const val MIPMAP_RETAIN_FRAMES = 30L
+    }
 }
\ No newline at end of file
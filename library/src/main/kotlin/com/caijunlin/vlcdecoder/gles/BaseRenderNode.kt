@@ -1,7 +1,9 @@
 package com.caijunlin.vlcdecoder.gles
 
 import android.graphics.Bitmap
+import android.graphics.Rect
 import android.opengl.EGL14
+import android.os.Build
 import android.os.Handler
 import android.os.HandlerThread
 import android.os.Looper
@@ -9,6 +11,9 @@ import android.os.Process
 import android.util.Log
 import android.view.Surface
 import androidx.annotation.CallSuper
+import androidx.core.graphics.scale
+import com.caijunlin.vlcdecoder.core.CpuTopology
+import com.caijunlin.vlcdecoder.core.VLCEngineManager
 import java.util.concurrent.ConcurrentHashMap
 
 /**
@@ -34,36 +39,577 @@ abstract class BaseRenderNode<T : BaseDecoderStream>(
     val displayMap = ConcurrentHashMap<Surface, DisplayWindow>()
     val pendingReleaseTasks = ConcurrentHashMap<String, Runnable>()
 
+    /** 闲置缓存：最近失去全部窗口的流，按闲置先后排序，仅在节点线程访问 */
+    private val idleStreams = LinkedHashMap<String, T>()
+
+    /** 闲置缓存中仍在解码的流数量与像素数，节点线程维护，供跨线程的负载采样读取 */
+    @Volatile
+    private var idleDecodingCount = 0
+    @Volatile
+    private var idleDecodingPixels = 0L
+
+    /** 闲置缓存策略，由调度池下发 */
+    @Volatile
+    var lingerPolicy = LingerPolicy()
+
+    /** 闲置缓存的命中次数与未命中次数 */
+    private var lingerHits = 0
+    private var lingerMisses = 0
+
+    /** 预热池：已在后台拉流缓冲、尚未被任何窗口订阅的流，不计入 streams 的并发上限 */
+    val warmStreams = ConcurrentHashMap<String, T>()
+
     lateinit var eglCore: EGLCore
 
+    /** 解码分辨率档位上限，由调度池下发 */
+    @Volatile
+    var maxResolutionTier = ResolutionTier.P720
+
+    /** 分辨率档位调整的防抖任务，仅在节点线程访问 */
+    private val pendingTierTasks = HashMap<String, Runnable>()
+
+    /** 节点序号，开启引擎分片时据此选取本节点独立的 LibVLC 实例 */
+    @Volatile
+    var engineIndex = -1
+
+    /** 本节点线程被限制运行的核心，空表示不限制 */
+    @Volatile
+    var affinityCpus: List<Int> = emptyList()
+        private set
+
+    /** 绑核是否已生效 */
+    @Volatile
+    private var isAffinityApplied = false
+
+    /** 最近一次采样到的节点线程所在核心，-1 表示未知 */
+    @Volatile
+    private var currentCpu = -1
+    private var ticksSinceCpuSample = 0
+
+    /** 分别在大核与小核上运行时的平均循环耗时，用于对比绑核前后的效果 */
+    @Volatile
+    private var avgTickBigMs = 0f
+    @Volatile
+    private var avgTickLittleMs = 0f
+
+    /** 新建的流是否启用 OES 单拷贝直出，由调度池按当前渲染模式下发 */
+    @Volatile
+    var directRenderEnabled = false
+
+    /**
+     * 活跃流的稠密数组，与 streams 同步维护，仅在节点线程访问。
+     * 渲染循环按下标遍历它，不产生迭代器分配；streams 仍保留给按地址查找与跨线程的只读统计
+     */
+    protected val activeStreams = ArrayList<T>()
+
+    /** 布局事务摘窗阶段暂留的流，提交阶段结束后仍无窗口的才进入闲置缓存 */
+    private val heldStreams = ArrayList<T>()
+
+    /** 最近一次因超限被拒绝建流的地址，供紧随其后的绑定结果查询使用 */
+    private var lastRejectedUrl: String? = null
+
+    /** 合成模式下承载本节点所有瓦片的共享图层，仅在节点线程访问 */
+    protected var compositorLayer: CompositorLayer? = null
+
+    /** 瓦片视口的复用缓冲 */
+    private val tileViewport = IntArray(4)
+
+    /** 已发出但播放器尚未释放完毕的流数量，仅在节点线程访问 */
+    private var pendingStreamReleases = 0
+
+    /** 节点已进入销毁流程，在途释放归零后立即释放 EGL 与引擎 */
+    private var isDestroying = false
+    private var isDestroyed = false
+
+    /** 销毁完成回调，引擎释放后触发 */
+    private var onDestroyed: (() -> Unit)? = null
+
+    /** 渲染循环耗时直方图，仅在节点线程访问 */
+    private val tickHistogram = LatencyHistogram()
+
+    /** 帧节奏调度器，决定每个窗口在何时呈现哪一帧 */
+    val framePacer = FramePacer()
+
+    /** 单次渲染循环耗时的指数滑动平均值(毫秒)，由节点线程写入，调度线程读取 */
+    @Volatile
+    var avgTickMs = 0f
+        private set
+
     override fun getActiveStreamCount(): Int = streams.size
 
+    /**
+     * 由具体管线构建对应平台的解码流实例
+     * @param url 视频流地址
+     * @param opts 媒体配置参数
+     * @return 尚未 start 的解码流
+     */
+    protected abstract fun createStream(url: String, opts: ArrayList<String>): T
+
+    override fun handlePreload(url: String, opts: ArrayList<String>) {
+        if (streams.containsKey(url) || warmStreams.containsKey(url) || idleStreams.containsKey(url)) return
+        val stream = createStream(url, opts)
+        stream.isWarm = true
+        stream.directRender = directRenderEnabled
+        stream.updateResolutionTier(maxResolutionTier)
+        stream.start()
+        warmStreams[url] = stream
+    }
+
+    override fun handleEvictWarm(url: String) {
+        val stream = warmStreams.remove(url) ?: return
+        eglCore.makeCurrentMain()
+        releaseStream(stream)
+        onStreamDeadCleanup(url, emptyList())
+    }
+
+    /**
+     * 从预热池中取出流并转为活跃状态，播放器与缓冲原样保留，无需重新建连
+     * @param url 视频流地址
+     * @return 预热好的流，不存在时返回 null
+     */
+    protected fun promoteWarmStream(url: String): T? {
+        val stream = warmStreams.remove(url) ?: return null
+        stream.isWarm = false
+        addActiveStream(url, stream)
+        Log.i("VLCDecoder", "Warm stream promoted on $nodeName: $url")
+        return stream
+    }
+
+    /**
+     * 将流登记为活跃流
+     */
+    protected fun addActiveStream(url: String, stream: T) {
+        streams[url] = stream
+        activeStreams.add(stream)
+    }
+
+    /**
+     * 计入并发上限的流数量。布局事务中暂留且仍无窗口的流会在收尾时让出名额，提交阶段的新绑定不为它们让路；
+     * 闲置期间继续解码的流照常占用解码器，计入上限
+     */
+    protected fun occupiedStreamCount(): Int {
+        var count = streams.size
+        for (i in heldStreams.indices) {
+            val held = heldStreams[i]
+            if (held.displayWindows.isEmpty() && streams[held.url] === held) count--
+        }
+        idleStreams.values.forEach { if (it.isLingering) count++ }
+        return count
+    }
+
+    /**
+     * 检查新绑定是否还有名额，名额不足时按闲置先后释放仍在解码的闲置流腾出名额
+     * @param url 待绑定的视频流地址
+     * @param limit 节点最大负载限制
+     * @return 是否可以为该地址建流或复用闲置流
+     */
+    protected fun hasBindSlot(url: String, limit: Int): Boolean {
+        // 复用仍在解码的闲置流只是把名额从闲置转回活跃
+        if (idleStreams[url]?.isLingering == true) return true
+        while (occupiedStreamCount() >= limit) {
+            val eldestUrl = idleStreams.entries.firstOrNull { it.value.isLingering }?.key ?: return false
+            handleEvictIdle(eldestUrl)
+        }
+        return true
+    }
+
+    /**
+     * 将流移出活跃流
+     * @return 被移除的流，不存在时返回 null
+     */
+    protected fun removeActiveStream(url: String): T? {
+        val stream = streams.remove(url) ?: return null
+        activeStreams.remove(stream)
+        return stream
+    }
+
+    /**
+     * 把窗口挂到流上，并建立窗口到流的反向指针
+     */
+    protected fun attachWindow(stream: T, window: DisplayWindow) {
+        window.stream = stream
+        stream.displayWindows.add(window)
+        displayMap[window.x5Surface] = window
+        updateParkState(stream)
+        updateFanOut(stream)
+    }
+
+    /**
+     * 按窗口的可见性同步流的挂起状态：全部窗口都被挂起时流进入挂起，任一窗口恢复可见即退出挂起
+     */
+    protected fun updateParkState(stream: T) {
+        val windows = stream.displayWindows
+        if (windows.isEmpty()) return
+        if (windows.all { it.isParked }) stream.park() else stream.unpark()
+    }
+
+    /**
+     * 通过反向指针取得窗口所属的流，无需扫描全部流
+     */
+    @Suppress("UNCHECKED_CAST")
+    protected fun streamOf(window: DisplayWindow): T? = window.stream as T?
+
+    override fun getLoad(): NodeLoad {
+        var pixels = 0L
+        val movable = HashMap<String, Long>()
+        streams.values.forEach { stream ->
+            val streamPixels = stream.videoWidth.toLong() * stream.videoHeight
+            pixels += streamPixels
+            if (!stream.isParked && stream.displayWindows.isNotEmpty()) movable[stream.url] = streamPixels
+        }
+        // 仍在解码的闲置流照常消耗解码与渲染算力
+        return NodeLoad(streams.size + idleDecodingCount, pixels + idleDecodingPixels, avgTickMs, movable)
+    }
+
+    /**
+     * 记录一次渲染循环的耗时
+     * @param costNs 本次循环耗费的纳秒数
+     */
+    protected fun recordTickCost(costNs: Long) {
+        tickHistogram.record(costNs)
+        val costMs = costNs / 1_000_000f
+        avgTickMs = if (avgTickMs == 0f) costMs else avgTickMs * 0.9f + costMs * 0.1f
+        framePacer.updatePressure(avgTickMs, framePacer.pacingIntervalMs(activeStreams))
+
+        // 读取 /proc 有开销，每隔若干轮循环才采样一次所在核心，耗时按核心类型分别累计
+        if (ticksSinceCpuSample-- <= 0) {
+            ticksSinceCpuSample = CPU_SAMPLE_INTERVAL
+            currentCpu = CpuTopology.currentCpuOf(thread.threadId)
+        }
+        if (currentCpu < 0) return
+        if (CpuTopology.isBigCore(currentCpu)) {
+            avgTickBigMs = if (avgTickBigMs == 0f) costMs else avgTickBigMs * 0.9f + costMs * 0.1f
+        } else {
+            avgTickLittleMs = if (avgTickLittleMs == 0f) costMs else avgTickLittleMs * 0.9f + costMs * 0.1f
+        }
+    }
+
+    /**
+     * 限制节点线程运行的核心
+     * @param cpus 允许运行的核心，为空时解除限制
+     */
+    fun applyAffinity(cpus: List<Int>) {
+        if (cpus == affinityCpus && (isAffinityApplied || cpus.isEmpty())) return
+        val wasPinned = affinityCpus.isNotEmpty()
+        affinityCpus = cpus
+        isAffinityApplied = false
+        if (cpus.isEmpty() && !wasPinned) return
+        CpuTopology.setAffinity(thread.threadId, cpus) { ok ->
+            isAffinityApplied = ok && cpus.isNotEmpty()
+            if (ok) Log.i("VLCDecoder", "$nodeName pinned to ${cpus.ifEmpty { "all cores" }}")
+            // 绑核前后的耗时不具可比性，重新开始统计
+            avgTickBigMs = 0f
+            avgTickLittleMs = 0f
+        }
+    }
+
+    /**
+     * 渲染循环停摆时清零耗时统计，防止过期的数据误导调度
+     */
+    protected fun resetTickCost() {
+        avgTickMs = 0f
+    }
+
+    override fun collectMetrics(nodeIndex: Int): NodeMetrics {
+        val nowNs = System.nanoTime()
+        val result = ArrayList<StreamMetrics>(streams.size + warmStreams.size + idleStreams.size)
+        streams.values.forEach { result.add(sampleStream(it, nodeIndex, if (it.isParked) "parked" else "active", nowNs)) }
+        warmStreams.values.forEach { result.add(sampleStream(it, nodeIndex, "warm", nowNs)) }
+        idleStreams.values.forEach { result.add(sampleStream(it, nodeIndex, "idle", nowNs)) }
+        return NodeMetrics(
+            nodeIndex, streams.size, warmStreams.size, idleStreams.size, streams.values.count { it.isParked },
+            avgTickMs, tickHistogram.sampleAndReset(), result,
+            currentCpu, if (isAffinityApplied) affinityCpus else emptyList(), avgTickBigMs, avgTickLittleMs,
+            eglCore.framebufferPool.liveBufferBytes, eglCore.framebufferPool.idleBufferBytes
+        )
+    }
+
+    private fun sampleStream(stream: T, nodeIndex: Int, state: String, nowNs: Long): StreamMetrics {
+        val counters = stream.counters
+        val (decodedFps, presentedFps) = counters.sampleRates(nowNs)
+        return StreamMetrics(
+            url = stream.url,
+            nodeIndex = nodeIndex,
+            state = state,
+            windows = stream.displayWindows.size,
+            width = stream.videoWidth,
+            height = stream.videoHeight,
+            sourceFps = stream.sourceFps,
+            decodedFps = decodedFps,
+            presentedFps = presentedFps,
+            droppedByCongestion = counters.droppedByCongestion,
+            firstFrameMs = counters.firstFrameMs,
+            retryCount = counters.totalRetries,
+            decodeMode = stream.decodeMode.name,
+            codec = stream.codecMime ?: "",
+            playerQuarantined = stream.isPlayerQuarantined,
+            parkedWindows = stream.displayWindows.count { it.isParked },
+            parkedMs = if (stream.isParked) System.currentTimeMillis() - stream.parkedAtMs else 0L,
+            latencyProfile = stream.latencyProfile.name,
+            networkCachingMs = stream.latencyProfile.networkCachingMs,
+            jitterMs = stream.jitterMs,
+            presentLatency = counters.presentLatency.sampleAndReset(),
+            updateTexImage = counters.updateTexImage.sampleAndReset(),
+            draw = counters.draw.sampleAndReset(),
+            swap = counters.swap.sampleAndReset()
+        )
+    }
+
     override fun handleUnbind(url: String, x5Surface: Surface) {
-        val window = displayMap.remove(x5Surface)
-        if (window != null) {
-            if (window.x5Surface.isValid && eglCore.makeCurrent(window.eglSurface, eglCore.eglContext)) {
-                eglCore.clearCurrentSurface()
-                eglCore.swapBuffers(window.eglSurface)
-            }
-            window.release(eglCore)
+        val window = detachWindow(x5Surface, clearSurface = true, holdStream = false)
+        if (window?.isComposited == true && composeLayer()) {
+            // 立即重绘图层抹掉该瓦片，不依赖可能已停摆的渲染循环
+            eglCore.makeCurrentMain()
         }
+    }
 
-        val stream = streams[url]
-        if (stream != null && window != null) {
+    override fun handleEvictIdle(url: String) {
+        val stream = idleStreams.remove(url) ?: return
+        pendingReleaseTasks.remove(url)?.let { handler.removeCallbacks(it) }
+        releaseIdleStream(url, stream)
+    }
+
+    override fun handleMigrateOut(url: String) {
+        val stream = streams[url] ?: return
+        // 画布马上由目标节点接管，不清空以免闪烁；源流直接释放，不进闲置缓存，避免两个节点同时解码
+        stream.displayWindows.toList().forEach { detachWindow(it.x5Surface, clearSurface = false, holdStream = true) }
+        heldStreams.remove(stream)
+        removeActiveStream(url)
+        pendingTierTasks.remove(url)?.let { handler.removeCallbacks(it) }
+        releaseIdleStream(url, stream)
+    }
+
+    override fun handleLayoutDetach(url: String, x5Surface: Surface, clearSurface: Boolean) {
+        detachWindow(x5Surface, clearSurface, holdStream = true)
+    }
+
+    override fun handleLayoutSettle() {
+        if (heldStreams.isEmpty()) return
+        heldStreams.forEach { stream ->
+            if (streams[stream.url] !== stream) return@forEach
+            if (stream.displayWindows.isEmpty()) lingerIdleStream(stream.url, stream) else scheduleTierUpdate(stream)
+        }
+        heldStreams.clear()
+    }
+
+    /**
+     * 从画布上摘下窗口并释放其 EGL 表面
+     * @param clearSurface 是否把画布清为透明；布局事务中马上会被重新绑定的画布无需清空，避免闪烁
+     * @param holdStream 为 true 时失去全部窗口的流暂不进入闲置缓存，等布局事务提交后再统一处理
+     * @return 被摘下的窗口
+     */
+    private fun detachWindow(x5Surface: Surface, clearSurface: Boolean, holdStream: Boolean): DisplayWindow? {
+        val window = displayMap.remove(x5Surface) ?: return null
+        if (window.isComposited) {
+            compositorLayer?.isDirty = true
+        } else if (clearSurface && window.x5Surface.isValid && eglCore.makeCurrent(window.eglSurface, eglCore.eglContext)) {
+            eglCore.clearCurrentSurface()
+            eglCore.swapBuffers(window.eglSurface)
+        }
+        window.release(eglCore)
+
+        val stream = streamOf(window)
+        window.stream = null
+        if (stream != null && streams[stream.url] === stream) {
             stream.displayWindows.remove(window)
-            if (stream.displayWindows.isEmpty() && !pendingReleaseTasks.containsKey(url)) {
-                val task = Runnable {
-                    val s = streams[url]
-                    if (s != null && s.displayWindows.isEmpty()) {
-                        s.release()
-                        streams.remove(url)
-                    }
-                    pendingReleaseTasks.remove(url)
+            when {
+                holdStream -> if (!heldStreams.contains(stream)) heldStreams.add(stream)
+                stream.displayWindows.isNotEmpty() -> {
+                    updateParkState(stream)
+                    updateFanOut(stream)
+                    scheduleTierUpdate(stream)
                 }
-                pendingReleaseTasks[url] = task
-                handler.postDelayed(task, 500L)
+                else -> lingerIdleStream(stream.url, stream)
             }
         }
+        return window
+    }
+
+    /**
+     * 将失去全部窗口的流移入闲置缓存，按策略决定暂停还是继续解码，并登记超时释放任务
+     * @param url 视频流地址
+     * @param stream 已经没有窗口订阅的流
+     */
+    private fun lingerIdleStream(url: String, stream: T) {
+        removeActiveStream(url)
+        val policy = lingerPolicy
+        if (policy.ttlMs <= 0L || policy.maxIdle <= 0) {
+            releaseIdleStream(url, stream)
+            return
+        }
+        if (policy.keepDecoding) stream.isLingering = true else stream.pauseDecoding()
+        idleStreams[url] = stream
+        refreshIdleLoad()
+
+        val task = Runnable {
+            pendingReleaseTasks.remove(url)
+            idleStreams.remove(url)?.let { releaseIdleStream(url, it) }
+        }
+        pendingReleaseTasks[url] = task
+        handler.postDelayed(task, policy.ttlMs)
+
+        while (idleStreams.size > policy.maxIdle) {
+            val eldestUrl = idleStreams.keys.first()
+            pendingReleaseTasks.remove(eldestUrl)?.let { handler.removeCallbacks(it) }
+            idleStreams.remove(eldestUrl)?.let { releaseIdleStream(eldestUrl, it) }
+        }
+    }
+
+    private fun releaseIdleStream(url: String, stream: T) {
+        refreshIdleLoad()
+        eglCore.makeCurrentMain()
+        releaseStream(stream)
+        onStreamDeadCleanup(url, emptyList())
+    }
+
+    /**
+     * 闲置缓存变化后重新统计其中仍在解码的流
+     */
+    private fun refreshIdleLoad() {
+        var count = 0
+        var pixels = 0L
+        idleStreams.values.forEach { stream ->
+            if (!stream.isLingering) return@forEach
+            count++
+            pixels += stream.videoWidth.toLong() * stream.videoHeight
+        }
+        idleDecodingCount = count
+        idleDecodingPixels = pixels
+    }
+
+    /**
+     * 从闲置缓存中取回流，恢复解码并重新计入活跃流
+     * @param url 视频流地址
+     * @return 命中的闲置流，未命中返回 null
+     */
+    protected fun reviveIdleStream(url: String): T? {
+        val stream = idleStreams.remove(url) ?: return null
+        pendingReleaseTasks.remove(url)?.let { handler.removeCallbacks(it) }
+        stream.isLingering = false
+        refreshIdleLoad()
+        stream.resumeDecoding()
+        addActiveStream(url, stream)
+        lingerHits++
+        return stream
+    }
+
+    /**
+     * 记录一次闲置缓存未命中（需要全新建流）
+     */
+    protected fun recordLingerMiss() {
+        lingerMisses++
+    }
+
+    /**
+     * 按当前绑定窗口的最大物理尺寸计算流应处的分辨率档位
+     * @param stream 目标流
+     * @return 向上取整后的档位
+     */
+    protected fun computeResolutionTier(stream: T): ResolutionTier {
+        var maxW = 0
+        var maxH = 0
+        stream.displayWindows.forEach {
+            if (it.physicalW > maxW) maxW = it.physicalW
+            if (it.physicalH > maxH) maxH = it.physicalH
+        }
+        var limit = maxResolutionTier
+        stream.tierCap?.let { if (it.ordinal < limit.ordinal) limit = it }
+        if (stream.decodeMode == DecodeMode.SOFTWARE && DecodeSessionLedger.SOFTWARE_MAX_TIER.ordinal < limit.ordinal) {
+            limit = DecodeSessionLedger.SOFTWARE_MAX_TIER
+        }
+        return ResolutionTier.fit(maxW, maxH, limit)
+    }
+
+    /**
+     * 防抖调度分辨率档位调整，连续的尺寸变化只在稳定后生效一次
+     * @param stream 目标流
+     */
+    protected fun scheduleTierUpdate(stream: T) {
+        pendingTierTasks.remove(stream.url)?.let { handler.removeCallbacks(it) }
+        val task = Runnable {
+            pendingTierTasks.remove(stream.url)
+            if (streams[stream.url] === stream && stream.displayWindows.isNotEmpty()) {
+                eglCore.makeCurrentMain()
+                stream.updateResolutionTier(computeResolutionTier(stream))
+            }
+        }
+        pendingTierTasks[stream.url] = task
+        handler.postDelayed(task, TIER_DEBOUNCE_MS)
+    }
+
+    override fun handleScaleMode(x5Surface: Surface, mode: ScaleMode) {
+        displayMap[x5Surface]?.scaleMode = mode
+    }
+
+    override fun handleTargetFps(x5Surface: Surface, fps: Float) {
+        displayMap[x5Surface]?.let { window ->
+            window.targetFps = fps
+            window.nextPresentPtsNs = 0L
+        }
+    }
+
+    override fun handleStreamTargetFps(url: String, fps: Float) {
+        val stream = streams[url] ?: return
+        stream.targetFps = fps
+        stream.displayWindows.forEach { it.nextPresentPtsNs = 0L }
+    }
+
+    override fun handleWindowPriority(x5Surface: Surface) {
+        val window = displayMap[x5Surface] ?: return
+        streamOf(window)?.let { updateFanOut(it) }
+    }
+
+    override fun handleParkWindow(x5Surface: Surface, parked: Boolean) {
+        val window = displayMap[x5Surface] ?: return
+        if (window.isParked == parked) return
+        window.isParked = parked
+        if (window.isComposited) compositorLayer?.isDirty = true
+        if (!parked) {
+            // 立即重绘挂起前的最后一帧，新帧在解码器拿到下一个关键帧后接上
+            window.isDirty = true
+            window.nextPresentPtsNs = 0L
+        }
+        val stream = streamOf(window) ?: return
+        updateParkState(stream)
+        updateFanOut(stream)
+        Log.i("VLCDecoder", "Window ${if (parked) "parked" else "unparked"} on $nodeName, stream parked: ${stream.isParked} ${stream.url}")
+        requestRender()
+    }
+
+    override fun handleTrimFramebuffers() {
+        eglCore.makeCurrentMain()
+        eglCore.framebufferPool.clearIdle()
+    }
+
+    override fun handleImageEnhancement() {
+        val refresh = { stream: T ->
+            stream.imageEnhancement = VLCRenderPool.imageEnhancementOf(stream.url)
+            stream.displayWindows.forEach { it.isDirty = true }
+        }
+        streams.values.forEach(refresh)
+        warmStreams.values.forEach(refresh)
+        idleStreams.values.forEach(refresh)
+        compositorLayer?.isDirty = true
+        requestRender()
+    }
+
+    override fun handleWarmUp(enhancement: ImageEnhancement) {
+        eglCore.warmUpStages(enhancement)
+    }
+
+    override fun handleStreamLatencyProfile(url: String, profile: LatencyProfile) {
+        val stream = streams[url] ?: warmStreams[url] ?: idleStreams[url] ?: return
+        stream.applyLatencyProfile(profile)
+    }
+
+    override fun handleStreamTierCap(url: String, cap: ResolutionTier?) {
+        val stream = streams[url] ?: return
+        if (stream.tierCap == cap) return
+        stream.tierCap = cap
+        if (stream.displayWindows.isNotEmpty()) {
+            eglCore.makeCurrentMain()
+            stream.updateResolutionTier(computeResolutionTier(stream))
+        }
     }
 
     override fun handleCapture(x5Surface: Surface, callback: (Bitmap?) -> Unit) {
@@ -73,97 +619,512 @@ abstract class BaseRenderNode<T : BaseDecoderStream>(
             mainHandler.post { callback(null) }
             return
         }
-        val targetStream = streams.values.find { it.displayWindows.contains(window) }
+        val targetStream = streamOf(window)
         if (targetStream == null || targetStream.fboId == -1) {
             mainHandler.post { callback(null) }
             return
         }
         eglCore.makeCurrentMain()
-        eglCore.readPixelsFromFBOAsync(targetStream.fboId, targetStream.videoWidth, targetStream.videoHeight, handler, callback)
+        targetStream.ensureFBOContent()
+        eglCore.readPixelsAsync(targetStream.tex2DId, targetStream.videoWidth, targetStream.videoHeight, handler, callback)
+    }
+
+    override fun handleCaptureBatch(x5Surfaces: List<Surface>, callback: (List<Bitmap?>) -> Unit) {
+        val results = arrayOfNulls<Bitmap>(x5Surfaces.size)
+        var remaining = x5Surfaces.size
+        if (remaining == 0) {
+            Handler(Looper.getMainLooper()).post { callback(emptyList()) }
+            return
+        }
+        // 回调统一在主线程执行，计数无需额外同步
+        eglCore.makeCurrentMain()
+        val requests = x5Surfaces.mapIndexed { index, x5Surface ->
+            val window = displayMap[x5Surface]
+            val stream = if (window != null) streamOf(window) else null
+            stream?.ensureFBOContent()
+            PixelReadback.Request(
+                stream?.tex2DId ?: -1,
+                stream?.videoWidth ?: 0,
+                stream?.videoHeight ?: 0
+            ) { bitmap ->
+                results[index] = bitmap
+                remaining--
+                if (remaining == 0) callback(results.toList())
+            }
+        }
+        eglCore.readPixelsBatchAsync(requests, handler)
+    }
+
+    override fun handlePosterReady(url: String) {
+        val stream = streams[url] ?: return
+        if (stream.hasFirstFrame) return
+        val poster = PosterCache.getMemory(url) ?: return
+        eglCore.makeCurrentMain()
+        stream.attachPoster(poster)
     }
 
-    override fun handleCaptureSync(x5Surface: Surface): Bitmap? {
+    override fun handleSnapshot(maxWidth: Int, callback: (List<Pair<String, Bitmap?>>) -> Unit) {
+        val targets = streams.values.filter { it.hasFirstFrame && it.displayWindows.isNotEmpty() && it.tex2DId != -1 }
+        if (targets.isEmpty()) return
+        eglCore.makeCurrentMain()
+        val results = ArrayList<Pair<String, Bitmap?>>(targets.size)
+        var remaining = targets.size
+        val requests = targets.map { stream ->
+            stream.ensureFBOContent()
+            val outW = minOf(maxWidth, stream.videoWidth).coerceAtLeast(2)
+            val outH = (outW.toLong() * stream.sourceHeight / stream.sourceWidth.coerceAtLeast(1)).toInt().coerceAtLeast(2)
+            PixelReadback.Request(stream.tex2DId, outW, outH) { bitmap ->
+                results.add(Pair(stream.url, bitmap))
+                remaining--
+                if (remaining == 0) callback(results)
+            }
+        }
+        eglCore.readPixelsBatchAsync(requests, handler)
+    }
+
+    override fun handleCaptureSync(x5Surface: Surface, targetW: Int, targetH: Int, hardware: Boolean): Bitmap? {
         val window = displayMap[x5Surface] ?: return null
-        val targetStream = streams.values.find { it.displayWindows.contains(window) }
+        val targetStream = streamOf(window)
         if (targetStream == null || targetStream.fboId == -1) return null
 
         eglCore.makeCurrentMain()
-        return eglCore.readPixelsFromFBOSync(targetStream.fboId, targetStream.videoWidth, targetStream.videoHeight)
+        targetStream.ensureFBOContent()
+        val outW = if (targetW > 0 && targetH > 0) targetW else targetStream.videoWidth
+        val outH = if (targetW > 0 && targetH > 0) targetH else targetStream.videoHeight
+        if (hardware && Build.VERSION.SDK_INT >= Build.VERSION_CODES.Q) {
+            val hardwareBitmap = try {
+                eglCore.captureHardwareBitmap(targetStream.tex2DId, outW, outH)
+            } catch (e: Exception) {
+                Log.e("VLCDecoder", "Hardware capture failed: ${e.message}")
+                null
+            }
+            if (hardwareBitmap != null) return hardwareBitmap
+        }
+        val bitmap = eglCore.readPixelsFromFBOSync(targetStream.fboId, targetStream.videoWidth, targetStream.videoHeight)
+            ?: return null
+        if (bitmap.width == outW && bitmap.height == outH) return bitmap
+        return bitmap.scale(outW, outH).also { bitmap.recycle() }
     }
 
     override fun handleClearSurface(x5Surface: Surface) {
         val window = displayMap[x5Surface]
-        if (window != null && window.x5Surface.isValid) {
+        if (window != null && window.isComposited) {
+            compositorLayer?.isDirty = true
+            requestRender()
+        } else if (window != null && window.x5Surface.isValid) {
             if (eglCore.makeCurrent(window.eglSurface, eglCore.eglContext)) {
                 eglCore.clearCurrentSurface()
                 eglCore.swapBuffers(window.eglSurface)
             }
         } else if (x5Surface.isValid) {
-            val tempEgl = eglCore.createWindowSurface(x5Surface)
-            if (tempEgl != EGL14.EGL_NO_SURFACE) {
-                if (eglCore.makeCurrent(tempEgl, eglCore.eglContext)) {
-                    eglCore.clearCurrentSurface()
-                    eglCore.swapBuffers(tempEgl)
+            clearNativeSurface(x5Surface)
+        }
+    }
+
+    /**
+     * 借助临时 EGL 表面把未被托管的原生画布清空为透明
+     */
+    private fun clearNativeSurface(surface: Surface) {
+        val tempEgl = eglCore.createWindowSurface(surface)
+        if (tempEgl != EGL14.EGL_NO_SURFACE) {
+            if (eglCore.makeCurrent(tempEgl, eglCore.eglContext)) {
+                eglCore.clearCurrentSurface()
+                eglCore.swapBuffers(tempEgl)
+            }
+            eglCore.makeCurrentMain()
+            eglCore.destroySurface(tempEgl)
+        }
+    }
+
+    override fun handleBindResult(
+        url: String,
+        x5Surface: Surface,
+        awaitFirstFrame: Boolean,
+        callback: (BindResult) -> Unit
+    ) {
+        val window = displayMap[x5Surface]
+        val stream = window?.let { streamOf(it) }
+        if (window == null || stream == null || stream.url != url) {
+            val status = if (window == null && lastRejectedUrl == url) BindStatus.REJECTED_BY_LIMIT else BindStatus.NOT_BOUND
+            lastRejectedUrl = null
+            callback(BindResult(url, status))
+            return
+        }
+        if (!awaitFirstFrame) {
+            callback(BindResult(url, BindStatus.ACCEPTED, window.firstFrameAtMs))
+            return
+        }
+        window.addFirstFrameListener { status, atMs -> callback(BindResult(url, status, atMs)) }
+    }
+
+    override fun handleAttachLayer(surface: Surface, width: Int, height: Int) {
+        if (compositorLayer?.surface == surface) {
+            handleResizeLayer(width, height)
+            return
+        }
+        handleDetachLayer()
+        compositorLayer = CompositorLayer(surface, width, height).apply { initEGLSurface(eglCore) }
+    }
+
+    override fun handleResizeLayer(width: Int, height: Int) {
+        val layer = compositorLayer ?: return
+        layer.resize(width, height)
+        if (layer.isDirty) requestRender()
+    }
+
+    override fun handleDetachLayer() {
+        val layer = compositorLayer ?: return
+        compositorLayer = null
+        if (layer.surface.isValid && eglCore.makeCurrent(layer.eglSurface, eglCore.eglContext)) {
+            eglCore.clearCurrentSurface()
+            eglCore.swapBuffers(layer.eglSurface)
+        }
+        eglCore.makeCurrentMain()
+        layer.release(eglCore)
+        displayMap.values.forEach { window ->
+            if (window.isComposited) {
+                window.isComposited = false
+                window.initEGLSurface(eglCore)
+                window.isDirty = true
+            }
+        }
+        requestRender()
+    }
+
+    override fun handleLayoutRect(x5Surface: Surface, rect: Rect) {
+        val window = displayMap[x5Surface] ?: return
+        if (window.layerRect != rect) {
+            window.layerRect = Rect(rect)
+            compositorLayer?.isDirty = true
+            requestRender()
+        }
+    }
+
+    /**
+     * 图层或窗口被标脏后请求重绘。持续渲染的管线无需处理；
+     * 按新帧信号驱动的管线借此在没有新帧时也能及时刷新画面
+     */
+    protected open fun requestRender() {}
+
+    /**
+     * 为新窗口准备渲染目标：挂载了合成图层且客户端给出布局矩形时作为瓦片加入图层，
+     * 并把其独立画布清为透明以透出下方的图层；否则创建独立的 EGL 表面
+     * @param window 新建的显示窗口
+     * @param client 窗口所属客户端
+     */
+    protected fun attachWindowTarget(window: DisplayWindow, client: IVideoRenderClient) {
+        val layer = compositorLayer
+        val rect = client.getLayoutRect()
+        if (layer != null && rect != null) {
+            window.isComposited = true
+            window.layerRect = Rect(rect)
+            if (window.x5Surface.isValid) clearNativeSurface(window.x5Surface)
+            layer.isDirty = true
+        } else {
+            window.initEGLSurface(eglCore)
+        }
+    }
+
+    /**
+     * 将所有合成窗口绘制到共享图层并只交换一次。
+     * 图层支持保留交换内容时只重绘有变化的瓦片；瓦片集合变化、待重绘瓦片与其他瓦片重叠，
+     * 或缓冲内容不确定时整张重绘。
+     * @return 本轮是否执行了合成
+     */
+    protected fun composeLayer(): Boolean {
+        val layer = compositorLayer ?: return false
+        if (!layer.surface.isValid) return false
+
+        var pendingTiles = 0
+        for (i in 0 until activeStreams.size) {
+            val stream = activeStreams[i]
+            val windows = stream.displayWindows
+            for (j in 0 until windows.size) {
+                val window = windows[j]
+                if (!window.isComposited || window.isParked) continue
+                val hasPendingFrame = stream.hasFirstFrame && window.presentedPts != stream.lastPts
+                window.pendingPresent = shouldPresentFrame(window, stream, hasPendingFrame, stream.lastPts)
+                if (window.pendingPresent) pendingTiles++
+            }
+        }
+        if (!layer.isDirty && pendingTiles == 0) return false
+        val isPartial = layer.isPreserved && !layer.isDirty && !hasOverlappingPendingTile()
+
+        try {
+            if (!eglCore.makeCurrent(layer.eglSurface, eglCore.eglContext)) return false
+            eglCore.setSwapInterval(0)
+            if (!isPartial) eglCore.clearCurrentSurface()
+            for (i in 0 until activeStreams.size) {
+                val stream = activeStreams[i]
+                val windows = stream.displayWindows
+                for (j in 0 until windows.size) {
+                    val window = windows[j]
+                    if (!window.isComposited || window.isParked) continue
+                    if (isPartial && !window.pendingPresent) continue
+                    val rect = window.layerRect ?: continue
+                    if (!layer.tileViewport(rect, tileViewport)) continue
+                    eglCore.beginTile(tileViewport[0], tileViewport[1], tileViewport[2], tileViewport[3])
+                    // 保留的缓冲里还留着上一帧的瓦片，先清掉，防止黑边区域残留旧画面
+                    if (isPartial) eglCore.clearCurrentSurface()
+                    stream.drawToWindow(window, tileViewport[2], tileViewport[3])
+                    eglCore.endTile()
+                    window.isDirty = false
+                    // 整张重绘时未到上屏时机的瓦片只是为了补回被清掉的区域，不算一次上屏，
+                    // 否则被限速的窗口会借其他瓦片的重绘越过帧率上限
+                    if (window.pendingPresent) {
+                        window.presentedPts = stream.lastPts
+                        stream.recordPresented()
+                    }
+                }
+            }
+            eglCore.swapBuffers(layer.eglSurface)
+            layer.isDirty = false
+            if (isPartial) layer.partialComposes++ else layer.fullComposes++
+        } catch (e: Exception) {
+            Log.e("VLCDecoder", "Layer compose failed: ${e.message}")
+        }
+        return true
+    }
+
+    /**
+     * 待重绘的瓦片是否与其他瓦片重叠：局部重绘会按绘制顺序盖住上层瓦片，只能整张重绘
+     */
+    private fun hasOverlappingPendingTile(): Boolean {
+        for (i in 0 until activeStreams.size) {
+            val windows = activeStreams[i].displayWindows
+            for (j in 0 until windows.size) {
+                val pending = windows[j]
+                if (!pending.isComposited || pending.isParked || !pending.pendingPresent) continue
+                val rect = pending.layerRect ?: continue
+                for (k in 0 until activeStreams.size) {
+                    val others = activeStreams[k].displayWindows
+                    for (m in 0 until others.size) {
+                        val other = others[m]
+                        if (other === pending || !other.isComposited || other.isParked) continue
+                        val otherRect = other.layerRect ?: continue
+                        if (Rect.intersects(rect, otherRect)) return true
+                    }
                 }
-                eglCore.destroySurface(tempEgl)
+            }
+        }
+        return false
+    }
+
+    /**
+     * 扇出上屏的统一判定：脏窗口无条件重绘，新帧先经帧节奏再经拥塞降频，被降频拦下的帧视为已处理
+     * @param window 目标窗口
+     * @param stream 窗口所属的流
+     * @param hasNewFrame 窗口是否有尚未呈现的新帧
+     * @param ptsNs 当前帧的时间戳
+     * @return true 表示本轮需要绘制该窗口
+     */
+    protected fun shouldPresentFrame(window: DisplayWindow, stream: T, hasNewFrame: Boolean, ptsNs: Long): Boolean {
+        if (window.isDirty) return true
+        if (!hasNewFrame || !framePacer.shouldPresent(window, stream, ptsNs)) return false
+        if (framePacer.passesThrottle(window)) return true
+        window.presentedPts = ptsNs
+        stream.counters.droppedByCongestion++
+        return false
+    }
+
+    /**
+     * 重新选出流的主窗口：客户端优先级最高者优先，同级取面积最大者，挂起的窗口不参与。
+     * 只有一个窗口的流该窗口即为主窗口
+     */
+    protected fun updateFanOut(stream: T) {
+        val windows = stream.displayWindows
+        var primary: DisplayWindow? = null
+        var bestPriority = -1
+        var bestArea = -1L
+        windows.forEach { window ->
+            if (window.isParked) return@forEach
+            val priority = window.clientRef.get()?.getPriority()?.ordinal ?: 0
+            val area = window.physicalW.toLong() * window.physicalH
+            if (priority > bestPriority || (priority == bestPriority && area > bestArea)) {
+                primary = window
+                bestPriority = priority
+                bestArea = area
+            }
+        }
+        windows.forEach { window ->
+            val isPrimary = window === primary
+            if (window.isPrimary != isPrimary) {
+                window.isPrimary = isPrimary
+                window.throttleTick = 0
             }
         }
     }
 
     protected fun handleStreamDead(url: String) {
-        val dead = streams.remove(url) ?: return
+        warmStreams.remove(url)?.let { warm ->
+            releaseStream(warm)
+            onStreamDeadCleanup(url, emptyList())
+            return
+        }
+        idleStreams.remove(url)?.let { idle ->
+            pendingReleaseTasks.remove(url)?.let { handler.removeCallbacks(it) }
+            releaseIdleStream(url, idle)
+            return
+        }
+        val dead = removeActiveStream(url) ?: return
         pendingReleaseTasks.remove(url)?.let { handler.removeCallbacks(it) }
 
         val deadSurfaces = mutableListOf<Surface>()
         dead.displayWindows.forEach { window ->
-            val key = displayMap.entries.find { it.value == window }?.key
-            if (key != null) {
-                displayMap.remove(key)
-                deadSurfaces.add(key)
+            if (displayMap.remove(window.x5Surface) != null) {
+                deadSurfaces.add(window.x5Surface)
             }
+            if (window.isComposited) compositorLayer?.isDirty = true
+            window.stream = null
             window.release(eglCore)
         }
-        dead.release()
+        releaseStream(dead)
         onStreamDeadCleanup(url, deadSurfaces)
     }
 
     override fun printNodeDiagnostics(nodeIndex: Int) {
         handler.post {
-            if (streams.isEmpty()) return@post
+            if (streams.isEmpty() && warmStreams.isEmpty() && idleStreams.isEmpty()) return@post
             Log.w("VLCDecoder", "------ Node-$nodeIndex ($nodeName) ------")
+            Log.w("VLCDecoder", "Load: ${getLoad()}")
+            Log.w(
+                "VLCDecoder", "CPU: %d affinity %s(%s) tick big %.2fms little %.2fms".format(
+                    currentCpu, affinityCpus.ifEmpty { "none" }, if (isAffinityApplied) "applied" else "kernel", avgTickBigMs, avgTickLittleMs
+                )
+            )
+            Log.w("VLCDecoder", "FBO pool: ${eglCore.framebufferPool.describe()} global %.1f/%.1fMB".format(
+                GpuMemoryBudget.totalBytes / 1048576f, GpuMemoryBudget.budgetBytes / 1048576f
+            ))
+            compositorLayer?.let { layer ->
+                Log.w("VLCDecoder", "Layer: preserved ${layer.isPreserved} full ${layer.fullComposes} partial ${layer.partialComposes}")
+            }
+            Log.w("VLCDecoder", "Fan-out pressure ${framePacer.nodePressure}")
+            Log.w("VLCDecoder", "Linger: $lingerPolicy Idle ${idleStreams.size} Hits $lingerHits Misses $lingerMisses")
+            idleStreams.forEach { (url, stream) ->
+                Log.i("VLCDecoder", "[Idle] $url decoding: ${stream.isDecoding}")
+            }
+            warmStreams.forEach { (url, stream) ->
+                Log.i("VLCDecoder", "[Warm] $url first frame: ${stream.hasFirstFrame}")
+            }
             var index = 1
             streams.forEach { (url, stream) ->
                 Log.i("VLCDecoder", "[$index] Stream URL: $url")
                 Log.i("VLCDecoder", "    |- Is Decoding : ${stream.isDecoding}")
+                if (stream.isParked) {
+                    Log.i("VLCDecoder", "    |- Parked for ${System.currentTimeMillis() - stream.parkedAtMs}ms")
+                }
                 Log.i("VLCDecoder", "    |- Active Surfaces: ${stream.displayWindows.size}")
-                val isPending = pendingReleaseTasks.containsKey(url)
-                Log.i("VLCDecoder", "    |- Is Pending Release: $isPending")
+                Log.i("VLCDecoder", "    |- Direct OES Render: ${!stream.shouldCopyToFBO()}")
+                Log.i("VLCDecoder", "    |- Resolution Tier: ${stream.resolutionTier} (${stream.videoWidth}x${stream.videoHeight}) -> ${stream.playingUrl}")
+                Log.i("VLCDecoder", "    |- Source FPS: %.1f, Target FPS: %.1f".format(stream.sourceFps, stream.targetFps))
                 stream.displayWindows.forEachIndexed { winIndex, window ->
                     val surfaceHex = Integer.toHexString(window.x5Surface.hashCode())
-                    Log.i("VLCDecoder", "       |- Surface_$winIndex @$surfaceHex -> Size: ${window.physicalW}x${window.physicalH}")
+                    val role = if (window.isPrimary) "primary" else "secondary"
+                    Log.i("VLCDecoder", "       |- Surface_$winIndex @$surfaceHex -> Size: ${window.physicalW}x${window.physicalH} $role throttle ${window.congestionLevel}${if (window.isParked) " (parked)" else ""}")
                 }
                 index++
             }
         }
     }
 
+    /**
+     * 新流因超出负载上限被拒绝时通知调度池回收路由
+     * @param url 被拒绝的视频流地址
+     */
+    protected fun handleStreamRejected(url: String) {
+        Log.w("VLCDecoder", "Stream rejected by limit on $nodeName: $url")
+        lastRejectedUrl = url
+        onStreamDeadCleanup(url, emptyList())
+    }
+
     @CallSuper
     override fun clearWorkspace() {
         pendingReleaseTasks.values.forEach { handler.removeCallbacks(it) }
         pendingReleaseTasks.clear()
+        pendingTierTasks.values.forEach { handler.removeCallbacks(it) }
+        pendingTierTasks.clear()
 
         eglCore.makeCurrentMain()
-        streams.values.forEach { it.release() }
+        streams.values.forEach { releaseStream(it) }
         streams.clear()
+        activeStreams.clear()
+        heldStreams.clear()
+        warmStreams.values.forEach { releaseStream(it) }
+        warmStreams.clear()
+        idleStreams.values.forEach { releaseStream(it) }
+        idleStreams.clear()
+        refreshIdleLoad()
         displayMap.values.forEach { it.release(eglCore) }
         displayMap.clear()
+        compositorLayer?.let { layer ->
+            if (layer.surface.isValid && eglCore.makeCurrent(layer.eglSurface, eglCore.eglContext)) {
+                eglCore.clearCurrentSurface()
+                eglCore.swapBuffers(layer.eglSurface)
+            }
+            eglCore.makeCurrentMain()
+            layer.isDirty = true
+        }
+    }
+
+    /**
+     * 释放流并计入在途释放数，播放器通道与回投的 GL 清理全部完成后才减一
+     */
+    private fun releaseStream(stream: T) {
+        pendingStreamReleases++
+        stream.release {
+            pendingStreamReleases--
+            if (pendingStreamReleases != 0) return@release
+            // 超时收尾后迟到的释放也在这里归零，此时才能安全销毁引擎
+            if (isDestroyed) releaseEngineAndQuit() else if (isDestroying) finishDestroy(releaseEngine = true)
+        }
     }
 
-    override fun destroyNode() {
-        clearWorkspace()
+    /**
+     * 彻底销毁节点：先清空工作区，等所有流的播放器在各自通道上释放完毕，再释放 EGL 与本节点的 LibVLC 实例。
+     * 播放器卡死超过期限时先交还 EGL，线程与引擎保留到迟到的释放全部回投之后再销毁
+     */
+    override fun destroyNode(onDestroyed: () -> Unit) {
         handler.post {
-            eglCore.release()
-            thread.quitSafely()
+            this.onDestroyed = onDestroyed
+            clearWorkspace()
+            isDestroying = true
+            if (pendingStreamReleases == 0) {
+                finishDestroy(releaseEngine = true)
+            } else {
+                handler.postDelayed({ finishDestroy(releaseEngine = false) }, DESTROY_DRAIN_TIMEOUT_MS)
+            }
+        }
+    }
+
+    private fun finishDestroy(releaseEngine: Boolean) {
+        if (isDestroyed) return
+        isDestroyed = true
+        handler.removeCallbacksAndMessages(null)
+        compositorLayer?.release(eglCore)
+        compositorLayer = null
+        eglCore.release()
+        if (releaseEngine) {
+            releaseEngineAndQuit()
+        } else {
+            Log.w("VLCDecoder", "$nodeName destroyed with $pendingStreamReleases player releases pending, engine release deferred")
         }
     }
+
+    private fun releaseEngineAndQuit() {
+        VLCEngineManager.releaseNodeEngine(engineIndex)
+        thread.quitSafely()
+        onDestroyed?.invoke()
+        onDestroyed = null
+    }
+
+    companion object {
+        /** 窗口尺寸稳定多久后才调整解码档位 */
+        private const val TIER_DEBOUNCE_MS = 500L
+
+        /** 每隔多少轮渲染循环采样一次节点线程所在核心 */
+        private const val CPU_SAMPLE_INTERVAL = 32
+
+        /** 销毁节点时等待播放器释放的最长时间，略长于播放器操作的隔离期限 */
+        private const val DESTROY_DRAIN_TIMEOUT_MS = 5_000L
+    }
 }
\ No newline at end of file
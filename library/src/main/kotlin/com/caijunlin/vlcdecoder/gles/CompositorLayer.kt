@@ -0,0 +1,86 @@
+package com.caijunlin.vlcdecoder.gles
+
+import android.graphics.Rect
+import android.opengl.EGL14
+import android.opengl.EGLSurface
+import android.view.Surface
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 合成模式下的共享图层：一张覆盖整个 WebView 的原生画布，
+ * 页面上所有合成窗口按各自的布局矩形绘制为其中的瓦片，每轮只做一次 makeCurrent 与 swapBuffers。
+ */
+class CompositorLayer(val surface: Surface, width: Int, height: Int) {
+
+    /** 图层的物理像素宽度 */
+    @Volatile
+    var width: Int = width
+        private set
+
+    /** 图层的物理像素高度 */
+    @Volatile
+    var height: Int = height
+        private set
+
+    /** 基于图层画布创建的 EGL 渲染表面 */
+    var eglSurface: EGLSurface = EGL14.EGL_NO_SURFACE
+        private set
+
+    /** 布局或瓦片集合发生变化，下一轮必须整张重新合成 */
+    @Volatile
+    var isDirty = true
+
+    /** 交换后是否保留缓冲内容，保留时只需重绘有变化的瓦片 */
+    var isPreserved = false
+        private set
+
+    /** 整张合成与只重绘部分瓦片的次数，用于节点诊断 */
+    var fullComposes = 0L
+    var partialComposes = 0L
+
+    /**
+     * 更新图层尺寸
+     * @param width 新的物理像素宽度
+     * @param height 新的物理像素高度
+     */
+    fun resize(width: Int, height: Int) {
+        if (this.width != width || this.height != height) {
+            this.width = width
+            this.height = height
+            isDirty = true
+        }
+    }
+
+    /**
+     * 将以左上角为原点的布局矩形换算为 GL 左下角原点的视口
+     * @param rect 瓦片在图层中的布局矩形(物理像素)
+     * @param out 输出 [x, y, width, height]
+     * @return 瓦片与图层有交集时返回 true
+     */
+    fun tileViewport(rect: Rect, out: IntArray): Boolean {
+        if (rect.width() <= 0 || rect.height() <= 0) return false
+        if (rect.right <= 0 || rect.bottom <= 0 || rect.left >= width || rect.top >= height) return false
+        out[0] = rect.left
+        out[1] = height - rect.bottom
+        out[2] = rect.width()
+        out[3] = rect.height()
+        return true
+    }
+
+    fun initEGLSurface(eglCore: EGLCore) {
+        if (eglSurface == EGL14.EGL_NO_SURFACE) {
+            eglSurface = eglCore.createWindowSurface(surface, preserveContents = true)
+            isPreserved = eglSurface != EGL14.EGL_NO_SURFACE && eglCore.enablePreservedSwap(eglSurface)
+            isDirty = true
+        }
+    }
+
+    fun release(eglCore: EGLCore) {
+        if (eglSurface != EGL14.EGL_NO_SURFACE) {
+            eglCore.destroySurface(eglSurface)
+            eglSurface = EGL14.EGL_NO_SURFACE
+        }
+        isPreserved = false
+    }
+}
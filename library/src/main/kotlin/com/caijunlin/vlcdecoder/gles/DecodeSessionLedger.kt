@@ -0,0 +1,150 @@
+package com.caijunlin.vlcdecoder.gles
+
+import com.caijunlin.vlcdecoder.core.CodecBudget
+import com.caijunlin.vlcdecoder.core.DecoderCapabilities
+import org.json.JSONObject
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 单路流的解码方式
+ */
+enum class DecodeMode {
+    /** 尚未分配 */
+    UNKNOWN,
+
+    /** 占用一个 MediaCodec 硬件实例 */
+    HARDWARE,
+
+    /** 硬件实例或吞吐耗尽，强制走 avcodec 软解 */
+    SOFTWARE
+}
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 全局硬解会话账本。按探测到的每种编码的实例上限与宏块吞吐给各路流分配硬件会话，
+ * 预算耗尽的流显式走软解并被压低档位，软解路数同样设上限，避免 MediaCodec 创建失败后静默退回单线程软解拖垮整机。
+ * 拉流前编码未知，先按 H.264 预占，首帧探测到真实编码后再改记到对应格式名下。
+ */
+class DecodeSessionLedger(private val budgetOf: (String) -> CodecBudget? = DecoderCapabilities::budgetOf) {
+
+    /** 允许同时软解的最大路数 */
+    @Volatile
+    var maxSoftwareStreams = (Runtime.getRuntime().availableProcessors() / 2).coerceAtLeast(1)
+
+    /** 估算宏块吞吐时采用的源帧率 */
+    @Volatile
+    var assumedFps = AdmissionController.DEFAULT_ASSUMED_FPS
+
+    private class Session(var mime: String, var macroblocksPerSecond: Long, var mode: DecodeMode)
+
+    /** 以流对象为键，迁移期间同一地址的新旧两路流各自记账 */
+    private val sessions = HashMap<Any, Session>()
+
+    /**
+     * 新流能否开始解码：尚有硬件会话，或软解路数未满
+     */
+    @Synchronized
+    fun canStart(tier: ResolutionTier): Boolean {
+        return hasHardwareCapacity(DecoderCapabilities.MIME_AVC, macroblocks(tier.width, tier.height)) ||
+            softwareCount() < maxSoftwareStreams
+    }
+
+    /**
+     * 为即将拉流的流预占解码会话
+     * @param owner 占用会话的流
+     * @return 分配到的解码方式
+     */
+    @Synchronized
+    fun acquire(owner: Any, width: Int, height: Int): DecodeMode {
+        sessions[owner]?.let { return it.mode }
+        val mime = DecoderCapabilities.MIME_AVC
+        val mbps = macroblocks(width, height)
+        val mode = if (hasHardwareCapacity(mime, mbps)) DecodeMode.HARDWARE else DecodeMode.SOFTWARE
+        sessions[owner] = Session(mime, mbps, mode)
+        return mode
+    }
+
+    /**
+     * 首帧探测到真实编码与尺寸后重新记账；硬件会话在新格式名下放不下时视为已被 VLC 退回软解
+     * @return 修正后的解码方式
+     */
+    @Synchronized
+    fun confirm(owner: Any, mime: String?, width: Int, height: Int, fps: Float): DecodeMode {
+        val session = sessions[owner] ?: return DecodeMode.UNKNOWN
+        val mbps = macroblocks(width, height, if (fps > 0f) fps else assumedFps)
+        val realMime = mime ?: session.mime
+        if (session.mode == DecodeMode.HARDWARE) {
+            sessions.remove(owner)
+            if (!hasHardwareCapacity(realMime, mbps)) session.mode = DecodeMode.SOFTWARE
+            sessions[owner] = session
+        }
+        session.mime = realMime
+        session.macroblocksPerSecond = mbps
+        return session.mode
+    }
+
+    @Synchronized
+    fun release(owner: Any) {
+        sessions.remove(owner)
+    }
+
+    @Synchronized
+    fun clear() {
+        sessions.clear()
+    }
+
+    /**
+     * 各编码格式的硬解占用情况
+     */
+    @Synchronized
+    fun toJson(): JSONObject {
+        val json = JSONObject()
+        val mimes = LinkedHashSet<String>().apply {
+            add(DecoderCapabilities.MIME_AVC)
+            add(DecoderCapabilities.MIME_HEVC)
+            sessions.values.forEach { add(it.mime) }
+        }
+        mimes.forEach { mime ->
+            val hw = sessions.values.filter { it.mime == mime && it.mode == DecodeMode.HARDWARE }
+            val budget = budgetOf(mime)
+            json.put(
+                mime, JSONObject()
+                    .put("hardwareSessions", hw.size)
+                    .put("hardwareMacroblocksPerSecond", hw.sumOf { it.macroblocksPerSecond })
+                    .put("maxInstances", budget?.maxInstances ?: 0)
+                    .put("maxMacroblocksPerSecond", budget?.maxMacroblocksPerSecond ?: 0L)
+                    .put("softwareSessions", sessions.values.count { it.mime == mime && it.mode == DecodeMode.SOFTWARE })
+            )
+        }
+        return json
+    }
+
+    private fun hasHardwareCapacity(mime: String, mbps: Long): Boolean {
+        // 探测失败（或设备不上报任何硬解）时不做限制，交给 VLC 自行选择
+        val budget = budgetOf(mime)
+            ?: return budgetOf(DecoderCapabilities.MIME_AVC) == null && budgetOf(DecoderCapabilities.MIME_HEVC) == null
+        var instances = 0
+        var used = 0L
+        sessions.values.forEach {
+            if (it.mime == mime && it.mode == DecodeMode.HARDWARE) {
+                instances++
+                used += it.macroblocksPerSecond
+            }
+        }
+        if (budget.maxInstances in 1..instances) return false
+        return budget.maxMacroblocksPerSecond <= 0L || used + mbps <= budget.maxMacroblocksPerSecond
+    }
+
+    private fun softwareCount(): Int = sessions.values.count { it.mode == DecodeMode.SOFTWARE }
+
+    private fun macroblocks(width: Int, height: Int, fps: Float = assumedFps): Long {
+        return ((width + 15) / 16).toLong() * ((height + 15) / 16) * fps.toLong().coerceAtLeast(1L)
+    }
+
+    companion object {
+        /** 软解流的档位上限，单线程 avcodec 解 720p 以上的流很难跟上源帧率 */
+        val SOFTWARE_MAX_TIER = ResolutionTier.P540
+    }
+}
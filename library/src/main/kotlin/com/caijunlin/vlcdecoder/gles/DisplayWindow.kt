@@ -1,7 +1,9 @@
 package com.caijunlin.vlcdecoder.gles
 
+import android.graphics.Rect
 import android.opengl.EGL14
 import android.opengl.EGLSurface
+import android.opengl.Matrix
 import android.view.Surface
 import java.lang.ref.WeakReference
 
@@ -10,7 +12,7 @@ import java.lang.ref.WeakReference
  * @date   2026/3/10
  * @description 显示窗口数据模型，彻底剥离业务状态，仅作为封装物理画布和矩阵参数的纯粹容器
  */
-class DisplayWindow(val x5Surface: Surface, client: IVideoRenderClient) {
+class DisplayWindow(val x5Surface: Surface, client: IVideoRenderClient) : PacedWindow {
 
     /** 客户端的弱引用，防止内存泄漏 */
     val clientRef = WeakReference(client)
@@ -30,7 +32,162 @@ class DisplayWindow(val x5Surface: Surface, client: IVideoRenderClient) {
     var physicalH: Int = 0
 
     /** 专属的图形变换矩阵数组用于渲染上屏时的坐标运算 */
-    val mvpMatrix = FloatArray(16)
+    val mvpMatrix = FloatArray(16).apply { Matrix.setIdentityM(this, 0) }
+
+    /** 画面在当前窗口内的适配模式 */
+    @Volatile
+    var scaleMode: ScaleMode = client.getScaleMode()
+        set(value) {
+            if (field != value) {
+                field = value
+                isDirty = true
+            }
+        }
+
+    /** 指回窗口所属的流，由节点在挂载/摘除窗口时维护，仅在节点线程访问 */
+    var stream: BaseDecoderStream? = null
+
+    /**
+     * 是否为所属流的主窗口：同一路流扇出到多个窗口时，优先级最高、面积最大的窗口为主窗口，
+     * 其余为副窗口，拥塞时副窗口先被降频、交换时排在主窗口之后。仅在节点线程访问
+     */
+    override var isPrimary = true
+
+    /** 拥塞降频级别，窗口每 2^level 个待上屏帧只呈现一帧，0 表示不降频，仅在节点线程访问 */
+    override var congestionLevel = 0
+
+    /** 降频级别下的帧计数 */
+    override var throttleTick = 0
+
+    /** 连续未超标的交换次数，累计到阈值后降频级别回落一级 */
+    override var cleanSwaps = 0
+
+    /** 合成图层本轮需要重绘该瓦片，由扫描阶段写入、绘制阶段读取 */
+    var pendingPresent = false
+
+    /** 窗口暂时不可见但保持绑定，渲染循环跳过该窗口，仅在节点线程访问 */
+    override var isParked = false
+
+    /** 首帧上屏的时间戳，-1 表示尚未出帧 */
+    @Volatile
+    var firstFrameAtMs = -1L
+        private set
+
+    /** 等待首帧的异步绑定回调 */
+    private var firstFrameListeners: ArrayList<(BindStatus, Long) -> Unit>? = null
+
+    /** 是否作为瓦片绘制到节点的共享合成图层，此时不占用独立的 EGL 表面 */
+    var isComposited = false
+
+    /** 合成模式下窗口在图层中的布局矩形(物理像素) */
+    @Volatile
+    var layerRect: Rect? = null
+
+    /** 窗口级别的目标上屏帧率，0 表示跟随源帧率 */
+    @Volatile
+    override var targetFps: Float = client.getTargetFps()
+
+    /** 帧节奏调度器计划的下一次上屏时间戳，仅在节点线程访问 */
+    override var nextPresentPtsNs = 0L
+
+    /** 最近一次呈现到本窗口的帧时间戳，用于判断是否存在尚未呈现的新帧 */
+    var presentedPts = 0L
+
+    /** 上一次计算矩阵时使用的参数，未变化时直接复用 */
+    private var mvpKeyW = -1
+    private var mvpKeyH = -1
+    private var mvpKeySrcW = -1
+    private var mvpKeySrcH = -1
+    private var mvpKeyDecodeH = -1
+    private var mvpKeyMode: ScaleMode? = null
+
+    /** 当前矩阵是否未铺满窗口，需要先清出透明黑边 */
+    var needsLetterbox = false
+        private set
+
+    /**
+     * 按窗口尺寸、画面尺寸与适配模式计算 MVP 矩阵，参数未变时不做任何运算
+     * @param sourceW 画面显示宽度（已计入像素宽高比）
+     * @param sourceH 画面显示高度
+     * @param decodeH 解码分辨率高度，CROP 模式按此 1:1 映射
+     */
+    fun updateMvpMatrix(sourceW: Int, sourceH: Int, decodeH: Int) {
+        val mode = scaleMode
+        if (mvpKeyW == physicalW && mvpKeyH == physicalH && mvpKeySrcW == sourceW &&
+            mvpKeySrcH == sourceH && mvpKeyDecodeH == decodeH && mvpKeyMode == mode
+        ) return
+        mvpKeyW = physicalW
+        mvpKeyH = physicalH
+        mvpKeySrcW = sourceW
+        mvpKeySrcH = sourceH
+        mvpKeyDecodeH = decodeH
+        mvpKeyMode = mode
+
+        var sx = 1f
+        var sy = 1f
+        if (physicalW > 0 && physicalH > 0 && sourceW > 0 && sourceH > 0) {
+            val windowAspect = physicalW.toFloat() / physicalH
+            val sourceAspect = sourceW.toFloat() / sourceH
+            when (mode) {
+                ScaleMode.FIT -> if (sourceAspect > windowAspect) sy = windowAspect / sourceAspect else sx = sourceAspect / windowAspect
+                ScaleMode.FILL -> if (sourceAspect > windowAspect) sx = sourceAspect / windowAspect else sy = windowAspect / sourceAspect
+                ScaleMode.CROP -> {
+                    // 保持画面宽高比，以解码高度作为 1:1 的像素基准
+                    val contentH = decodeH.coerceAtLeast(1).toFloat()
+                    sy = contentH / physicalH
+                    sx = contentH * sourceAspect / physicalW
+                }
+                ScaleMode.STRETCH -> Unit
+            }
+        }
+        Matrix.setIdentityM(mvpMatrix, 0)
+        Matrix.scaleM(mvpMatrix, 0, sx, sy, 1f)
+        needsLetterbox = sx < 1f || sy < 1f
+    }
+
+    /**
+     * 通知客户端首帧已上屏，并完成所有等待首帧的异步绑定
+     * @param url 视频流地址
+     */
+    fun notifyFirstFrame(url: String) {
+        if (firstFrameAtMs < 0L) firstFrameAtMs = System.currentTimeMillis()
+        clientRef.get()?.onFirstFrameRendered(url)
+        drainFirstFrameListeners(BindStatus.ACCEPTED, firstFrameAtMs)
+    }
+
+    /**
+     * 通知客户端流已死亡，等待首帧的异步绑定以失败结束
+     * @param url 视频流地址
+     */
+    fun notifyPlaybackFailed(url: String) {
+        clientRef.get()?.onPlaybackFailed(url)
+        drainFirstFrameListeners(BindStatus.PLAYBACK_FAILED, -1L)
+    }
+
+    /**
+     * 登记等待首帧的回调，已出帧时立即回调
+     * @param listener 回调 (状态, 首帧时间戳)
+     */
+    fun addFirstFrameListener(listener: (BindStatus, Long) -> Unit) {
+        val atMs = synchronized(this) {
+            if (firstFrameAtMs < 0L) {
+                val listeners = firstFrameListeners ?: ArrayList<(BindStatus, Long) -> Unit>(1).also { firstFrameListeners = it }
+                listeners.add(listener)
+                return
+            }
+            firstFrameAtMs
+        }
+        listener(BindStatus.ACCEPTED, atMs)
+    }
+
+    private fun drainFirstFrameListeners(status: BindStatus, atMs: Long) {
+        val listeners = synchronized(this) {
+            val pending = firstFrameListeners
+            firstFrameListeners = null
+            pending
+        } ?: return
+        listeners.forEach { it(status, atMs) }
+    }
 
     /**
      * 根据内部传入的物理画布向底层的 EGL 核心申请创建可渲染的图形表面对象
@@ -47,6 +204,7 @@ class DisplayWindow(val x5Surface: Surface, client: IVideoRenderClient) {
      * @param eglCore 底层图形渲染引擎核心实例
      */
     fun release(eglCore: EGLCore) {
+        drainFirstFrameListeners(BindStatus.NOT_BOUND, -1L)
         if (eglSurface != EGL14.EGL_NO_SURFACE) {
             eglCore.destroySurface(eglSurface)
             eglSurface = EGL14.EGL_NO_SURFACE
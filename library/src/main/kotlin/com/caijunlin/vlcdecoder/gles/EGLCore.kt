@@ -1,6 +1,11 @@
 package com.caijunlin.vlcdecoder.gles
 
 import android.graphics.Bitmap
+import android.graphics.ColorSpace
+import android.graphics.PixelFormat
+import android.hardware.HardwareBuffer
+import android.media.Image
+import android.media.ImageReader
 import android.opengl.EGL14
 import android.opengl.EGLConfig
 import android.opengl.EGLContext
@@ -9,11 +14,12 @@ import android.opengl.EGLExt
 import android.opengl.EGLSurface
 import android.opengl.GLES11Ext
 import android.opengl.GLES30
+import android.opengl.GLUtils
 import android.opengl.Matrix
+import android.os.Build
 import android.os.Handler
-import android.os.Looper
 import android.view.Surface
-import androidx.core.graphics.createBitmap
+import androidx.annotation.RequiresApi
 import java.nio.ByteBuffer
 import java.nio.ByteOrder
 import java.nio.FloatBuffer
@@ -44,9 +50,49 @@ class EGLCore {
     private var uTex2DMvpMatrixLoc = -1
     private var tex2DLoc = -1
 
+    /** 上屏着色器阶段的一个已编译变体 */
+    private class StageProgram(val id: Int) {
+        val mvpLoc = GLES30.glGetUniformLocation(id, "uMVPMatrix")
+        val texLoc = GLES30.glGetUniformLocation(id, "tex2D")
+        val texelLoc = GLES30.glGetUniformLocation(id, "uTexel")
+        val stepLoc = GLES30.glGetUniformLocation(id, "uStep")
+        val sharpnessLoc = GLES30.glGetUniformLocation(id, "uSharpness")
+        val brightnessLoc = GLES30.glGetUniformLocation(id, "uBrightness")
+        val contrastLoc = GLES30.glGetUniformLocation(id, "uContrast")
+    }
+
+    /** 仅供合成图层窗口表面使用、支持保留交换内容且与主配置兼容的像素配置，驱动不提供时为 null */
+    private var preservedConfig: EGLConfig? = null
+    private var preservedConfigId = 0
+
+    /** 合成图层能否使用保留交换内容的窗口表面 */
+    val supportsPreservedSwap: Boolean
+        get() = preservedConfig != null
+
+    /** 流的 FBO/纹理对复用池 */
+    val framebufferPool = FramebufferPool(this)
+
+    /** 按变体键缓存的着色器阶段程序，每个变体只编译一次 */
+    private val stagePrograms = HashMap<Int, StageProgram>()
+
     private val vertexBuffer: FloatBuffer
+
+    /** 合成图层中当前瓦片的视口原点，常规绘制时为 0 */
+    private var viewportX = 0
+    private var viewportY = 0
     private val identityMatrix = FloatArray(16).apply { Matrix.setIdentityM(this, 0) }
 
+    /**
+     * 零拷贝截帧的输出目标：ImageReader 及其包装出的 EGL 表面
+     * heldImages 保存仍被外部位图引用的图像，数量超限时才归还给缓冲队列
+     */
+    private class CaptureTarget(val reader: ImageReader, val eglSurface: EGLSurface) {
+        val heldImages = ArrayDeque<Image>()
+    }
+
+    /** 按输出尺寸复用的截帧目标池 */
+    private val captureTargets = HashMap<Long, CaptureTarget>()
+
     init {
         val vertices = floatArrayOf(
             -1f, -1f, 0f, 0f, 0f,
@@ -78,6 +124,7 @@ class EGLCore {
         val numConfigs = IntArray(1)
         EGL14.eglChooseConfig(eglDisplay, attributes, 0, configs, 0, 1, numConfigs, 0)
         eglConfig = configs[0]
+        choosePreservedConfig(attributes)
 
         val contextAttributes = intArrayOf(EGL14.EGL_CONTEXT_CLIENT_VERSION, 3, EGL14.EGL_NONE)
         eglContext = EGL14.eglCreateContext(eglDisplay, eglConfig, EGL14.EGL_NO_CONTEXT, contextAttributes, 0)
@@ -97,16 +144,64 @@ class EGLCore {
         tex2DLoc = GLES30.glGetUniformLocation(tex2DProgramId, "tex2D")
     }
 
+    /**
+     * 为合成图层另选一份支持保留交换内容的窗口配置。保留交换在部分 Mali/RK 驱动上更慢或缺失，
+     * 因此主上下文、离屏表面与普通窗口仍使用原配置；颜色格式与主配置不一致时放弃，避免与主上下文不兼容
+     */
+    private fun choosePreservedConfig(attributes: IntArray) {
+        preservedConfig = null
+        preservedConfigId = 0
+        val base = eglConfig ?: return
+        val preservedAttributes = attributes.copyOf(attributes.size - 1) + intArrayOf(
+            EGL14.EGL_SURFACE_TYPE, EGL14.EGL_WINDOW_BIT or EGL14.EGL_SWAP_BEHAVIOR_PRESERVED_BIT,
+            EGL14.EGL_NONE
+        )
+        val configs = arrayOfNulls<EGLConfig>(1)
+        val numConfigs = IntArray(1)
+        if (!EGL14.eglChooseConfig(eglDisplay, preservedAttributes, 0, configs, 0, 1, numConfigs, 0)) return
+        val candidate = configs[0] ?: return
+        if (numConfigs[0] <= 0) return
+        val compatible = COMPATIBLE_CONFIG_ATTRIBS.all { configAttrib(candidate, it) == configAttrib(base, it) }
+        if (!compatible) return
+        preservedConfig = candidate
+        preservedConfigId = configAttrib(candidate, EGL14.EGL_CONFIG_ID)
+    }
+
+    private fun configAttrib(config: EGLConfig, attribute: Int): Int {
+        val value = IntArray(1)
+        return if (EGL14.eglGetConfigAttrib(eglDisplay, config, attribute, value, 0)) value[0] else -1
+    }
+
     /**
      * 将上层应用提供的原生视图包装成硬件图形管线可识别的渲染表面
      * @param surface 上层提供的原生画布对象
+     * @param preserveContents 是否使用保留交换内容的配置，仅合成图层需要，驱动不支持或创建失败时退回普通配置
      * @return 构建成功的 EGL 渲染表面句柄
      */
-    fun createWindowSurface(surface: Surface): EGLSurface {
+    fun createWindowSurface(surface: Surface, preserveContents: Boolean = false): EGLSurface {
         val surfaceAttributes = intArrayOf(EGL14.EGL_NONE)
+        val preserved = preservedConfig
+        if (preserveContents && preserved != null) {
+            val eglSurface = EGL14.eglCreateWindowSurface(eglDisplay, preserved, surface, surfaceAttributes, 0)
+            if (eglSurface != null && eglSurface != EGL14.EGL_NO_SURFACE) return eglSurface
+        }
         return EGL14.eglCreateWindowSurface(eglDisplay, eglConfig, surface, surfaceAttributes, 0)
     }
 
+    /**
+     * 让窗口表面在交换后保留后台缓冲内容，随后只需重绘变化的区域。
+     * 只对以保留配置创建的表面生效，其余表面保持驱动默认的交换行为
+     * @param eglSurface 目标表面
+     * @return 表面不支持或驱动拒绝时返回 false，此时每次交换后缓冲内容不确定
+     */
+    fun enablePreservedSwap(eglSurface: EGLSurface): Boolean {
+        if (preservedConfig == null) return false
+        val configId = IntArray(1)
+        if (!EGL14.eglQuerySurface(eglDisplay, eglSurface, EGL14.EGL_CONFIG_ID, configId, 0)) return false
+        if (configId[0] != preservedConfigId) return false
+        return EGL14.eglSurfaceAttrib(eglDisplay, eglSurface, EGL14.EGL_SWAP_BEHAVIOR, EGL14.EGL_BUFFER_PRESERVED)
+    }
+
     /**
      * 释放废弃的底层图形渲染表面显存资源
      * @param eglSurface 需要被销毁的表面句柄
@@ -203,6 +298,24 @@ class EGLCore {
         return oesTextureId
     }
 
+    /**
+     * 将位图上传为标准二维纹理，用于封面等静态画面的展示
+     * @param bitmap 软件格式的位图
+     * @return 二维纹理标识符
+     */
+    fun uploadBitmapTexture(bitmap: Bitmap): Int {
+        val textures = IntArray(1)
+        GLES30.glGenTextures(1, textures, 0)
+        GLES30.glBindTexture(GLES30.GL_TEXTURE_2D, textures[0])
+        GLES30.glTexParameteri(GLES30.GL_TEXTURE_2D, GLES30.GL_TEXTURE_MIN_FILTER, GLES30.GL_LINEAR)
+        GLES30.glTexParameteri(GLES30.GL_TEXTURE_2D, GLES30.GL_TEXTURE_MAG_FILTER, GLES30.GL_LINEAR)
+        GLES30.glTexParameteri(GLES30.GL_TEXTURE_2D, GLES30.GL_TEXTURE_WRAP_S, GLES30.GL_CLAMP_TO_EDGE)
+        GLES30.glTexParameteri(GLES30.GL_TEXTURE_2D, GLES30.GL_TEXTURE_WRAP_T, GLES30.GL_CLAMP_TO_EDGE)
+        GLUtils.texImage2D(GLES30.GL_TEXTURE_2D, 0, bitmap, 0)
+        GLES30.glBindTexture(GLES30.GL_TEXTURE_2D, 0)
+        return textures[0]
+    }
+
     /**
      * 清理并销毁指定的图形纹理内存占用空间
      * @param textureId 需要删除的图形纹理硬件标识符
@@ -234,6 +347,29 @@ class EGLCore {
         GLES30.glBindFramebuffer(GLES30.GL_FRAMEBUFFER, 0)
     }
 
+    /**
+     * 单拷贝直出流程：跳过 FBO 中转，直接采样外部 OES 纹理绘制到当前绑定的窗口表面
+     * 纹理坐标由 transformMatrix 纠正，顶点坐标由 mvpMatrix 投射
+     * @param oesTextureId 提供原始画面源数据的外部纹理标识符
+     * @param transformMatrix 画面原始状态携带的纹理空间姿态纠正矩阵
+     * @param mvpMatrix 应用于图元顶点的空间变换及投影投射组合矩阵
+     * @param width 最终显像目标视口的物理像素宽度
+     * @param height 最终显像目标视口的物理像素高度
+     */
+    fun drawOESScreen(oesTextureId: Int, transformMatrix: FloatArray, mvpMatrix: FloatArray, width: Int, height: Int) {
+        GLES30.glBindFramebuffer(GLES30.GL_FRAMEBUFFER, 0)
+        GLES30.glViewport(viewportX, viewportY, width, height)
+        GLES30.glUseProgram(oesProgramId)
+        bindVertexData()
+        GLES30.glUniformMatrix4fv(uOesTransformMatrixLoc, 1, false, transformMatrix, 0)
+        GLES30.glUniformMatrix4fv(uOesMvpMatrixLoc, 1, false, mvpMatrix, 0)
+        GLES30.glActiveTexture(GLES30.GL_TEXTURE0)
+        GLES30.glBindTexture(GLES11Ext.GL_TEXTURE_EXTERNAL_OES, oesTextureId)
+        GLES30.glUniform1i(texOESLoc, 0)
+        GLES30.glDrawArrays(GLES30.GL_TRIANGLE_STRIP, 0, 4)
+        GLES30.glBindTexture(GLES11Ext.GL_TEXTURE_EXTERNAL_OES, 0)
+    }
+
     /**
      * 第二阶段渲染流程利用极高的性能将准备好的二维图像快速拷贝盖章到指定的屏幕位置区域
      * @param tex2DId 已完成颜色转码处理包含最终静态画面的二维纹理标识符
@@ -242,7 +378,7 @@ class EGLCore {
      * @param height 最终显像目标视口的物理像素高度
      */
     fun drawTex2DScreen(tex2DId: Int, mvpMatrix: FloatArray, width: Int, height: Int) {
-        GLES30.glViewport(0, 0, width, height)
+        GLES30.glViewport(viewportX, viewportY, width, height)
         GLES30.glUseProgram(tex2DProgramId)
         bindVertexData()
         GLES30.glUniformMatrix4fv(uTex2DMvpMatrixLoc, 1, false, mvpMatrix, 0)
@@ -253,6 +389,93 @@ class EGLCore {
         GLES30.glBindTexture(GLES30.GL_TEXTURE_2D, 0)
     }
 
+    /**
+     * 预编译当前画质参数下可能用到的全部着色器变体，并等待驱动完成延迟编译与链接，
+     * 首路流上屏时不再卡在着色器编译上
+     * @param enhancement 画质增强参数
+     */
+    fun warmUpStages(enhancement: ImageEnhancement) {
+        makeCurrentMain()
+        var flags = 0
+        if (enhancement.adjustsColor) flags = flags or ShaderStage.FLAG_COLOR
+        if (enhancement.deinterlace) flags = flags or ShaderStage.FLAG_DEINTERLACE
+        val scales = ArrayList<Int>(4)
+        scales.add(ShaderStage.SCALE_NONE)
+        if (enhancement.adaptiveScaling) {
+            scales.add(ShaderStage.SCALE_DOWN)
+            scales.add(ShaderStage.SCALE_MIPMAP)
+            if (enhancement.sharpness > 0f) scales.add(ShaderStage.SCALE_UP_SHARPEN)
+        }
+        scales.forEach { scale ->
+            val key = scale or flags
+            if (key != 0) stagePrograms.getOrPut(key) { StageProgram(createStageProgram(key)) }
+        }
+        GLES30.glFinish()
+    }
+
+    /**
+     * 经过着色器阶段把二维纹理绘制到当前窗口，按变体完成缩放滤波、锐化、调色与去隔行
+     * @param tex2DId 源二维纹理
+     * @param mvpMatrix 顶点变换矩阵
+     * @param width 视口宽度
+     * @param height 视口高度
+     * @param stageKey 由 ShaderStage.keyFor 计算出的变体键，0 时等价于 drawTex2DScreen
+     * @param srcWidth 源纹理宽度
+     * @param srcHeight 源纹理高度
+     * @param enhancement 画质增强参数
+     */
+    fun drawTex2DStage(
+        tex2DId: Int,
+        mvpMatrix: FloatArray,
+        width: Int,
+        height: Int,
+        stageKey: Int,
+        srcWidth: Int,
+        srcHeight: Int,
+        enhancement: ImageEnhancement
+    ) {
+        if (stageKey == 0) {
+            drawTex2DScreen(tex2DId, mvpMatrix, width, height)
+            return
+        }
+        val program = stagePrograms.getOrPut(stageKey) { StageProgram(createStageProgram(stageKey)) }
+        GLES30.glViewport(viewportX, viewportY, width, height)
+        GLES30.glUseProgram(program.id)
+        bindVertexData()
+        GLES30.glUniformMatrix4fv(program.mvpLoc, 1, false, mvpMatrix, 0)
+        GLES30.glUniform2f(program.texelLoc, 1f / srcWidth.coerceAtLeast(1), 1f / srcHeight.coerceAtLeast(1))
+        GLES30.glUniform1f(program.stepLoc, ShaderStage.downscaleStep(srcWidth, srcHeight, width, height))
+        GLES30.glUniform1f(program.sharpnessLoc, enhancement.sharpness)
+        GLES30.glUniform1f(program.brightnessLoc, enhancement.brightness)
+        GLES30.glUniform1f(program.contrastLoc, enhancement.contrast)
+        GLES30.glActiveTexture(GLES30.GL_TEXTURE0)
+        GLES30.glBindTexture(GLES30.GL_TEXTURE_2D, tex2DId)
+        GLES30.glUniform1i(program.texLoc, 0)
+        GLES30.glDrawArrays(GLES30.GL_TRIANGLE_STRIP, 0, 4)
+        GLES30.glBindTexture(GLES30.GL_TEXTURE_2D, 0)
+    }
+
+    /**
+     * 为 FBO 纹理重新生成 mipmap 链并切换到三线性过滤，供大倍率缩小时使用
+     * @param tex2DId FBO 挂载的二维纹理
+     */
+    fun generateMipmaps(tex2DId: Int) {
+        GLES30.glBindTexture(GLES30.GL_TEXTURE_2D, tex2DId)
+        GLES30.glTexParameteri(GLES30.GL_TEXTURE_2D, GLES30.GL_TEXTURE_MIN_FILTER, GLES30.GL_LINEAR_MIPMAP_LINEAR)
+        GLES30.glGenerateMipmap(GLES30.GL_TEXTURE_2D)
+        GLES30.glBindTexture(GLES30.GL_TEXTURE_2D, 0)
+    }
+
+    /**
+     * 恢复 FBO 纹理的普通双线性过滤
+     * @param tex2DId FBO 挂载的二维纹理
+     */
+    fun disableMipmaps(tex2DId: Int) {
+        GLES30.glBindTexture(GLES30.GL_TEXTURE_2D, tex2DId)
+        GLES30.glTexParameteri(GLES30.GL_TEXTURE_2D, GLES30.GL_TEXTURE_MIN_FILTER, GLES30.GL_LINEAR)
+        GLES30.glBindTexture(GLES30.GL_TEXTURE_2D, 0)
+    }
+
     /**
      * 向显卡管线的各个通道提交激活所需的顶点坐标值与材质纹理映射坐标数据
      */
@@ -329,6 +552,55 @@ class EGLCore {
         }
     }
 
+    /**
+     * 编译着色器阶段的一个变体，顶点着色器与二维直通程序相同
+     * @param stageKey 变体键
+     * @return 编译链接完成的着色器程序标识符
+     */
+    private fun createStageProgram(stageKey: Int): Int {
+        val v = GLES30.glCreateShader(GLES30.GL_VERTEX_SHADER).also {
+            GLES30.glShaderSource(it, """#version 300 es
+            layout(location = 0) in vec4 aPosition;
+            layout(location = 1) in vec4 aTexCoord;
+            uniform mat4 uMVPMatrix;
+            out vec2 vTexCoord;
+            void main() {
+                gl_Position = uMVPMatrix * aPosition;
+                vTexCoord = aTexCoord.xy;
+            }
+        """); GLES30.glCompileShader(it)
+        }
+        val f = GLES30.glCreateShader(GLES30.GL_FRAGMENT_SHADER).also {
+            GLES30.glShaderSource(it, ShaderStage.fragmentSource(stageKey)); GLES30.glCompileShader(it)
+        }
+        return GLES30.glCreateProgram().also {
+            GLES30.glAttachShader(it, v); GLES30.glAttachShader(it, f); GLES30.glLinkProgram(it)
+        }
+    }
+
+    /**
+     * 进入合成图层的瓦片绘制：之后的上屏绘制与清屏都被限定在该瓦片区域内
+     * @param x 瓦片视口左下角 X
+     * @param y 瓦片视口左下角 Y
+     * @param width 瓦片宽度
+     * @param height 瓦片高度
+     */
+    fun beginTile(x: Int, y: Int, width: Int, height: Int) {
+        viewportX = x
+        viewportY = y
+        GLES30.glEnable(GLES30.GL_SCISSOR_TEST)
+        GLES30.glScissor(x, y, width, height)
+    }
+
+    /**
+     * 结束瓦片绘制，恢复全表面的视口与清屏范围
+     */
+    fun endTile() {
+        viewportX = 0
+        viewportY = 0
+        GLES30.glDisable(GLES30.GL_SCISSOR_TEST)
+    }
+
     /**
      * 将当前绑定的 EGL 渲染表面清空为全透明状态，用于透出底层 HTML 或原生背景
      */
@@ -347,49 +619,33 @@ class EGLCore {
         EGLExt.eglPresentationTimeANDROID(eglDisplay, eglSurface, n)
     }
 
+    /** 常驻的 PBO 环形读回器，首次异步截帧时创建 */
+    private var pixelReadback: PixelReadback? = null
+
+    /** 同步截帧复用的直接内存缓冲区 */
+    private var syncReadBuffer: ByteBuffer? = null
+
     /**
-     * 利用 PBO (Pixel Buffer Object) 实现完全异步的零阻塞截帧。
-     * 发送读取指令后 CPU 瞬间返回，由 GPU 后台通过 DMA 搬运数据，彻底消灭截图造成的卡顿。
-     * @param fboId 数据源离屏 FBO
+     * 利用常驻 PBO 环实现完全异步的零阻塞截帧。
+     * 发送读取指令后 CPU 瞬间返回，由 GPU 后台通过 DMA 搬运数据，栅栏确认完成后才映射，彻底消灭截图造成的卡顿。
+     * @param tex2DId 数据源 FBO 挂载的二维纹理
      * @param width 截取宽度
      * @param height 截取高度
-     * @param renderHandler 发送回调的 Handler
-     * @param callback 成功或失败的闭包
-     */
-    fun readPixelsFromFBOAsync(fboId: Int, width: Int, height: Int, renderHandler: Handler, callback: (Bitmap?) -> Unit) {
-        val pbo = IntArray(1)
-        GLES30.glGenBuffers(1, pbo, 0)
-        GLES30.glBindBuffer(GLES30.GL_PIXEL_PACK_BUFFER, pbo[0])
-        GLES30.glBufferData(GLES30.GL_PIXEL_PACK_BUFFER, width * height * 4, null, GLES30.GL_STREAM_READ)
-        GLES30.glBindFramebuffer(GLES30.GL_FRAMEBUFFER, fboId)
-        GLES30.glReadPixels(0, 0, width, height, GLES30.GL_RGBA, GLES30.GL_UNSIGNED_BYTE, 0)
-        GLES30.glBindFramebuffer(GLES30.GL_FRAMEBUFFER, 0)
-        GLES30.glBindBuffer(GLES30.GL_PIXEL_PACK_BUFFER, 0)
-
-        renderHandler.postDelayed({
-            try {
-                makeCurrentMain()
-                GLES30.glBindBuffer(GLES30.GL_PIXEL_PACK_BUFFER, pbo[0])
-                val buffer = GLES30.glMapBufferRange(GLES30.GL_PIXEL_PACK_BUFFER, 0, width * height * 4, GLES30.GL_MAP_READ_BIT)
-                if (buffer != null) {
-                    val rawBitmap = createBitmap(width, height)
-                    (buffer as ByteBuffer).order(ByteOrder.nativeOrder())
-                    rawBitmap.copyPixelsFromBuffer(buffer)
-                    GLES30.glUnmapBuffer(GLES30.GL_PIXEL_PACK_BUFFER)
-                    val flipMatrix = android.graphics.Matrix().apply { postScale(1f, -1f) }
-                    val finalBitmap = Bitmap.createBitmap(rawBitmap, 0, 0, width, height, flipMatrix, true)
-                    rawBitmap.recycle()
-                    Handler(Looper.getMainLooper()).post { callback(finalBitmap) }
-                } else {
-                    Handler(Looper.getMainLooper()).post { callback(null) }
-                }
-            } catch (_: Exception) {
-                Handler(Looper.getMainLooper()).post { callback(null) }
-            } finally {
-                GLES30.glBindBuffer(GLES30.GL_PIXEL_PACK_BUFFER, 0)
-                GLES30.glDeleteBuffers(1, pbo, 0)
-            }
-        }, 5L)
+     * @param renderHandler 轮询栅栏所用的渲染线程 Handler
+     * @param callback 成功或失败的闭包（主线程）
+     */
+    fun readPixelsAsync(tex2DId: Int, width: Int, height: Int, renderHandler: Handler, callback: (Bitmap?) -> Unit) {
+        readPixelsBatchAsync(listOf(PixelReadback.Request(tex2DId, width, height, callback)), renderHandler)
+    }
+
+    /**
+     * 批量异步截帧：一次性为多路纹理发出读回指令并共用同一个栅栏
+     * @param requests 读回请求列表
+     * @param renderHandler 轮询栅栏所用的渲染线程 Handler
+     */
+    fun readPixelsBatchAsync(requests: List<PixelReadback.Request>, renderHandler: Handler) {
+        val readback = pixelReadback ?: PixelReadback(this).also { pixelReadback = it }
+        readback.submit(requests, renderHandler)
     }
 
     /**
@@ -401,22 +657,24 @@ class EGLCore {
             makeCurrentMain()
             GLES30.glBindFramebuffer(GLES30.GL_FRAMEBUFFER, fboId)
 
-            // 直接分配直接内存缓冲区
-            val buffer = ByteBuffer.allocateDirect(width * height * 4)
-            buffer.order(ByteOrder.nativeOrder())
+            // 复用直接内存缓冲区，容量不足时才重新分配
+            val size = width * height * 4
+            val buffer = syncReadBuffer?.takeIf { it.capacity() >= size }
+                ?: ByteBuffer.allocateDirect(size).order(ByteOrder.nativeOrder()).also { syncReadBuffer = it }
+            buffer.clear()
 
             // 同步阻塞读取，瞬间抽出画面
             GLES30.glReadPixels(0, 0, width, height, GLES30.GL_RGBA, GLES30.GL_UNSIGNED_BYTE, buffer)
             GLES30.glBindFramebuffer(GLES30.GL_FRAMEBUFFER, 0)
 
             buffer.rewind()
-            val rawBitmap = createBitmap(width, height)
+            val rawBitmap = CaptureBitmapPool.acquire(width, height)
             rawBitmap.copyPixelsFromBuffer(buffer)
 
             // 翻转图像（OpenGL 的 Y 轴与 Android 是反的）
             val flipMatrix = android.graphics.Matrix().apply { postScale(1f, -1f) }
             val finalBitmap = Bitmap.createBitmap(rawBitmap, 0, 0, width, height, flipMatrix, true)
-            rawBitmap.recycle()
+            CaptureBitmapPool.release(rawBitmap)
 
             return finalBitmap
         } catch (e: Exception) {
@@ -424,10 +682,81 @@ class EGLCore {
         }
     }
 
+    /**
+     * 零拷贝截帧：将 FBO 纹理按目标尺寸绘制到池化的 ImageReader 表面，直接包装其 HardwareBuffer 为位图。
+     * GPU 在绘制时顺带完成缩放与 Y 轴翻转，全程没有 glReadPixels 与 CPU 侧的像素拷贝。
+     * 返回的位图与 ImageReader 共享显存，同尺寸连续截帧超过 MAX_HELD_CAPTURES 次后最早的位图内容会被覆盖，
+     * 需要长期持有时请自行 copy。
+     * @param tex2DId 数据源 FBO 挂载的二维纹理
+     * @param width 输出宽度
+     * @param height 输出高度
+     * @return HARDWARE 格式的位图，失败时返回 null
+     */
+    @RequiresApi(Build.VERSION_CODES.Q)
+    fun captureHardwareBitmap(tex2DId: Int, width: Int, height: Int): Bitmap? {
+        if (width <= 0 || height <= 0) return null
+        val key = (width.toLong() shl 32) or height.toLong()
+        val target = captureTargets.getOrPut(key) {
+            val reader = ImageReader.newInstance(
+                width, height, PixelFormat.RGBA_8888, MAX_HELD_CAPTURES + 1,
+                HardwareBuffer.USAGE_GPU_COLOR_OUTPUT or HardwareBuffer.USAGE_GPU_SAMPLED_IMAGE
+            )
+            CaptureTarget(reader, createWindowSurface(reader.surface))
+        }
+        if (target.eglSurface == EGL14.EGL_NO_SURFACE) return null
+
+        while (target.heldImages.size >= MAX_HELD_CAPTURES) {
+            target.heldImages.removeFirst().close()
+        }
+        try {
+            if (!makeCurrent(target.eglSurface, eglContext)) return null
+            setSwapInterval(0)
+            clearCurrentSurface()
+            drawTex2DScreen(tex2DId, identityMatrix, width, height)
+            GLES30.glFinish()
+            swapBuffers(target.eglSurface)
+        } finally {
+            makeCurrentMain()
+        }
+
+        val image = target.reader.acquireLatestImage() ?: return null
+        val hardwareBuffer = image.hardwareBuffer
+        if (hardwareBuffer == null) {
+            image.close()
+            return null
+        }
+        val bitmap = Bitmap.wrapHardwareBuffer(hardwareBuffer, ColorSpace.get(ColorSpace.Named.SRGB))
+        hardwareBuffer.close()
+        if (bitmap == null) {
+            image.close()
+            return null
+        }
+        target.heldImages.addLast(image)
+        return bitmap
+    }
+
+    /**
+     * 释放全部截帧目标
+     */
+    private fun releaseCaptureTargets() {
+        captureTargets.values.forEach { target ->
+            target.heldImages.forEach { it.close() }
+            target.heldImages.clear()
+            if (target.eglSurface != EGL14.EGL_NO_SURFACE) destroySurface(target.eglSurface)
+            target.reader.close()
+        }
+        captureTargets.clear()
+    }
+
     /**
      * 彻底解绑硬件图形环境并摧毁引擎核心中占用的底层资源池空间防范系统内存泄露风险
      */
     fun release() {
+        framebufferPool.release()
+        releaseCaptureTargets()
+        pixelReadback?.release()
+        pixelReadback = null
+        syncReadBuffer = null
         if (eglDisplay != EGL14.EGL_NO_DISPLAY) {
             EGL14.eglMakeCurrent(eglDisplay, EGL14.EGL_NO_SURFACE, EGL14.EGL_NO_SURFACE, EGL14.EGL_NO_CONTEXT)
             EGL14.eglDestroySurface(eglDisplay, dummySurface)
@@ -435,9 +764,22 @@ class EGLCore {
             EGL14.eglTerminate(eglDisplay)
         }
         eglDisplay = EGL14.EGL_NO_DISPLAY
+        preservedConfig = null
         eglContext = EGL14.EGL_NO_CONTEXT
         dummySurface = EGL14.EGL_NO_SURFACE
         oesProgramId = 0
         tex2DProgramId = 0
+        stagePrograms.clear()
+    }
+
+    companion object {
+        /** 同一尺寸下允许同时被外部位图引用的截帧数量 */
+        private const val MAX_HELD_CAPTURES = 2
+
+        /** 合成图层配置必须与主配置一致的属性，保证表面能与主上下文一同绑定 */
+        private val COMPATIBLE_CONFIG_ATTRIBS = intArrayOf(
+            EGL14.EGL_RED_SIZE, EGL14.EGL_GREEN_SIZE, EGL14.EGL_BLUE_SIZE, EGL14.EGL_ALPHA_SIZE,
+            EGL14.EGL_DEPTH_SIZE, EGL14.EGL_STENCIL_SIZE, EGL14.EGL_NATIVE_VISUAL_ID
+        )
     }
 }
\ No newline at end of file
@@ -0,0 +1,218 @@
+package com.caijunlin.vlcdecoder.gles
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 两种渲染管线共用的帧节奏调度器。
+ * 源帧率由 SurfaceTexture 时间戳估算，每个窗口的目标帧率取 窗口目标 / 流目标 / 全局上限 中最小的非零值，
+ * 按 PTS 相位决定本帧是否上屏，使 30/50fps 源被均匀抽帧，而不是依赖固定的轮询周期。
+ */
+class FramePacer {
+
+    /** 全局上屏帧率上限，0 表示不设上限，由调度池下发 */
+    @Volatile
+    var maxFps = DEFAULT_MAX_FPS
+
+    /** 节点整体的拥塞压力，渲染循环耗时逼近节奏间隔时升高；只作用于副窗口，仅在节点线程访问 */
+    var nodePressure = 0
+        private set
+
+    private var pressureHoldTicks = 0
+
+    /**
+     * 计算窗口实际生效的目标帧率
+     * @return 目标帧率，0 表示跟随源帧率全速上屏
+     */
+    fun effectiveFps(window: PacedWindow, stream: PacedStream): Float {
+        var fps = 0f
+        fps = minPositive(fps, window.targetFps)
+        fps = minPositive(fps, stream.targetFps)
+        fps = minPositive(fps, maxFps)
+        return fps
+    }
+
+    /**
+     * 基于帧时间戳判断当前帧是否应当呈现到窗口上，调用即视为做出决定并推进窗口的呈现相位
+     * @param window 目标窗口
+     * @param stream 画面所属的流
+     * @param ptsNs 当前帧的时间戳
+     * @return true 表示本帧需要上屏
+     */
+    fun shouldPresent(window: PacedWindow, stream: PacedStream, ptsNs: Long): Boolean {
+        val target = effectiveFps(window, stream)
+        val sourceFps = stream.sourceFps
+        if (target <= 0f || sourceFps <= 0f || target >= sourceFps * 0.95f || ptsNs <= 0L) {
+            window.nextPresentPtsNs = 0L
+            return true
+        }
+        val intervalNs = (NANOS_PER_SECOND / target).toLong()
+        // 容忍半个源帧的抖动，避免 PTS 轻微提前导致整帧被跳过
+        val toleranceNs = (NANOS_PER_SECOND / sourceFps / 2f).toLong()
+        val next = window.nextPresentPtsNs
+        if (next != 0L && ptsNs + toleranceNs < next) return false
+
+        // 相位锁定：在计划时刻的基础上推进，只有严重偏离(断流/跳变)时才以当前帧重新对齐
+        window.nextPresentPtsNs = if (next != 0L && ptsNs - next < intervalNs) next + intervalNs else ptsNs + intervalNs
+        return true
+    }
+
+    /**
+     * 拥塞降频判定：主窗口只受自身交换拥塞影响，副窗口还要叠加节点压力。
+     * 在 shouldPresent 放行之后调用，被降频拦下的帧计入拥塞丢帧
+     * @return true 表示本帧可以上屏
+     */
+    fun passesThrottle(window: PacedWindow): Boolean {
+        val level = if (window.isPrimary) window.congestionLevel else maxOf(window.congestionLevel, nodePressure)
+        if (level <= 0) return true
+        window.throttleTick++
+        return window.throttleTick and ((1 shl level) - 1) == 0
+    }
+
+    /**
+     * 记录一次交换耗时并调整降频级别。交换超标时优先把同一路流里级别最低的副窗口降一级，
+     * 副窗口都已降到底或本身就是副窗口时才降自己；连续若干次未超标后逐级恢复
+     * @param window 刚完成交换的窗口
+     * @param stream 窗口所属的流
+     * @param swapCostMs 交换耗时
+     */
+    fun onSwapped(window: PacedWindow, stream: PacedStream, swapCostMs: Float) {
+        if (swapCostMs <= SWAP_CONGESTED_MS) {
+            if (window.congestionLevel > 0 && ++window.cleanSwaps >= RECOVER_SWAPS) {
+                window.congestionLevel--
+                window.cleanSwaps = 0
+            }
+            return
+        }
+        window.cleanSwaps = 0
+        var victim: PacedWindow = window
+        if (window.isPrimary) {
+            val windows = stream.displayWindows
+            for (i in 0 until windows.size) {
+                val candidate = windows[i]
+                if (candidate.isPrimary || candidate.isParked || candidate.congestionLevel >= MAX_CONGESTION_LEVEL) continue
+                if (victim === window || candidate.congestionLevel < victim.congestionLevel) victim = candidate
+            }
+        }
+        if (victim.congestionLevel < MAX_CONGESTION_LEVEL) victim.congestionLevel++
+    }
+
+    /**
+     * 按循环平均耗时更新节点压力：超过节奏间隔的 90% 升一级，低于一半时降一级
+     * @param costMs 循环的平均耗时
+     * @param intervalMs 当前的节奏间隔
+     */
+    fun updatePressure(costMs: Float, intervalMs: Long) {
+        if (intervalMs <= 0L) return
+        // 每次调整后保持若干轮，给降频留出见效的时间，避免压力在相邻几轮内直接冲到顶
+        if (pressureHoldTicks > 0) {
+            pressureHoldTicks--
+            return
+        }
+        pressureHoldTicks = PRESSURE_HOLD_TICKS
+        if (costMs > intervalMs * 0.9f) {
+            if (nodePressure < MAX_CONGESTION_LEVEL) nodePressure++
+        } else if (costMs < intervalMs * 0.5f && nodePressure > 0) {
+            nodePressure--
+        }
+    }
+
+    /**
+     * 计算轮询式管线下一次醒来的间隔：按活跃流中最高的源帧率略快地轮询，保证每一帧都能被及时取走
+     * @param streams 节点上的所有流
+     * @param costMs 本轮循环已耗费的时间
+     * @return 下一次轮询的延时(毫秒)
+     */
+    fun nextPollDelayMs(streams: List<PacedStream>, costMs: Long): Long {
+        val periodMs = pacingIntervalMs(streams)
+        return if (costMs < periodMs) periodMs - costMs else MIN_DELAY_MS
+    }
+
+    /**
+     * 渲染循环两轮之间的最短间隔：按活跃流中最高的源帧率略快于源帧率，源帧率未知时退回 40ms
+     * @param streams 节点上的所有流
+     */
+    fun pacingIntervalMs(streams: List<PacedStream>): Long {
+        var fastestFps = 0f
+        for (i in 0 until streams.size) {
+            val stream = streams[i]
+            if (stream.displayWindows.isEmpty()) continue
+            if (stream.sourceFps > fastestFps) fastestFps = stream.sourceFps
+        }
+        return if (fastestFps > 0f) {
+            (1000f / (fastestFps * POLL_OVERSAMPLE)).toLong().coerceIn(MIN_POLL_MS, MAX_POLL_MS)
+        } else {
+            DEFAULT_POLL_MS
+        }
+    }
+
+    private fun minPositive(current: Float, candidate: Float): Float {
+        if (candidate <= 0f) return current
+        return if (current <= 0f || candidate < current) candidate else current
+    }
+
+    companion object {
+        /** 默认全局上屏上限，与原手机端“隔帧渲染”的让位策略保持一致 */
+        const val DEFAULT_MAX_FPS = 30f
+        /** 事件驱动管线收到首个新帧信号后等待的合批窗口，让同一时刻到达的多路帧合并为一轮渲染 */
+        const val FRAME_COALESCE_MS = 4L
+        private const val NANOS_PER_SECOND = 1_000_000_000f
+        /** 轮询频率相对源帧率的过采样倍数，防止两帧落在同一个轮询间隔内造成积压 */
+        private const val POLL_OVERSAMPLE = 1.25f
+        private const val DEFAULT_POLL_MS = 40L
+        private const val MIN_POLL_MS = 8L
+        private const val MAX_POLL_MS = 100L
+        private const val MIN_DELAY_MS = 5L
+        /** 单次交换超过该耗时视为缓冲队列拥塞 */
+        private const val SWAP_CONGESTED_MS = 25f
+        /** 最高降频级别，即最多每 8 帧呈现一帧 */
+        private const val MAX_CONGESTION_LEVEL = 3
+        /** 连续多少次交换未超标后恢复一级 */
+        private const val RECOVER_SWAPS = 30
+        /** 节点压力两次调整之间至少间隔的循环轮数 */
+        private const val PRESSURE_HOLD_TICKS = 15
+    }
+}
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 帧节奏调度读写的窗口状态，由 DisplayWindow 实现，仅在节点线程访问
+ */
+interface PacedWindow {
+    /** 窗口级别的目标上屏帧率，0 表示跟随源帧率 */
+    val targetFps: Float
+
+    /** 计划的下一次上屏时间戳 */
+    var nextPresentPtsNs: Long
+
+    /** 是否为所属流的主窗口 */
+    val isPrimary: Boolean
+
+    /** 是否挂起 */
+    val isParked: Boolean
+
+    /** 拥塞降频级别 */
+    var congestionLevel: Int
+
+    /** 降频级别下的帧计数 */
+    var throttleTick: Int
+
+    /** 连续未超标的交换次数 */
+    var cleanSwaps: Int
+}
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 帧节奏调度读取的流状态，由 BaseDecoderStream 实现
+ */
+interface PacedStream {
+    /** 流级别的目标上屏帧率，0 表示不限制 */
+    val targetFps: Float
+
+    /** 估算出的源帧率，0 表示尚未测得 */
+    val sourceFps: Float
+
+    /** 订阅该流的全部窗口 */
+    val displayWindows: List<PacedWindow>
+}
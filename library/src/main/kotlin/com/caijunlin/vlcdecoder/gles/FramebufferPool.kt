@@ -0,0 +1,173 @@
+package com.caijunlin.vlcdecoder.gles
+
+import android.opengl.GLES30
+import java.util.concurrent.atomic.AtomicLong
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 全局显存预算。统计所有节点中流正在使用与池中闲置的 FBO 纹理字节数，
+ * 准入控制据此拒绝会撑爆显存的新流，各节点的 FBO 池在总量超出预算时优先销毁闲置的缓冲。
+ */
+object GpuMemoryBudget {
+
+    /** 显存预算(字节)，默认约等于 24 路 720p 的 RGBA 缓冲 */
+    @Volatile
+    var budgetBytes = 24L * 1280 * 720 * 4
+
+    private val liveBytes = AtomicLong(0L)
+    private val pooledBytes = AtomicLong(0L)
+
+    fun bytesOf(width: Int, height: Int): Long = width.toLong() * height * 4L
+
+    val usedBytes: Long get() = liveBytes.get()
+    val idleBytes: Long get() = pooledBytes.get()
+    val totalBytes: Long get() = liveBytes.get() + pooledBytes.get()
+
+    internal fun addLive(delta: Long) {
+        liveBytes.addAndGet(delta)
+    }
+
+    internal fun addPooled(delta: Long) {
+        pooledBytes.addAndGet(delta)
+    }
+}
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 单个 EGLCore 内的 FBO/纹理对复用池，按尺寸分组。
+ * 流的启动、换档与释放不再反复申请和销毁显存，闲置的缓冲在同尺寸的下一路流上直接复用，
+ * 避免共享内存 SoC 上频繁的大块分配造成碎片与长时间卡顿。仅在所属节点线程访问。
+ * @param eglCore 缓冲所属的渲染引擎
+ * @param maxPooledPerSize 每种尺寸最多保留的闲置缓冲数
+ */
+class FramebufferPool(private val eglCore: EGLCore, private val maxPooledPerSize: Int = 4) {
+
+    private class Framebuffer(val fboId: Int, val texId: Int, val width: Int, val height: Int) {
+        val bytes = GpuMemoryBudget.bytesOf(width, height)
+    }
+
+    /** 正在被流使用的缓冲，以 FBO 标识符为键 */
+    private val live = HashMap<Int, Framebuffer>()
+
+    /** 闲置缓冲，按尺寸分组，整体按归还先后排序 */
+    private val free = LinkedHashMap<Long, ArrayDeque<Framebuffer>>()
+
+    private var hits = 0L
+    private var misses = 0L
+    private var liveBytes = 0L
+    private var pooledBytes = 0L
+
+    private fun keyOf(width: Int, height: Int): Long = (width.toLong() shl 32) or height.toLong()
+
+    /**
+     * 取出一个指定尺寸的缓冲，池中没有时新建
+     * @return [FBO 标识符, 纹理标识符]
+     */
+    fun acquire(width: Int, height: Int): IntArray {
+        val key = keyOf(width, height)
+        val queue = free[key]
+        val reused = queue?.removeFirstOrNull()
+        if (queue != null && queue.isEmpty()) free.remove(key)
+        val fb = if (reused != null) {
+            hits++
+            pooledBytes -= reused.bytes
+            GpuMemoryBudget.addPooled(-reused.bytes)
+            // 复用的缓冲残留着上一路流的画面，清空后再交出去，防止新流出帧前闪出旧画面
+            GLES30.glBindFramebuffer(GLES30.GL_FRAMEBUFFER, reused.fboId)
+            GLES30.glClearColor(0f, 0f, 0f, 0f)
+            GLES30.glClear(GLES30.GL_COLOR_BUFFER_BIT)
+            GLES30.glBindFramebuffer(GLES30.GL_FRAMEBUFFER, 0)
+            reused
+        } else {
+            misses++
+            trimToBudget(GpuMemoryBudget.bytesOf(width, height))
+            val ids = eglCore.createFBO(width, height)
+            Framebuffer(ids[0], ids[1], width, height)
+        }
+        live[fb.fboId] = fb
+        liveBytes += fb.bytes
+        GpuMemoryBudget.addLive(fb.bytes)
+        return intArrayOf(fb.fboId, fb.texId)
+    }
+
+    /**
+     * 归还一个缓冲
+     * @param reusable false 时直接销毁，例如纹理已生成 mipmap 链、尺寸不再匹配
+     */
+    fun recycle(fboId: Int, texId: Int, reusable: Boolean = true) {
+        val fb = live.remove(fboId)
+        if (fb == null) {
+            eglCore.deleteFBO(fboId, texId)
+            return
+        }
+        liveBytes -= fb.bytes
+        GpuMemoryBudget.addLive(-fb.bytes)
+        val key = keyOf(fb.width, fb.height)
+        val queue = free[key]
+        val overBudget = GpuMemoryBudget.totalBytes + fb.bytes > GpuMemoryBudget.budgetBytes
+        if (!reusable || overBudget || (queue?.size ?: 0) >= maxPooledPerSize) {
+            eglCore.deleteFBO(fb.fboId, fb.texId)
+            return
+        }
+        // 重新插入使该尺寸组排到最近使用的位置
+        free.remove(key)
+        free[key] = (queue ?: ArrayDeque()).apply { addLast(fb) }
+        pooledBytes += fb.bytes
+        GpuMemoryBudget.addPooled(fb.bytes)
+    }
+
+    /**
+     * 从最久未用的尺寸组开始销毁闲置缓冲，直到总量加上即将申请的字节数不超过预算
+     * @param incomingBytes 即将申请的字节数
+     */
+    fun trimToBudget(incomingBytes: Long = 0L) {
+        val iterator = free.entries.iterator()
+        while (iterator.hasNext() && GpuMemoryBudget.totalBytes + incomingBytes > GpuMemoryBudget.budgetBytes) {
+            val queue = iterator.next().value
+            while (queue.isNotEmpty() && GpuMemoryBudget.totalBytes + incomingBytes > GpuMemoryBudget.budgetBytes) {
+                val fb = queue.removeFirst()
+                pooledBytes -= fb.bytes
+                GpuMemoryBudget.addPooled(-fb.bytes)
+                eglCore.deleteFBO(fb.fboId, fb.texId)
+            }
+            if (queue.isEmpty()) iterator.remove()
+        }
+    }
+
+    /**
+     * 销毁全部闲置缓冲，内存告急或节点销毁时调用
+     */
+    fun clearIdle() {
+        free.values.forEach { queue -> queue.forEach { eglCore.deleteFBO(it.fboId, it.texId) } }
+        free.clear()
+        GpuMemoryBudget.addPooled(-pooledBytes)
+        pooledBytes = 0L
+    }
+
+    /**
+     * 上下文销毁前调用，清空全部记账；显存随上下文一并释放
+     */
+    fun release() {
+        clearIdle()
+        GpuMemoryBudget.addLive(-liveBytes)
+        liveBytes = 0L
+        live.clear()
+    }
+
+    /** 池的使用情况摘要，用于节点诊断 */
+    fun describe(): String {
+        val idleCount = free.values.sumOf { it.size }
+        return "live ${live.size} (%.1fMB) idle $idleCount (%.1fMB) hits $hits misses $misses".format(
+            liveBytes / MB, pooledBytes / MB
+        )
+    }
+
+    val liveBufferBytes: Long get() = liveBytes
+    val idleBufferBytes: Long get() = pooledBytes
+
+    private companion object {
+        const val MB = 1024f * 1024f
+    }
+}
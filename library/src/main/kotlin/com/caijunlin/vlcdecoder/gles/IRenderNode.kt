@@ -1,6 +1,7 @@
 package com.caijunlin.vlcdecoder.gles
 
 import android.graphics.Bitmap
+import android.graphics.Rect
 import android.os.Handler
 import android.view.Surface
 
@@ -19,6 +20,12 @@ interface IRenderNode {
      */
     fun getActiveStreamCount(): Int
 
+    /**
+     * 获取当前渲染节点的实时负载快照，供调度器挑选放置节点
+     * @return 节点负载
+     */
+    fun getLoad(): NodeLoad
+
     /**
      * 处理外部的画布绑定请求，建立流与画布的联系
      * @param url 视频流地址
@@ -35,6 +42,19 @@ interface IRenderNode {
         limit: Int
     )
 
+    /**
+     * 预热指定的流：提前建立播放器、OES 纹理与 FBO 并开始缓冲，等待 handleBind 直接接管
+     * @param url 视频流地址
+     * @param opts 媒体配置参数
+     */
+    fun handlePreload(url: String, opts: ArrayList<String>)
+
+    /**
+     * 从预热池中淘汰指定的流并释放其资源
+     * @param url 视频流地址
+     */
+    fun handleEvictWarm(url: String)
+
     /**
      * 解绑指定的画布，如果流空闲将触发销毁
      * @param url 视频流地址
@@ -42,6 +62,18 @@ interface IRenderNode {
      */
     fun handleUnbind(url: String, x5Surface: Surface)
 
+    /**
+     * 立即释放闲置缓存中的指定流，用于准入控制回收额度，流不在闲置缓存时无操作
+     * @param url 视频流地址
+     */
+    fun handleEvictIdle(url: String)
+
+    /**
+     * 流被迁移到其他节点：摘下全部窗口并立即释放源流，不进入闲置缓存
+     * @param url 视频流地址
+     */
+    fun handleMigrateOut(url: String)
+
     /**
      * 处理画布的物理尺寸形变
      * @param x5Surface 目标画布
@@ -50,6 +82,13 @@ interface IRenderNode {
      */
     fun handleResize(x5Surface: Surface, width: Int, height: Int)
 
+    /**
+     * 切换画布的画面适配模式，仅影响下一次绘制的 MVP 矩阵
+     * @param x5Surface 目标画布
+     * @param mode 适配模式
+     */
+    fun handleScaleMode(x5Surface: Surface, mode: ScaleMode)
+
     /**
      * 截取指定画布当前的清晰画面
      * @param x5Surface 目标画布
@@ -57,7 +96,147 @@ interface IRenderNode {
      */
     fun handleCapture(x5Surface: Surface, callback: (Bitmap?) -> Unit)
 
-    fun handleCaptureSync(x5Surface: Surface): Bitmap?
+    /**
+     * 批量异步截取多个画布，节点内一次性发出全部读回指令并共用一个 GPU 栅栏
+     * @param x5Surfaces 目标画布列表
+     * @param callback 主线程回调，结果与传入顺序一一对应
+     */
+    fun handleCaptureBatch(x5Surfaces: List<Surface>, callback: (List<Bitmap?>) -> Unit)
+
+    /**
+     * 在节点线程上采样本节点与其所有流的运行指标，区间类数据采样后清零
+     * @param nodeIndex 节点索引
+     * @return 节点指标快照
+     */
+    fun collectMetrics(nodeIndex: Int): NodeMetrics
+
+    /**
+     * 布局事务的摘窗阶段：摘下画布上的窗口，但失去全部窗口的流暂留不释放，留给提交阶段复用
+     * @param url 原视频流地址
+     * @param x5Surface 目标画布
+     * @param clearSurface 是否清空画布，马上会被重新绑定的画布传 false 以避免闪烁
+     */
+    fun handleLayoutDetach(url: String, x5Surface: Surface, clearSurface: Boolean)
+
+    /**
+     * 布局事务的收尾：提交阶段过后仍没有窗口的暂留流按闲置策略处理
+     */
+    fun handleLayoutSettle()
+
+    /**
+     * 紧随绑定之后在节点线程上查询绑定结果，可选等待首帧
+     * @param url 视频流地址
+     * @param x5Surface 目标画布
+     * @param awaitFirstFrame 是否等到首帧上屏才回调
+     * @param callback 结果回调，运行在节点线程或解码事件线程
+     */
+    fun handleBindResult(url: String, x5Surface: Surface, awaitFirstFrame: Boolean, callback: (BindResult) -> Unit)
+
+    /**
+     * 为本节点挂载共享合成图层，之后带布局矩形的新窗口都作为瓦片绘制到该图层
+     * @param surface 覆盖整个 WebView 的原生画布
+     * @param width 图层物理宽度
+     * @param height 图层物理高度
+     */
+    fun handleAttachLayer(surface: Surface, width: Int, height: Int)
+
+    /**
+     * 更新合成图层尺寸
+     */
+    fun handleResizeLayer(width: Int, height: Int)
+
+    /**
+     * 卸下合成图层，已有的瓦片全部退回独立画布绘制
+     */
+    fun handleDetachLayer()
+
+    /**
+     * 更新合成窗口在图层中的布局矩形
+     * @param x5Surface 目标画布
+     * @param rect 物理像素矩形
+     */
+    fun handleLayoutRect(x5Surface: Surface, rect: Rect)
+
+    /**
+     * 修改指定画布的目标上屏帧率
+     * @param x5Surface 目标画布
+     * @param fps 目标帧率，0 表示跟随源帧率
+     */
+    fun handleTargetFps(x5Surface: Surface, fps: Float)
+
+    /**
+     * 修改指定流的目标上屏帧率，作用于该流的所有窗口
+     * @param url 视频流地址
+     * @param fps 目标帧率，0 表示不限制
+     */
+    fun handleStreamTargetFps(url: String, fps: Float)
+
+    /**
+     * 客户端优先级变化后重新选出窗口所属流的主窗口
+     * @param x5Surface 目标画布
+     */
+    fun handleWindowPriority(x5Surface: Surface)
+
+    /**
+     * 挂起或恢复窗口：挂起的窗口保持绑定但不再绘制，流的全部窗口都挂起时暂停解码、保留网络会话
+     * @param x5Surface 目标画布
+     * @param parked true 挂起，false 恢复
+     */
+    fun handleParkWindow(x5Surface: Surface, parked: Boolean)
+
+    /**
+     * 内存告急时销毁 FBO 池中全部闲置缓冲
+     */
+    fun handleTrimFramebuffers()
+
+    /**
+     * 从调度池重新读取本节点所有流的画质增强参数并重绘
+     */
+    fun handleImageEnhancement()
+
+    /**
+     * 启动预热：在节点线程上预编译着色器变体，排在 EGL 初始化之后执行
+     * @param enhancement 全局画质增强参数
+     */
+    fun handleWarmUp(enhancement: ImageEnhancement)
+
+    /**
+     * 修改指定流的延迟档位，已在拉流的流会重建 Media 使缓冲参数生效
+     * @param url 视频流地址
+     * @param profile 延迟档位
+     */
+    fun handleStreamLatencyProfile(url: String, profile: LatencyProfile)
+
+    /**
+     * 修改指定流的解码档位上限，由全局准入控制在预算吃紧时下发
+     * @param url 视频流地址
+     * @param cap 档位上限，null 表示解除限制
+     */
+    fun handleStreamTierCap(url: String, cap: ResolutionTier?)
+
+    /**
+     * 封面已就绪，若流仍在等待首帧则立即挂上封面
+     * @param url 视频流地址
+     */
+    fun handlePosterReady(url: String)
+
+    /**
+     * 为当前节点所有已出画面的活跃流生成缩小的快照
+     * @param maxWidth 快照最大宽度
+     * @param callback 主线程回调，携带 (url, 快照) 列表
+     */
+    fun handleSnapshot(maxWidth: Int, callback: (List<Pair<String, Bitmap?>>) -> Unit)
+
+    /**
+     * 同步截取指定画布当前的画面，支持直接输出缩小后的尺寸
+     * @param x5Surface 目标画布
+     * @param targetW 期望输出宽度，小于等于 0 时使用解码分辨率
+     * @param targetH 期望输出高度，小于等于 0 时使用解码分辨率
+     * @param hardware 为 true 时 Android 10 及以上走零拷贝，返回与 ImageReader 共享显存的 HARDWARE 位图；
+     * 默认 false 返回可读写像素的软件位图
+     * @return 截图位图
+     */
+    fun handleCaptureSync(x5Surface: Surface, targetW: Int, targetH: Int, hardware: Boolean = false): Bitmap?
 
     /**
      * 清空画布并将其置为透明黑底
@@ -78,6 +257,7 @@ interface IRenderNode {
 
     /**
      * 彻底销毁节点，释放 EGL 环境并结束线程（硬清理）
+     * @param onDestroyed 本节点的播放器全部释放、引擎销毁之后在节点线程上回调
      */
-    fun destroyNode()
+    fun destroyNode(onDestroyed: () -> Unit = {})
 }
\ No newline at end of file
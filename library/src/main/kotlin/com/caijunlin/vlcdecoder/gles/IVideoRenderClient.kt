@@ -1,5 +1,6 @@
 package com.caijunlin.vlcdecoder.gles
 
+import android.graphics.Rect
 import android.view.Surface
 
 /**
@@ -27,6 +28,37 @@ interface IVideoRenderClient {
      */
     fun getTargetHeight(): Int
 
+    /**
+     * 获取画面在画布内的适配模式
+     * @return 适配模式，默认拉伸铺满
+     */
+    fun getScaleMode(): ScaleMode = ScaleMode.STRETCH
+
+    /**
+     * 获取画布在 WebView 中的布局矩形，用于合成模式下在共享图层上定位瓦片
+     * @return 物理像素矩形，null 表示不支持合成，始终使用独立画布
+     */
+    fun getLayoutRect(): Rect? = null
+
+    /**
+     * 获取画布期望的上屏帧率，例如聚焦大窗全速、后台缩略图 10fps
+     * @return 目标帧率，0 表示跟随源帧率
+     */
+    fun getTargetFps(): Float = 0f
+
+    /**
+     * 获取绑定的业务优先级，解码预算不足时低优先级的画面先被降档或抢占
+     * @return 优先级，默认普通可见
+     */
+    fun getPriority(): StreamPriority = StreamPriority.VISIBLE
+
+    /**
+     * 准入控制改变了该客户端的解码待遇时的回调（降档、恢复、被抢占、被拒绝）
+     * @param url 视频流地址
+     * @param state 新的处置结果
+     */
+    fun onAdmissionChanged(url: String, state: AdmissionState) {}
+
     /**
      * 底层真正解码出第一帧并渲染上屏时的回调
      * @param url 视频流地址
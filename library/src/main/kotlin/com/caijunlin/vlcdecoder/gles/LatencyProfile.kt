@@ -0,0 +1,118 @@
+package com.caijunlin.vlcdecoder.gles
+
+import androidx.annotation.Keep
+import kotlin.math.abs
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 单路流的延迟档位。同时调节 VLC 的网络缓冲、时钟抖动容忍与丢帧策略，以及上屏前的抖动缓冲时长。
+ * 云台控制等需要跟手的画面选 ULTRA_LOW，普通监看保持 BALANCED，网络质量差的远端流选 SMOOTH。
+ * @param networkCachingMs 网络缓冲时长
+ * @param presentDelayMs 上屏抖动缓冲，帧按时间戳换算出的显示时刻再延后该时长提交给合成器
+ * @param mediaOptions 追加在业务媒体参数之后的 VLC 参数，同名参数以后者为准
+ */
+@Keep
+enum class LatencyProfile(
+    val networkCachingMs: Int,
+    val presentDelayMs: Int,
+    val mediaOptions: List<String>
+) {
+    /** 极低延迟：最小缓冲、不做时钟平滑、迟到即丢，拿到帧立即上屏 */
+    ULTRA_LOW(
+        80, 0, listOf(
+            ":network-caching=80",
+            ":live-caching=80",
+            ":clock-jitter=0",
+            ":clock-synchro=0",
+            ":drop-late-frames",
+            ":skip-frames"
+        )
+    ),
+
+    /** 均衡：沿用默认的 300ms 缓冲，上屏前留一个帧间隔吸收抖动 */
+    BALANCED(300, 20, emptyList()),
+
+    /** 流畅：加大缓冲、不主动丢帧，以延迟换取平稳 */
+    SMOOTH(
+        1000, 60, listOf(
+            ":network-caching=1000",
+            ":no-drop-late-frames",
+            ":no-skip-frames"
+        )
+    );
+
+    companion object {
+        /**
+         * 解析前端标签属性，无法识别时按均衡处理
+         */
+        @JvmStatic
+        fun fromAttribute(value: String?): LatencyProfile = when (value?.trim()?.lowercase()) {
+            "ultra_low", "ultralow", "ultra-low", "low" -> ULTRA_LOW
+            "smooth", "high" -> SMOOTH
+            else -> BALANCED
+        }
+    }
+}
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 将帧时间戳映射到显示时钟。以 到达时刻 - 时间戳 的最小值为基线跟踪两个时钟之间的偏移，
+ * 帧按 时间戳 + 偏移 + 抖动缓冲 提交给合成器，使网络成批到达的帧仍按源节奏均匀上屏，而不是一齐涌出。
+ * 偏移缓慢向上漂移以跟随时钟漂移，时间戳跳变时重新对齐；同时估算到达时刻相对基线的抖动。仅在节点线程访问。
+ */
+class PresentationClock {
+
+    private var offsetNs = 0L
+    private var hasBaseline = false
+    private var lastPtsNs = 0L
+
+    /** 到达时刻相对基线的平均偏离 */
+    var jitterNs = 0L
+        private set
+
+    /**
+     * 计算一帧的目标显示时刻
+     * @param ptsNs SurfaceTexture 给出的帧时间戳
+     * @param arrivalNs 帧到达时的单调时钟
+     * @param delayNs 抖动缓冲时长
+     * @param nowNs 当前单调时钟
+     * @return 目标显示时刻，不早于当前时刻
+     */
+    fun map(ptsNs: Long, arrivalNs: Long, delayNs: Long, nowNs: Long): Long {
+        if (ptsNs <= 0L || arrivalNs <= 0L) return nowNs
+        val offset = arrivalNs - ptsNs
+        if (!hasBaseline || abs(ptsNs - lastPtsNs) > RESYNC_NS) {
+            offsetNs = offset
+            hasBaseline = true
+            jitterNs = 0L
+        } else if (offset < offsetNs) {
+            offsetNs = offset
+        } else {
+            offsetNs += (offset - offsetNs) shr DRIFT_SHIFT
+        }
+        lastPtsNs = ptsNs
+        jitterNs += (abs(offset - offsetNs) - jitterNs) shr JITTER_SHIFT
+        if (delayNs <= 0L) return nowNs
+        return (ptsNs + offsetNs + delayNs).coerceIn(nowNs, nowNs + delayNs + MAX_LEAD_NS)
+    }
+
+    /** 换源或重连后丢弃基线 */
+    fun reset() {
+        hasBaseline = false
+        lastPtsNs = 0L
+        jitterNs = 0L
+    }
+
+    private companion object {
+        /** 时间戳前后相差超过该值视为断流或跳变 */
+        const val RESYNC_NS = 1_000_000_000L
+        /** 提交给合成器的时刻最多领先当前时刻的额外余量 */
+        const val MAX_LEAD_NS = 50_000_000L
+        /** 基线向上漂移的速度，每帧追回差值的 1/256 */
+        const val DRIFT_SHIFT = 8
+        /** 抖动估算的平滑系数 1/16 */
+        const val JITTER_SHIFT = 4
+    }
+}
@@ -0,0 +1,19 @@
+package com.caijunlin.vlcdecoder.gles
+
+import androidx.annotation.Keep
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 最近解绑流的闲置缓存策略。流失去最后一个窗口后先进入节点的闲置缓存，
+ * 在存活期内被重新绑定时直接复用原播放器与网络会话，避免翻页时反复握手重连。
+ * @param ttlMs 闲置流的存活时长，超时后真正释放，传 0 表示解绑即释放
+ * @param maxIdle 每个节点最多缓存的闲置流数量，超出时淘汰最早闲置的流
+ * @param keepDecoding true 时闲置期间继续解码（重新绑定立即出画面），false 时暂停播放器节省算力
+ */
+@Keep
+data class LingerPolicy(
+    val ttlMs: Long = 500L,
+    val maxIdle: Int = 8,
+    val keepDecoding: Boolean = true
+)
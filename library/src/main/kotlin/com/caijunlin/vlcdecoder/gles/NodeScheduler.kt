@@ -0,0 +1,179 @@
+package com.caijunlin.vlcdecoder.gles
+
+import java.util.concurrent.ConcurrentHashMap
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 渲染节点的实时负载快照，由节点自身线程维护，调度线程只读
+ * @param activeStreams 节点上存活的解码流数量
+ * @param decodedPixels 节点上所有流的解码像素面积之和 (videoWidth * videoHeight)
+ * @param avgTickMs 节点单次渲染循环耗时的滑动平均值
+ * @param movablePixels 可迁移的流(有窗口订阅且未挂起)及其解码像素面积，迁移时从中挑选
+ */
+data class NodeLoad(
+    val activeStreams: Int,
+    val decodedPixels: Long,
+    val avgTickMs: Float,
+    val movablePixels: Map<String, Long> = emptyMap()
+)
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 负载感知的流放置调度器。
+ * 取代 url.hashCode() 取模分片：新流按实时代价挑选最空闲的节点，并维护粘性的 url→节点 路由表，
+ * 保证 switchClientUrl / unbindClient 始终命中流所在的节点；负载失衡时可给出迁移建议。
+ */
+class NodeScheduler(private val nodeCount: Int) {
+
+    /** 粘性路由表：url -> 节点索引 */
+    private val routeTable = ConcurrentHashMap<String, Int>()
+
+    /** 最近一次迁移的时间戳，防止频繁搬迁导致画面反复重连 */
+    @Volatile
+    private var lastMigrateTimeMs = 0L
+
+    /**
+     * 查询 url 当前所在的节点
+     * @param url 视频流地址
+     * @return 节点索引，未路由时返回 null
+     */
+    fun routeOf(url: String): Int? = routeTable[url]
+
+    /**
+     * 为 url 分配节点：已有路由直接复用，否则挑选代价最低的节点并写入路由表
+     * @param url 视频流地址
+     * @param loads 各节点当前的负载快照
+     * @return 节点索引
+     */
+    fun acquire(url: String, loads: List<NodeLoad>): Int {
+        routeTable[url]?.let { return it }
+        synchronized(this) {
+            routeTable[url]?.let { return it }
+            val routedCounts = countRoutes()
+            var bestIndex = 0
+            var bestCost = Float.MAX_VALUE
+            for (i in 0 until nodeCount) {
+                val cost = cost(loads[i], routedCounts[i])
+                if (cost < bestCost) {
+                    bestCost = cost
+                    bestIndex = i
+                }
+            }
+            routeTable[url] = bestIndex
+            return bestIndex
+        }
+    }
+
+    /**
+     * 将 url 固定分配到指定节点（合成模式下图层所在的节点），已有路由时仍沿用原节点
+     * @param url 视频流地址
+     * @param nodeIndex 目标节点索引
+     * @return 实际生效的节点索引
+     */
+    fun acquirePinned(url: String, nodeIndex: Int): Int {
+        return routeTable.putIfAbsent(url, nodeIndex) ?: nodeIndex
+    }
+
+    /**
+     * 节点确认流已经下线后移除路由，仅当路由仍指向该节点时才生效，避免误删迁移后的新路由
+     * @param url 视频流地址
+     * @param nodeIndex 上报下线的节点索引
+     */
+    fun release(url: String, nodeIndex: Int) {
+        routeTable.remove(url, nodeIndex)
+    }
+
+    /**
+     * 节点线程上即将真正建流时重新确认路由，弥补路由在投递途中被旧流下线回调移除的时序空窗
+     * @param url 视频流地址
+     * @param nodeIndex 承接建流的节点索引
+     */
+    fun confirm(url: String, nodeIndex: Int) {
+        routeTable.putIfAbsent(url, nodeIndex)
+    }
+
+    /**
+     * 检查节点之间是否严重失衡，给出一条从最忙节点搬到最闲节点的迁移建议
+     * @param loads 各节点当前的负载快照
+     * @return (待迁移的 url, 源节点索引, 目标节点索引)，无需迁移时返回 null
+     */
+    fun findMigration(loads: List<NodeLoad>): Triple<String, Int, Int>? {
+        if (nodeCount < 2) return null
+        val now = System.currentTimeMillis()
+        if (now - lastMigrateTimeMs < MIGRATE_COOLDOWN_MS) return null
+
+        synchronized(this) {
+            val routedCounts = countRoutes()
+            var hot = 0
+            var cold = 0
+            for (i in 1 until nodeCount) {
+                if (cost(loads[i], routedCounts[i]) > cost(loads[hot], routedCounts[hot])) hot = i
+                if (cost(loads[i], routedCounts[i]) < cost(loads[cold], routedCounts[cold])) cold = i
+            }
+            val hotLoad = loads[hot]
+            val coldLoad = loads[cold]
+            // 只有最忙的节点已逼近帧预算，且搬走一路后双方仍不会倒挂时才值得迁移
+            val isOverBudget = hotLoad.avgTickMs > TICK_BUDGET_MS * 0.8f
+            val streamGap = routedCounts[hot] - routedCounts[cold]
+            if (hot == cold || !isOverBudget || streamGap < 2) return null
+            if (coldLoad.avgTickMs > TICK_BUDGET_MS * 0.5f) return null
+
+            val url = pickCandidate(hot, hotLoad, coldLoad) ?: return null
+            routeTable[url] = cold
+            lastMigrateTimeMs = now
+            return Triple(url, hot, cold)
+        }
+    }
+
+    /**
+     * 从最忙节点的活跃流中挑选迁移代价最合适的一路：搬走后两节点的像素面积最接近，
+     * 像素持平、只是流数量失衡时自然选中面积最小的一路。闲置、预热与挂起的流不在候选之列
+     */
+    private fun pickCandidate(hot: Int, hotLoad: NodeLoad, coldLoad: NodeLoad): String? {
+        val gap = hotLoad.decodedPixels - coldLoad.decodedPixels
+        var best: String? = null
+        var bestResidual = Long.MAX_VALUE
+        hotLoad.movablePixels.forEach { (url, pixels) ->
+            if (routeTable[url] != hot) return@forEach
+            val residual = kotlin.math.abs(gap - 2 * pixels)
+            if (residual < bestResidual) {
+                bestResidual = residual
+                best = url
+            }
+        }
+        return best
+    }
+
+    /**
+     * 清空全部路由（工作区重置时调用）
+     */
+    fun clear() {
+        routeTable.clear()
+    }
+
+    private fun countRoutes(): IntArray {
+        val counts = IntArray(nodeCount)
+        routeTable.values.forEach { if (it in 0 until nodeCount) counts[it]++ }
+        return counts
+    }
+
+    /**
+     * 综合代价：流数量 + 以 720p 为单位的像素面积 + 帧预算占用率
+     * 流数量取路由数与实际数的较大值，以便把还未在节点线程落地的绑定也计入
+     */
+    private fun cost(load: NodeLoad, routedCount: Int): Float {
+        val streamCost = maxOf(load.activeStreams, routedCount).toFloat()
+        val pixelCost = load.decodedPixels / PIXELS_720P
+        val tickCost = load.avgTickMs / TICK_BUDGET_MS * 2f
+        return streamCost + pixelCost + tickCost
+    }
+
+    companion object {
+        /** 单节点的渲染循环帧预算 (25fps) */
+        const val TICK_BUDGET_MS = 40f
+        private const val PIXELS_720P = 1280f * 720f
+        private const val MIGRATE_COOLDOWN_MS = 10_000L
+    }
+}
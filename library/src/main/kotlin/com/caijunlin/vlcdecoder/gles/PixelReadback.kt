@@ -0,0 +1,197 @@
+package com.caijunlin.vlcdecoder.gles
+
+import android.graphics.Bitmap
+import android.opengl.GLES30
+import android.opengl.Matrix
+import android.os.Handler
+import android.os.Looper
+import android.os.SystemClock
+import android.util.Log
+import androidx.core.graphics.createBitmap
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 截帧位图复用池，按分辨率分桶。全局共享并且线程安全，
+ * 业务层用完截图后可通过 VLCRenderPool.recycleFrame 归还，周期性缩略图不再持续制造 GC 压力。
+ */
+object CaptureBitmapPool {
+
+    private const val MAX_PER_SIZE = 4
+    private val buckets = HashMap<Long, ArrayDeque<Bitmap>>()
+
+    private fun keyOf(width: Int, height: Int): Long = (width.toLong() shl 32) or height.toLong()
+
+    /**
+     * 取出一张指定尺寸的 ARGB_8888 可写位图
+     */
+    @Synchronized
+    fun acquire(width: Int, height: Int): Bitmap {
+        val bucket = buckets[keyOf(width, height)]
+        while (bucket != null && bucket.isNotEmpty()) {
+            val bitmap = bucket.removeFirst()
+            if (!bitmap.isRecycled) return bitmap
+        }
+        return createBitmap(width, height)
+    }
+
+    /**
+     * 归还位图，非池化格式或桶已满时直接丢弃
+     */
+    @Synchronized
+    fun release(bitmap: Bitmap) {
+        if (bitmap.isRecycled || !bitmap.isMutable || bitmap.config != Bitmap.Config.ARGB_8888) return
+        val bucket = buckets.getOrPut(keyOf(bitmap.width, bitmap.height)) { ArrayDeque() }
+        if (bucket.size < MAX_PER_SIZE && bucket.none { it === bitmap }) bucket.addLast(bitmap)
+    }
+
+    @Synchronized
+    fun clear() {
+        buckets.clear()
+    }
+}
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 常驻的 PBO 环形读回器，每个 EGLCore 一份。
+ * 读回前先在 GPU 上把纹理翻转绘制到同尺寸的中转 FBO，glReadPixels 写入复用的 PBO 后插入 glFenceSync，
+ * 由节点线程轮询栅栏，GPU 真正完成时才映射，既不盲等固定时长，也不再在 CPU 上二次翻转拷贝。
+ * 一次 submit 可以携带多路请求，共用同一个栅栏，实现批量读回。
+ */
+class PixelReadback(private val eglCore: EGLCore) {
+
+    /**
+     * 单路读回请求
+     * @param tex2DId 数据源二维纹理
+     * @param width 读回宽度
+     * @param height 读回高度
+     * @param callback 主线程回调
+     */
+    class Request(
+        val tex2DId: Int,
+        val width: Int,
+        val height: Int,
+        val callback: (Bitmap?) -> Unit
+    )
+
+    private class Slot(val pboId: Int) {
+        var capacity = 0
+        var inUse = false
+    }
+
+    private val slots = ArrayList<Slot>()
+    private val flipTargets = HashMap<Long, IntArray>()
+    private val flipMatrix = FloatArray(16).apply {
+        Matrix.setIdentityM(this, 0)
+        Matrix.scaleM(this, 0, 1f, -1f, 1f)
+    }
+    private val mainHandler = Handler(Looper.getMainLooper())
+
+    /**
+     * 提交一批读回请求，必须在持有主上下文的渲染线程调用
+     * @param requests 读回请求
+     * @param renderHandler 渲染线程的 Handler，用于轮询栅栏
+     */
+    fun submit(requests: List<Request>, renderHandler: Handler) {
+        if (requests.isEmpty()) return
+        val pending = ArrayList<Pair<Slot, Request>>(requests.size)
+        for (req in requests) {
+            if (req.tex2DId == -1 || req.width <= 0 || req.height <= 0) {
+                mainHandler.post { req.callback(null) }
+                continue
+            }
+            val size = req.width * req.height * 4
+            val slot = acquireSlot(size)
+            val target = flipTargetOf(req.width, req.height)
+
+            GLES30.glBindFramebuffer(GLES30.GL_FRAMEBUFFER, target[0])
+            eglCore.drawTex2DScreen(req.tex2DId, flipMatrix, req.width, req.height)
+            GLES30.glBindBuffer(GLES30.GL_PIXEL_PACK_BUFFER, slot.pboId)
+            GLES30.glReadPixels(0, 0, req.width, req.height, GLES30.GL_RGBA, GLES30.GL_UNSIGNED_BYTE, 0)
+            GLES30.glBindBuffer(GLES30.GL_PIXEL_PACK_BUFFER, 0)
+            GLES30.glBindFramebuffer(GLES30.GL_FRAMEBUFFER, 0)
+            pending.add(Pair(slot, req))
+        }
+        if (pending.isEmpty()) return
+
+        val fence = GLES30.glFenceSync(GLES30.GL_SYNC_GPU_COMMANDS_COMPLETE, 0)
+        GLES30.glFlush()
+        val startMs = SystemClock.uptimeMillis()
+        val pollTask = object : Runnable {
+            override fun run() {
+                eglCore.makeCurrentMain()
+                val status = GLES30.glClientWaitSync(fence, 0, 0L)
+                val isTimeout = SystemClock.uptimeMillis() - startMs > MAX_WAIT_MS
+                if (status == GLES30.GL_TIMEOUT_EXPIRED && !isTimeout) {
+                    renderHandler.postDelayed(this, POLL_INTERVAL_MS)
+                    return
+                }
+                GLES30.glDeleteSync(fence)
+                pending.forEach { (slot, req) -> deliver(slot, req) }
+            }
+        }
+        renderHandler.post(pollTask)
+    }
+
+    private fun deliver(slot: Slot, req: Request) {
+        var bitmap: Bitmap? = null
+        try {
+            val size = req.width * req.height * 4
+            GLES30.glBindBuffer(GLES30.GL_PIXEL_PACK_BUFFER, slot.pboId)
+            val buffer = GLES30.glMapBufferRange(GLES30.GL_PIXEL_PACK_BUFFER, 0, size, GLES30.GL_MAP_READ_BIT)
+            if (buffer != null) {
+                (buffer as ByteBuffer).order(ByteOrder.nativeOrder())
+                bitmap = CaptureBitmapPool.acquire(req.width, req.height).also { it.copyPixelsFromBuffer(buffer) }
+                GLES30.glUnmapBuffer(GLES30.GL_PIXEL_PACK_BUFFER)
+            }
+        } catch (e: Exception) {
+            Log.e("VLCDecoder", "PBO readback failed: ${e.message}")
+        } finally {
+            GLES30.glBindBuffer(GLES30.GL_PIXEL_PACK_BUFFER, 0)
+            slot.inUse = false
+        }
+        val result = bitmap
+        mainHandler.post { req.callback(result) }
+    }
+
+    private fun acquireSlot(size: Int): Slot {
+        val slot = slots.firstOrNull { !it.inUse } ?: run {
+            val ids = IntArray(1)
+            GLES30.glGenBuffers(1, ids, 0)
+            Slot(ids[0]).also { slots.add(it) }
+        }
+        if (slot.capacity < size) {
+            GLES30.glBindBuffer(GLES30.GL_PIXEL_PACK_BUFFER, slot.pboId)
+            GLES30.glBufferData(GLES30.GL_PIXEL_PACK_BUFFER, size, null, GLES30.GL_STREAM_READ)
+            GLES30.glBindBuffer(GLES30.GL_PIXEL_PACK_BUFFER, 0)
+            slot.capacity = size
+        }
+        slot.inUse = true
+        return slot
+    }
+
+    private fun flipTargetOf(width: Int, height: Int): IntArray {
+        val key = (width.toLong() shl 32) or height.toLong()
+        return flipTargets.getOrPut(key) { eglCore.createFBO(width, height) }
+    }
+
+    /**
+     * 释放全部 PBO 与中转 FBO，需在上下文销毁前调用
+     */
+    fun release() {
+        if (slots.isNotEmpty()) {
+            GLES30.glDeleteBuffers(slots.size, slots.map { it.pboId }.toIntArray(), 0)
+            slots.clear()
+        }
+        flipTargets.values.forEach { eglCore.deleteFBO(it[0], it[1]) }
+        flipTargets.clear()
+    }
+
+    companion object {
+        private const val POLL_INTERVAL_MS = 2L
+        private const val MAX_WAIT_MS = 200L
+    }
+}
@@ -0,0 +1,145 @@
+package com.caijunlin.vlcdecoder.gles
+
+import android.os.SystemClock
+import android.util.Log
+import java.util.ArrayDeque
+import java.util.concurrent.Executors
+import java.util.concurrent.LinkedBlockingQueue
+import java.util.concurrent.ScheduledExecutorService
+import java.util.concurrent.ThreadFactory
+import java.util.concurrent.ThreadPoolExecutor
+import java.util.concurrent.TimeUnit
+import java.util.concurrent.atomic.AtomicInteger
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description VLC 播放器生命周期的专用工作线程池。创建、起播、停止、释放与换源都可能因 RTSP 握手/拆链而阻塞数秒，
+ * 统一从节点渲染线程剥离到这里执行，渲染线程只负责 GL 资源。
+ * 每个播放器拥有一条串行通道保证操作顺序；单个操作超过期限即被隔离：其线程视为已损失，
+ * 线程池临时扩容一个线程，其余播放器的操作不会排在坏摄像头之后。
+ */
+object PlayerLifecycleExecutor {
+
+    /** 单次操作的期限，超时即隔离 */
+    @Volatile
+    var deadlineMs = 3000L
+
+    private const val BASE_THREADS = 2
+    private const val MAX_THREADS = 16
+
+    private val threadIndex = AtomicInteger(0)
+    private val threadFactory = ThreadFactory { runnable ->
+        Thread(runnable, "VlcPlayer-${threadIndex.getAndIncrement()}").apply { isDaemon = true }
+    }
+
+    private val executor = ThreadPoolExecutor(
+        BASE_THREADS, BASE_THREADS, 30L, TimeUnit.SECONDS, LinkedBlockingQueue(), threadFactory
+    ).apply { allowCoreThreadTimeOut(false) }
+
+    private val deadlineWatcher: ScheduledExecutorService = Executors.newSingleThreadScheduledExecutor { runnable ->
+        Thread(runnable, "VlcPlayer-Watch").apply { isDaemon = true }
+    }
+
+    private val quarantined = AtomicInteger(0)
+
+    /** 当前仍卡在超时操作里的播放器数量 */
+    val quarantinedCount: Int get() = quarantined.get()
+
+    /**
+     * 为一个播放器创建串行通道
+     * @param tag 日志中标识播放器的名字，通常为流地址
+     */
+    fun newLane(tag: String): Lane = Lane(tag)
+
+    /**
+     * @description 单个播放器的串行操作通道，投递的任务按顺序在工作线程上执行
+     */
+    class Lane internal constructor(private val tag: String) {
+        private val pending = ArrayDeque<Pair<String, () -> Unit>>()
+        private var isRunning = false
+
+        /** 正在执行的操作开始的时间，0 表示空闲 */
+        @Volatile
+        var busySinceMs = 0L
+            private set
+
+        /** 当前是否有操作超时卡住 */
+        @Volatile
+        var isQuarantined = false
+            private set
+
+        /**
+         * 投递一个播放器操作
+         * @param name 操作名称，仅用于超时日志
+         */
+        fun post(name: String, task: () -> Unit) {
+            synchronized(this) {
+                pending.addLast(Pair(name, task))
+                if (isRunning) return
+                isRunning = true
+            }
+            executor.execute { drain() }
+        }
+
+        private fun drain() {
+            while (true) {
+                val (name, task) = synchronized(this) {
+                    val next = pending.pollFirst()
+                    if (next == null) {
+                        isRunning = false
+                        return
+                    }
+                    next
+                }
+                runWithDeadline(name, task)
+            }
+        }
+
+        private fun runWithDeadline(name: String, task: () -> Unit) {
+            val startMs = SystemClock.uptimeMillis()
+            busySinceMs = startMs
+            val check = deadlineWatcher.schedule({
+                if (busySinceMs == startMs) quarantine(name)
+            }, deadlineMs, TimeUnit.MILLISECONDS)
+            try {
+                task()
+            } catch (e: Exception) {
+                Log.e("VLCDecoder", "Player $name failed: ${e.message} $tag")
+            } finally {
+                check.cancel(false)
+                busySinceMs = 0L
+                if (isQuarantined) release(name, SystemClock.uptimeMillis() - startMs)
+            }
+        }
+
+        private fun quarantine(name: String) {
+            isQuarantined = true
+            val count = quarantined.incrementAndGet()
+            Log.e("VLCDecoder", "Player $name exceeded ${deadlineMs}ms, quarantined ($count): $tag")
+            resize()
+        }
+
+        private fun release(name: String, costMs: Long) {
+            isQuarantined = false
+            quarantined.decrementAndGet()
+            Log.w("VLCDecoder", "Player $name recovered after ${costMs}ms: $tag")
+            resize()
+        }
+    }
+
+    /**
+     * 线程数 = 基础线程 + 被隔离占住的线程，保证健康的播放器始终有空闲线程可用
+     */
+    @Synchronized
+    private fun resize() {
+        val target = (BASE_THREADS + quarantined.get()).coerceAtMost(MAX_THREADS)
+        if (target > executor.maximumPoolSize) {
+            executor.maximumPoolSize = target
+            executor.corePoolSize = target
+        } else {
+            executor.corePoolSize = target
+            executor.maximumPoolSize = target
+        }
+    }
+}
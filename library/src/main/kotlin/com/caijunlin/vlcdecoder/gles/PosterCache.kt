@@ -0,0 +1,129 @@
+package com.caijunlin.vlcdecoder.gles
+
+import android.content.Context
+import android.graphics.Bitmap
+import android.graphics.BitmapFactory
+import android.os.Build
+import android.util.Log
+import android.util.LruCache
+import java.io.File
+import java.io.FileOutputStream
+import java.security.MessageDigest
+import java.util.concurrent.ExecutorService
+import java.util.concurrent.Executors
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 视频流封面缓存（内存 + 磁盘两级 LRU，按 url 索引）。
+ * 流在等待首帧期间先展示最近一次的截图，掩盖重连与首帧看门狗窗口内的黑屏。
+ * 编码与磁盘读写全部在独立的后台线程完成，绝不占用渲染线程。
+ */
+object PosterCache {
+
+    private const val MEMORY_BYTES = 16 * 1024 * 1024
+    private const val MAX_DISK_FILES = 64
+    private const val DIR_NAME = "vlc_posters"
+
+    private val memoryCache = object : LruCache<String, Bitmap>(MEMORY_BYTES) {
+        override fun sizeOf(key: String, value: Bitmap): Int = value.allocationByteCount
+    }
+
+    private val ioExecutor: ExecutorService = Executors.newSingleThreadExecutor { r ->
+        Thread(r, "VlcPosterIO").apply { priority = Thread.MIN_PRIORITY }
+    }
+
+    @Volatile
+    private var diskDir: File? = null
+
+    /** 编码质量 (0-100) */
+    @Volatile
+    var quality = 70
+
+    /**
+     * 绑定磁盘缓存目录
+     * @param context 应用上下文
+     */
+    fun init(context: Context) {
+        if (diskDir != null) return
+        diskDir = File(context.applicationContext.cacheDir, DIR_NAME).apply { mkdirs() }
+    }
+
+    /**
+     * 仅查询内存缓存，可在渲染线程调用
+     * @param url 视频流地址
+     */
+    fun getMemory(url: String): Bitmap? = memoryCache.get(url)
+
+    /**
+     * 后台从磁盘预取封面到内存，成功后回调（回调运行在 IO 线程）
+     * @param url 视频流地址
+     * @param onLoaded 加载成功的回调
+     */
+    fun prefetch(url: String, onLoaded: () -> Unit) {
+        if (memoryCache.get(url) != null) {
+            onLoaded()
+            return
+        }
+        val dir = diskDir ?: return
+        ioExecutor.execute {
+            val file = File(dir, keyOf(url))
+            if (!file.exists()) return@execute
+            val bitmap = BitmapFactory.decodeFile(file.absolutePath) ?: return@execute
+            memoryCache.put(url, bitmap)
+            onLoaded()
+        }
+    }
+
+    /**
+     * 写入新的封面，内存立即生效，磁盘异步编码落盘
+     * @param url 视频流地址
+     * @param bitmap 已缩小的截图，写入后由缓存持有
+     */
+    fun put(url: String, bitmap: Bitmap) {
+        memoryCache.put(url, bitmap)
+        val dir = diskDir ?: return
+        ioExecutor.execute {
+            try {
+                val target = File(dir, keyOf(url))
+                val temp = File(dir, "${target.name}.tmp")
+                FileOutputStream(temp).use { out ->
+                    if (!bitmap.isRecycled) bitmap.compress(compressFormat(), quality, out)
+                }
+                temp.renameTo(target)
+                trimDisk(dir)
+            } catch (e: Exception) {
+                Log.e("VLCDecoder", "Poster encode failed: ${e.message}")
+            }
+        }
+    }
+
+    /**
+     * 清空内存缓存，磁盘文件保留给下次冷启动使用
+     */
+    fun clearMemory() {
+        memoryCache.evictAll()
+    }
+
+    @Suppress("DEPRECATION")
+    private fun compressFormat(): Bitmap.CompressFormat {
+        return if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.R) {
+            Bitmap.CompressFormat.WEBP_LOSSY
+        } else {
+            Bitmap.CompressFormat.WEBP
+        }
+    }
+
+    private fun trimDisk(dir: File) {
+        val files = dir.listFiles() ?: return
+        if (files.size <= MAX_DISK_FILES) return
+        files.sortedBy { it.lastModified() }
+            .take(files.size - MAX_DISK_FILES)
+            .forEach { it.delete() }
+    }
+
+    private fun keyOf(url: String): String {
+        val digest = MessageDigest.getInstance("MD5").digest(url.toByteArray())
+        return digest.joinToString("") { "%02x".format(it) }
+    }
+}
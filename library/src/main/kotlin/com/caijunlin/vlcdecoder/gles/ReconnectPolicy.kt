@@ -0,0 +1,190 @@
+package com.caijunlin.vlcdecoder.gles
+
+import android.os.Handler
+import android.os.SystemClock
+import android.util.Log
+import androidx.annotation.Keep
+import androidx.annotation.VisibleForTesting
+import androidx.core.net.toUri
+import java.util.concurrent.ThreadLocalRandom
+import kotlin.math.min
+import kotlin.math.pow
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 断流重连策略。重连间隔按指数退避并叠加随机抖动，避免 NVR 重启后所有流同一时刻集体重连；
+ * 前几次只在现有播放器上重新 play（软重试），仍不行才重建 Media。
+ * @param baseDelayMs 首次重连的等待时长
+ * @param maxDelayMs 退避的等待上限
+ * @param multiplier 每次失败后等待时长的放大倍数
+ * @param jitter 随机抖动比例，0.3 表示在 ±30% 内浮动
+ * @param maxAttempts 连续重连多少次仍失败后宣告流死亡
+ * @param softRetries 前多少次重连只做软重试
+ * @param breakerThreshold 同一主机连续失败多少次后熔断
+ * @param breakerCooldownMs 熔断后等待多久才放行一路探测流
+ */
+@Keep
+data class ReconnectPolicy(
+    val baseDelayMs: Long = 1000L,
+    val maxDelayMs: Long = 30_000L,
+    val multiplier: Float = 2f,
+    val jitter: Float = 0.3f,
+    val maxAttempts: Int = 5,
+    val softRetries: Int = 1,
+    val breakerThreshold: Int = 3,
+    val breakerCooldownMs: Long = 10_000L
+) {
+    /**
+     * 计算第 attempt 次重连(从 0 开始)前的等待时长
+     */
+    fun delayFor(attempt: Int): Long {
+        val exp = baseDelayMs * multiplier.toDouble().pow(attempt.coerceAtLeast(0))
+        val capped = min(exp, maxDelayMs.toDouble())
+        val spread = capped * jitter.coerceIn(0f, 1f)
+        val jittered = capped + ThreadLocalRandom.current().nextDouble(-spread, spread + 1e-6)
+        return jittered.toLong().coerceAtLeast(0L)
+    }
+}
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 按主机(NVR)分组的熔断器。同一主机的流连续失败达到阈值后熔断，
+ * 冷却到期只放行一路探测流，探测成功后其余等待中的流按抖动错峰恢复，探测失败则加倍冷却。
+ * 线程安全，等待中的流通过各自节点的 Handler 被唤醒。
+ */
+object HostCircuitBreaker {
+
+    private class HostState {
+        var failures = 0
+        var openUntilMs = 0L
+        var cooldownMs = 0L
+        var probeOwner: Any? = null
+        var probeStartedMs = 0L
+        val waiters = LinkedHashMap<Any, Pair<Handler, Runnable>>()
+    }
+
+    private val hosts = HashMap<String, HostState>()
+
+    /** 探测流迟迟没有结果时，超过该时长即允许另一路流接替探测 */
+    private const val PROBE_TIMEOUT_MS = 20_000L
+
+    /** 单调时钟，单元测试中替换以推进冷却时间 */
+    @VisibleForTesting
+    internal var clock: () -> Long = { SystemClock.uptimeMillis() }
+
+    /** 在流所在节点上排期唤醒任务，同一任务只保留最后一次排期；单元测试中替换以记录唤醒 */
+    @VisibleForTesting
+    internal var scheduler: (Handler, Runnable, Long) -> Unit = { handler, task, delayMs ->
+        handler.removeCallbacks(task)
+        handler.postDelayed(task, delayMs)
+    }
+
+    /**
+     * 提取流地址的主机与端口作为分组键
+     */
+    fun hostOf(url: String): String {
+        return try {
+            val uri = url.toUri()
+            val host = uri.host ?: return url
+            if (uri.port > 0) "$host:${uri.port}" else host
+        } catch (e: Exception) {
+            url
+        }
+    }
+
+    /**
+     * 流准备发起重连前申请放行
+     * @param owner 发起重连的流
+     * @param handler 流所在节点的 Handler，熔断恢复时在其上唤醒
+     * @param wakeUp 恢复时执行的重连任务
+     * @return true 表示可以立即重连；false 表示已登记为等待，恢复时会被唤醒
+     */
+    @Synchronized
+    fun tryAcquire(host: String, owner: Any, handler: Handler, wakeUp: Runnable): Boolean {
+        val state = hosts[host] ?: return true
+        val now = clock()
+        if (state.openUntilMs == 0L) return true
+        val probe = state.probeOwner
+        if (probe === owner) return true
+        val probeExpired = probe != null && now - state.probeStartedMs > PROBE_TIMEOUT_MS
+        if (now >= state.openUntilMs && (probe == null || probeExpired)) {
+            state.probeOwner = owner
+            state.probeStartedMs = now
+            state.waiters.remove(owner)
+            Log.i("VLCDecoder", "Circuit half-open, probing $host")
+            return true
+        }
+        state.waiters[owner] = Pair(handler, wakeUp)
+        // 冷却到期时由最先醒来的等待者接手探测；探测进行中则在探测超时后再来检查，防止探测流失联时整组挂起
+        val wakeAtMs = if (probe == null) state.openUntilMs else state.probeStartedMs + PROBE_TIMEOUT_MS + 1
+        scheduler(handler, wakeUp, (wakeAtMs - now).coerceAtLeast(0L))
+        return false
+    }
+
+    /**
+     * 一次连接失败
+     */
+    @Synchronized
+    fun onFailure(host: String, owner: Any, policy: ReconnectPolicy) {
+        val state = hosts.getOrPut(host) { HostState() }
+        state.failures++
+        val wasProbe = state.probeOwner === owner
+        if (wasProbe) state.probeOwner = null
+        if (state.failures >= policy.breakerThreshold || wasProbe) {
+            val base = policy.breakerCooldownMs
+            state.cooldownMs = if (state.openUntilMs == 0L || state.cooldownMs == 0L) base else min(state.cooldownMs * 2, policy.maxDelayMs.coerceAtLeast(base))
+            if (state.openUntilMs == 0L) Log.w("VLCDecoder", "Circuit open for $host after ${state.failures} failures")
+            state.openUntilMs = clock() + state.cooldownMs
+        }
+        // 探测失败后探测名额空出，须有一路等待者在冷却到期时接替，否则只有 onSuccess 能唤醒它们
+        if (wasProbe) wakeFirstWaiterLocked(state)
+    }
+
+    /**
+     * 连接成功，熔断闭合并错峰唤醒等待中的流
+     */
+    @Synchronized
+    fun onSuccess(host: String, policy: ReconnectPolicy) {
+        val state = hosts.remove(host) ?: return
+        if (state.waiters.isEmpty()) return
+        Log.i("VLCDecoder", "Circuit closed for $host, resuming ${state.waiters.size} streams")
+        var index = 0
+        state.waiters.values.forEach { (handler, task) ->
+            // 每路流错开一个带抖动的基础间隔，避免集体重连
+            scheduler(handler, task, policy.delayFor(0) * index / 2)
+            index++
+        }
+    }
+
+    /**
+     * 流被释放时注销其探测与等待登记
+     */
+    @Synchronized
+    fun forget(host: String, owner: Any) {
+        val state = hosts[host] ?: return
+        val wasWaiting = state.waiters.remove(owner) != null
+        if (state.probeOwner === owner) {
+            state.probeOwner = null
+            // 探测流中途离场，唤醒下一路等待者接替探测，防止整组流永远挂起
+            wakeFirstWaiterLocked(state)
+        } else if (wasWaiting && state.probeOwner == null) {
+            // 离场的可能正是被指定接替探测的等待者，把名额顺延给下一路
+            wakeFirstWaiterLocked(state)
+        }
+    }
+
+    @Synchronized
+    fun clear() {
+        hosts.clear()
+    }
+
+    /**
+     * 在冷却到期时唤醒排在最前的等待者，由它申请接替探测
+     */
+    private fun wakeFirstWaiterLocked(state: HostState) {
+        val (handler, task) = state.waiters.values.firstOrNull() ?: return
+        scheduler(handler, task, (state.openUntilMs - clock()).coerceAtLeast(0L))
+    }
+}
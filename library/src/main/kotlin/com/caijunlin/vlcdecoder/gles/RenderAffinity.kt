@@ -0,0 +1,31 @@
+package com.caijunlin.vlcdecoder.gles
+
+import androidx.annotation.Keep
+import com.caijunlin.vlcdecoder.core.CpuTopology
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 渲染节点线程的绑核策略。同构 CPU 上所有核心都视为大核，BIG_CLUSTER 等价于不绑核。
+ */
+@Keep
+enum class RenderAffinity {
+    /** 不绑核，完全交给内核调度 */
+    NONE,
+
+    /** 所有渲染节点都限制在大核簇内，由内核在大核之间迁移 */
+    BIG_CLUSTER,
+
+    /** 每个渲染节点独占一个大核，节点数多于大核时轮流复用 */
+    PER_BIG_CORE;
+
+    /**
+     * 计算指定节点允许运行的核心
+     * @return 为空表示不限制
+     */
+    fun cpusFor(nodeIndex: Int): List<Int> {
+        val big = CpuTopology.bigCores
+        if (this == NONE || big.isEmpty() || !CpuTopology.isHeterogeneous && this == BIG_CLUSTER) return emptyList()
+        return if (this == PER_BIG_CORE) listOf(big[nodeIndex % big.size]) else big
+    }
+}
@@ -0,0 +1,76 @@
+package com.caijunlin.vlcdecoder.gles
+
+import kotlinx.coroutines.suspendCancellableCoroutine
+import java.util.concurrent.CompletableFuture
+import kotlin.coroutines.resume
+import kotlin.coroutines.resumeWithException
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 异步绑定的最终状态
+ */
+enum class BindStatus {
+    /** 窗口已挂到流上 */
+    ACCEPTED,
+
+    /** 节点并发流数量已达上限，建流被拒绝 */
+    REJECTED_BY_LIMIT,
+
+    /** 未能落地：引擎未初始化、画布失效、画布已绑定其他流或在等待期间被解绑 */
+    NOT_BOUND,
+
+    /** 等待首帧期间流重试耗尽宣告死亡 */
+    PLAYBACK_FAILED
+}
+
+/**
+ * 异步绑定的结果
+ * @param url 视频流地址
+ * @param status 绑定状态
+ * @param firstFrameAtMs 首帧上屏的时间戳，未等待首帧或尚未出帧时为 -1
+ */
+data class BindResult(
+    val url: String,
+    val status: BindStatus,
+    val firstFrameAtMs: Long = -1L
+) {
+    val isAccepted: Boolean get() = status == BindStatus.ACCEPTED
+}
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 一次页面切换所需的绑定操作集合，整体提交。
+ * 提交时先投递全部解绑以腾出并发名额，再投递切换与绑定，避免新旧页面的操作交错导致误判超限。
+ */
+class RenderBatch {
+    internal val unbinds = ArrayList<Pair<String, IVideoRenderClient>>()
+    internal val switches = ArrayList<Triple<String, String, IVideoRenderClient>>()
+    internal val binds = ArrayList<Pair<String, IVideoRenderClient>>()
+
+    fun bind(url: String, client: IVideoRenderClient) = apply { binds.add(Pair(url, client)) }
+
+    fun unbind(url: String, client: IVideoRenderClient) = apply { unbinds.add(Pair(url, client)) }
+
+    fun switchUrl(oldUrl: String, newUrl: String, client: IVideoRenderClient) = apply {
+        switches.add(Triple(oldUrl, newUrl, client))
+    }
+}
+
+/**
+ * 布局事务中单个组件的目标状态
+ * @param client 渲染客户端
+ * @param url 目标视频流地址，空字符串表示该组件在新布局中不再播放
+ */
+data class LayoutEntry(val client: IVideoRenderClient, val url: String)
+
+/**
+ * 在协程中等待 CompletableFuture 完成而不阻塞线程
+ */
+suspend fun <T> CompletableFuture<T>.awaitResult(): T = suspendCancellableCoroutine { continuation ->
+    whenComplete { value, error ->
+        if (error != null) continuation.resumeWithException(error) else continuation.resume(value)
+    }
+    continuation.invokeOnCancellation { cancel(false) }
+}
@@ -0,0 +1,48 @@
+package com.caijunlin.vlcdecoder.gles
+
+import androidx.annotation.Keep
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 解码目标分辨率档位。流的解码缓冲区与 FBO 会跟随当前绑定的最大窗口向上取整到某一档，
+ * 缩略图小窗不再按 720p 满负荷解码与填充。
+ */
+@Keep
+enum class ResolutionTier(val width: Int, val height: Int) {
+    P360(640, 360),
+    P540(960, 540),
+    P720(1280, 720),
+    P1080(1920, 1080);
+
+    companion object {
+        /**
+         * 计算能完整容纳指定窗口的最小档位
+         * @param windowW 窗口物理宽度
+         * @param windowH 窗口物理高度
+         * @param maxTier 档位上限
+         * @return 向上取整后的档位，不会超过上限
+         */
+        @JvmStatic
+        fun fit(windowW: Int, windowH: Int, maxTier: ResolutionTier): ResolutionTier {
+            if (windowW <= 0 || windowH <= 0) return maxTier
+            val tier = entries.firstOrNull { windowW <= it.width && windowH <= it.height } ?: P1080
+            return if (tier.ordinal > maxTier.ordinal) maxTier else tier
+        }
+    }
+}
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 多码流源的地址解析器。例如 RTSP 主/子码流地址模板、按档位区分的 HLS 清单，
+ * 返回 null 或原地址时表示该源没有对应档位的变体，继续使用原地址。
+ */
+fun interface StreamVariantResolver {
+    /**
+     * @param url 业务层绑定的原始流地址
+     * @param tier 当前需要的分辨率档位
+     * @return 实际拉流使用的地址
+     */
+    fun resolve(url: String, tier: ResolutionTier): String?
+}
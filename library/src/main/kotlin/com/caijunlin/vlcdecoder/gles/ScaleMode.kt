@@ -0,0 +1,40 @@
+package com.caijunlin.vlcdecoder.gles
+
+import androidx.annotation.Keep
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 画面在窗口内的适配模式，全部通过 MVP 矩阵在 GPU 上完成，不会触发解码器重配或 FBO 重建
+ */
+@Keep
+enum class ScaleMode {
+    /** 等比缩放完整显示，空白处留透明黑边 */
+    FIT,
+
+    /** 等比缩放铺满窗口，超出部分裁掉 */
+    FILL,
+
+    /** 不缩放，按解码分辨率 1:1 居中显示，超出部分裁掉 */
+    CROP,
+
+    /** 拉伸铺满窗口（默认，与历史表现一致） */
+    STRETCH;
+
+    companion object {
+        /**
+         * 解析前端标签属性值
+         * @param value 属性字符串，如 fit / fill / crop / stretch
+         * @return 对应的模式，无法识别时回落为 STRETCH
+         */
+        @JvmStatic
+        fun fromAttribute(value: String?): ScaleMode {
+            return when (value?.trim()?.lowercase()) {
+                "fit", "contain" -> FIT
+                "fill", "cover" -> FILL
+                "crop", "none" -> CROP
+                else -> STRETCH
+            }
+        }
+    }
+}
@@ -0,0 +1,134 @@
+package com.caijunlin.vlcdecoder.gles
+
+import androidx.annotation.Keep
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 画质增强参数，作用于 FBO→窗口 的上屏绘制。
+ * 低分辨率解码画面放大到大窗时以轻量锐化补偿模糊，缩小到缩略图时以多点采样或 mipmap 抑制锯齿，
+ * 使解码档位可以保持在较低水平而大屏画质不明显下降。各项默认关闭，与 OFF 一致，需要时按项开启。
+ * @param adaptiveScaling 是否按缩放比例自动选用锐化放大 / 多点缩小 / mipmap 缩小
+ * @param sharpness 放大时的锐化强度，0 表示只做双线性放大，建议 0.3 左右
+ * @param brightness 亮度偏移，-1..1，0 表示不调整
+ * @param contrast 对比度系数，1 表示不调整
+ * @param deinterlace 是否做相邻行混合去隔行，适用于老式模拟摄像机的隔行源
+ */
+@Keep
+data class ImageEnhancement(
+    val adaptiveScaling: Boolean = false,
+    val sharpness: Float = 0f,
+    val brightness: Float = 0f,
+    val contrast: Float = 1f,
+    val deinterlace: Boolean = false
+) {
+    /** 是否需要颜色调整 */
+    val adjustsColor: Boolean get() = brightness != 0f || contrast != 1f
+
+    companion object {
+        /** 关闭全部增强，与旧版的纯双线性采样一致 */
+        @JvmField
+        val OFF = ImageEnhancement()
+    }
+}
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 上屏着色器阶段的变体编码与源码生成。缩放方式与各项可选处理组合成一个整型键，
+ * 每个 EGLCore 对每个键只编译一次程序；键为 0 时走原有的直通程序。
+ */
+internal object ShaderStage {
+
+    const val SCALE_NONE = 0
+    /** 缩小 1.25~4 倍：四点对角采样近似盒式滤波 */
+    const val SCALE_DOWN = 1
+    /** 缩小超过 4 倍：源纹理生成 mipmap，由硬件三线性采样 */
+    const val SCALE_MIPMAP = 2
+    /** 放大超过 1.25 倍：四邻域反锐化掩模 */
+    const val SCALE_UP_SHARPEN = 3
+
+    private const val SCALE_MASK = 0x3
+    const val FLAG_COLOR = 0x4
+    const val FLAG_DEINTERLACE = 0x8
+
+    private const val DOWN_THRESHOLD = 1.25f
+    private const val MIPMAP_THRESHOLD = 4f
+    private const val UP_THRESHOLD = 0.8f
+
+    fun scaleOf(key: Int): Int = key and SCALE_MASK
+
+    /**
+     * 按源尺寸与目标视口计算当前绘制需要的变体
+     * @return 变体键，0 表示无需任何处理
+     */
+    fun keyFor(srcW: Int, srcH: Int, dstW: Int, dstH: Int, enhancement: ImageEnhancement): Int {
+        var key = 0
+        if (enhancement.adaptiveScaling && srcW > 0 && srcH > 0 && dstW > 0 && dstH > 0) {
+            val ratio = maxOf(srcW.toFloat() / dstW, srcH.toFloat() / dstH)
+            key = when {
+                ratio > MIPMAP_THRESHOLD -> SCALE_MIPMAP
+                ratio > DOWN_THRESHOLD -> SCALE_DOWN
+                ratio < UP_THRESHOLD && enhancement.sharpness > 0f -> SCALE_UP_SHARPEN
+                else -> SCALE_NONE
+            }
+        }
+        if (enhancement.adjustsColor) key = key or FLAG_COLOR
+        if (enhancement.deinterlace) key = key or FLAG_DEINTERLACE
+        return key
+    }
+
+    /**
+     * 缩小时多点采样的步长(以源纹素计)，使四个双线性采样点大致覆盖一个目标像素的足迹
+     */
+    fun downscaleStep(srcW: Int, srcH: Int, dstW: Int, dstH: Int): Float {
+        val ratio = maxOf(srcW.toFloat() / dstW.coerceAtLeast(1), srcH.toFloat() / dstH.coerceAtLeast(1))
+        return (ratio * 0.25f).coerceIn(0.5f, 1f)
+    }
+
+    fun fragmentSource(key: Int): String {
+        val scale = scaleOf(key)
+        return """#version 300 es
+            #define SCALE_MODE $scale
+            #define USE_COLOR ${if (key and FLAG_COLOR != 0) 1 else 0}
+            #define USE_DEINTERLACE ${if (key and FLAG_DEINTERLACE != 0) 1 else 0}
+            precision mediump float;
+            in vec2 vTexCoord;
+            uniform sampler2D tex2D;
+            uniform vec2 uTexel;
+            uniform float uStep;
+            uniform float uSharpness;
+            uniform float uBrightness;
+            uniform float uContrast;
+            layout(location = 0) out vec4 fragColor;
+
+            vec4 src(vec2 uv) {
+            #if USE_DEINTERLACE
+                vec2 half_line = vec2(0.0, uTexel.y * 0.5);
+                return 0.5 * (texture(tex2D, uv - half_line) + texture(tex2D, uv + half_line));
+            #else
+                return texture(tex2D, uv);
+            #endif
+            }
+
+            void main() {
+            #if SCALE_MODE == 1
+                vec2 d = uTexel * uStep;
+                vec4 c = 0.25 * (src(vTexCoord + vec2(-d.x, -d.y)) + src(vTexCoord + vec2(d.x, -d.y)) +
+                                 src(vTexCoord + vec2(-d.x, d.y)) + src(vTexCoord + vec2(d.x, d.y)));
+            #elif SCALE_MODE == 3
+                vec4 c = src(vTexCoord);
+                vec3 n = src(vTexCoord + vec2(uTexel.x, 0.0)).rgb + src(vTexCoord - vec2(uTexel.x, 0.0)).rgb +
+                         src(vTexCoord + vec2(0.0, uTexel.y)).rgb + src(vTexCoord - vec2(0.0, uTexel.y)).rgb;
+                c.rgb = clamp(c.rgb + uSharpness * (4.0 * c.rgb - n), 0.0, 1.0);
+            #else
+                vec4 c = src(vTexCoord);
+            #endif
+            #if USE_COLOR
+                c.rgb = clamp((c.rgb - 0.5) * uContrast + 0.5 + uBrightness, 0.0, 1.0);
+            #endif
+                fragColor = c;
+            }
+        """
+    }
+}
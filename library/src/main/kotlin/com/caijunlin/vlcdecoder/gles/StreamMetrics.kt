@@ -0,0 +1,259 @@
+package com.caijunlin.vlcdecoder.gles
+
+import org.json.JSONArray
+import org.json.JSONObject
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 固定分桶的耗时直方图，只在节点线程写入与采样，记录与采样均不分配内存。
+ * 采样后自动清零，每次采样反映的是自上次采样以来的区间数据。
+ */
+class LatencyHistogram {
+
+    private val counts = LongArray(BUCKET_BOUNDS_US.size + 1)
+    private var total = 0L
+    private var maxNs = 0L
+
+    /**
+     * 记录一次耗时
+     * @param costNs 耗费的纳秒数
+     */
+    fun record(costNs: Long) {
+        val costUs = costNs / 1000L
+        var bucket = 0
+        while (bucket < BUCKET_BOUNDS_US.size && costUs > BUCKET_BOUNDS_US[bucket]) bucket++
+        counts[bucket]++
+        total++
+        if (costNs > maxNs) maxNs = costNs
+    }
+
+    /**
+     * 输出区间摘要并清零，分位数以所在桶的上界近似
+     */
+    fun sampleAndReset(): LatencySummary {
+        val summary = LatencySummary(total, percentileUs(0.5f), percentileUs(0.95f), maxNs / 1000L)
+        counts.fill(0L)
+        total = 0L
+        maxNs = 0L
+        return summary
+    }
+
+    private fun percentileUs(p: Float): Long {
+        if (total == 0L) return 0L
+        val threshold = (total * p).toLong().coerceAtLeast(1L)
+        var cumulative = 0L
+        for (i in counts.indices) {
+            cumulative += counts[i]
+            if (cumulative >= threshold) {
+                return if (i < BUCKET_BOUNDS_US.size) BUCKET_BOUNDS_US[i] else maxNs / 1000L
+            }
+        }
+        return maxNs / 1000L
+    }
+
+    companion object {
+        /** 桶上界(微秒)，覆盖从纹理锁定到整帧超时、以及抖动缓冲后上屏延迟的量级 */
+        private val BUCKET_BOUNDS_US = longArrayOf(100, 250, 500, 1_000, 2_000, 4_000, 8_000, 16_000, 33_000, 66_000, 133_000)
+    }
+}
+
+/**
+ * 耗时直方图的区间摘要
+ * @param count 样本数
+ * @param p50Us 中位数(微秒)
+ * @param p95Us 95 分位(微秒)
+ * @param maxUs 最大值(微秒)
+ */
+data class LatencySummary(val count: Long, val p50Us: Long, val p95Us: Long, val maxUs: Long) {
+    fun toJson(): JSONObject = JSONObject()
+        .put("count", count)
+        .put("p50Us", p50Us)
+        .put("p95Us", p95Us)
+        .put("maxUs", maxUs)
+}
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 单路流的运行计数器，由节点线程累加，采样时计算区间帧率
+ */
+class StreamCounters {
+    var decodedFrames = 0L
+    var presentedFrames = 0L
+    var droppedByCongestion = 0L
+    var totalRetries = 0L
+
+    /** 从开始拉流到首帧锁定的耗时，-1 表示尚未出帧 */
+    var firstFrameMs = -1L
+
+    val updateTexImage = LatencyHistogram()
+    val draw = LatencyHistogram()
+    val swap = LatencyHistogram()
+
+    /** 帧到达到提交上屏的延迟 */
+    val presentLatency = LatencyHistogram()
+
+    private var lastSampleNs = 0L
+    private var lastDecodedFrames = 0L
+    private var lastPresentedFrames = 0L
+
+    /**
+     * 计算自上次采样以来的解码与上屏帧率
+     * @return (解码帧率, 上屏帧率)
+     */
+    fun sampleRates(nowNs: Long): Pair<Float, Float> {
+        val elapsedNs = nowNs - lastSampleNs
+        val rates = if (lastSampleNs == 0L || elapsedNs <= 0L) {
+            Pair(0f, 0f)
+        } else {
+            val seconds = elapsedNs / 1_000_000_000f
+            Pair(
+                (decodedFrames - lastDecodedFrames) / seconds,
+                (presentedFrames - lastPresentedFrames) / seconds
+            )
+        }
+        lastSampleNs = nowNs
+        lastDecodedFrames = decodedFrames
+        lastPresentedFrames = presentedFrames
+        return rates
+    }
+}
+
+/**
+ * 单路流的指标快照
+ */
+data class StreamMetrics(
+    val url: String,
+    val nodeIndex: Int,
+    val state: String,
+    val windows: Int,
+    val width: Int,
+    val height: Int,
+    val sourceFps: Float,
+    val decodedFps: Float,
+    val presentedFps: Float,
+    val droppedByCongestion: Long,
+    val firstFrameMs: Long,
+    val retryCount: Long,
+    val decodeMode: String,
+    val codec: String,
+    val playerQuarantined: Boolean,
+    val parkedWindows: Int,
+    val parkedMs: Long,
+    val latencyProfile: String,
+    val networkCachingMs: Int,
+    val jitterMs: Float,
+    val presentLatency: LatencySummary,
+    val updateTexImage: LatencySummary,
+    val draw: LatencySummary,
+    val swap: LatencySummary
+) {
+    fun toJson(): JSONObject = JSONObject()
+        .put("url", url)
+        .put("node", nodeIndex)
+        .put("state", state)
+        .put("windows", windows)
+        .put("width", width)
+        .put("height", height)
+        .put("sourceFps", sourceFps.toDouble())
+        .put("decodedFps", decodedFps.toDouble())
+        .put("presentedFps", presentedFps.toDouble())
+        .put("droppedByCongestion", droppedByCongestion)
+        .put("firstFrameMs", firstFrameMs)
+        .put("retryCount", retryCount)
+        .put("decodeMode", decodeMode)
+        .put("codec", codec)
+        .put("playerQuarantined", playerQuarantined)
+        .put("parkedWindows", parkedWindows)
+        .put("parkedMs", parkedMs)
+        .put("latencyProfile", latencyProfile)
+        .put("networkCachingMs", networkCachingMs)
+        .put("jitterMs", jitterMs.toDouble())
+        .put("presentLatency", presentLatency.toJson())
+        .put("updateTexImage", updateTexImage.toJson())
+        .put("draw", draw.toJson())
+        .put("swap", swap.toJson())
+}
+
+/**
+ * 单个渲染节点的指标快照
+ */
+data class NodeMetrics(
+    val nodeIndex: Int,
+    val activeStreams: Int,
+    val warmStreams: Int,
+    val idleStreams: Int,
+    val parkedStreams: Int,
+    val avgTickMs: Float,
+    val tick: LatencySummary,
+    val streams: List<StreamMetrics>,
+    val cpu: Int = -1,
+    val affinity: List<Int> = emptyList(),
+    val avgTickBigMs: Float = 0f,
+    val avgTickLittleMs: Float = 0f,
+    val fboLiveBytes: Long = 0L,
+    val fboIdleBytes: Long = 0L
+) {
+    fun toJson(): JSONObject = JSONObject()
+        .put("node", nodeIndex)
+        .put("activeStreams", activeStreams)
+        .put("warmStreams", warmStreams)
+        .put("idleStreams", idleStreams)
+        .put("parkedStreams", parkedStreams)
+        .put("avgTickMs", avgTickMs.toDouble())
+        .put("tick", tick.toJson())
+        .put("cpu", cpu)
+        .put("affinity", JSONArray(affinity))
+        .put("avgTickBigMs", avgTickBigMs.toDouble())
+        .put("avgTickLittleMs", avgTickLittleMs.toDouble())
+        .put("fboLiveBytes", fboLiveBytes)
+        .put("fboIdleBytes", fboIdleBytes)
+}
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 整个引擎的指标快照，由 StreamKit.getMetrics() 返回
+ * @param tickImbalance 最忙节点的平均循环耗时与全体平均值之比，1 表示完全均衡
+ * @param streamSpread 节点间活跃流数量的最大差值
+ * @param decoders 探测到的硬解能力与当前软硬解会话占用
+ */
+data class EngineMetrics(
+    val timestampMs: Long,
+    val mode: String,
+    val nodes: List<NodeMetrics>,
+    val tickImbalance: Float,
+    val streamSpread: Int,
+    val decoders: JSONObject = JSONObject(),
+    val cpu: JSONObject = JSONObject()
+) {
+    fun toJson(): JSONObject {
+        val nodesJson = JSONArray()
+        val streamsJson = JSONArray()
+        nodes.forEach { node ->
+            nodesJson.put(node.toJson())
+            node.streams.forEach { streamsJson.put(it.toJson()) }
+        }
+        return JSONObject()
+            .put("timestampMs", timestampMs)
+            .put("mode", mode)
+            .put("tickImbalance", tickImbalance.toDouble())
+            .put("streamSpread", streamSpread)
+            .put("decoders", decoders)
+            .put("cpu", cpu)
+            .put("nodes", nodesJson)
+            .put("streams", streamsJson)
+    }
+
+    companion object {
+        fun of(mode: String, nodes: List<NodeMetrics>, decoders: JSONObject = JSONObject(), cpu: JSONObject = JSONObject()): EngineMetrics {
+            val ticks = nodes.map { it.avgTickMs }
+            val meanTick = if (ticks.isEmpty()) 0f else ticks.sum() / ticks.size
+            val imbalance = if (meanTick > 0f) (ticks.maxOrNull() ?: 0f) / meanTick else 1f
+            val counts = nodes.map { it.activeStreams }
+            val spread = if (counts.isEmpty()) 0 else (counts.maxOrNull() ?: 0) - (counts.minOrNull() ?: 0)
+            return EngineMetrics(System.currentTimeMillis(), mode, nodes, imbalance, spread, decoders, cpu)
+        }
+    }
+}
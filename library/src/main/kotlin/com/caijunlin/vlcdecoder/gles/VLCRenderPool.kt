@@ -5,12 +5,16 @@ import android.os.Handler
 import android.os.Looper
 import android.util.Log
 import android.view.Surface
+import com.caijunlin.vlcdecoder.core.CpuTopology
+import com.caijunlin.vlcdecoder.core.DecoderCapabilities
 import com.caijunlin.vlcdecoder.core.VLCEngineManager
+import org.json.JSONObject
 import java.util.Collections.synchronizedMap
+import java.util.concurrent.CompletableFuture
 import java.util.concurrent.ConcurrentHashMap
-import java.util.concurrent.CountDownLatch
 import java.util.concurrent.TimeUnit
-import kotlin.math.abs
+import java.util.concurrent.atomic.AtomicBoolean
+import java.util.concurrent.atomic.AtomicInteger
 
 /**
  * @author caijunlin
@@ -31,60 +35,647 @@ object VLCRenderPool {
     @Volatile
     private var maxStreamLimit = 16
 
+    /** 多码流源的变体地址解析器，为 null 时所有档位都使用原地址 */
+    @Volatile
+    var variantResolver: StreamVariantResolver? = null
+
+    @Volatile
+    private var maxResolutionTier = ResolutionTier.P720
+
+    /** 全局上屏帧率上限 */
+    @Volatile
+    private var maxRenderFps = FramePacer.DEFAULT_MAX_FPS
+
+    /** 挂载共享合成图层的节点索引，-1 表示未开启合成模式 */
+    @Volatile
+    private var compositorNodeIndex = -1
+
+    /** 全局硬解会话账本，流开始拉流时在此登记软硬解 */
+    internal val decodeLedger = DecodeSessionLedger()
+
+    /** 全局解码准入控制，预算在所有节点之间共享 */
+    private val admission = AdmissionController()
+
+    /** 按流地址设置的目标帧率，新建或迁移的流落地时补发 */
+    private val streamFpsMap = ConcurrentHashMap<String, Float>()
+
+    /** 开启了 OES 单拷贝直出的渲染模式集合（默认均关闭，走稳定的 FBO 中转） */
+    private val directRenderModes = java.util.Collections.synchronizedSet(java.util.EnumSet.noneOf(EGLRenderMode::class.java))
+
+    /** 渲染节点线程的绑核策略 */
+    @Volatile
+    private var renderAffinity = RenderAffinity.NONE
+
     private val NODE_COUNT: Int by lazy {
         if (model == EGLRenderMode.MOBILE) {
-            kotlin.math.max(1, kotlin.math.min(Runtime.getRuntime().availableProcessors() / 2, 6))
+            if (CpuTopology.isHeterogeneous) {
+                // 大小核异构时按大核数量开节点，避免渲染线程被挤到小核上
+                CpuTopology.bigCores.size.coerceIn(2, 6)
+            } else {
+                kotlin.math.max(1, kotlin.math.min(Runtime.getRuntime().availableProcessors() / 2, 6))
+            }
         } else {
             4
         }
     }
 
-    private val renderNodes: Array<IRenderNode> by lazy {
-        Array(NODE_COUNT) { index ->
-            if (model == EGLRenderMode.MOBILE) {
-                com.caijunlin.vlcdecoder.gles.mobile.RenderNode("VlcNode-Mobile-$index") { _, deadSurfaces ->
-                    deadSurfaces.forEach { surfaceRouteMap.remove(it) }
+    private val renderNodesLazy = lazy {
+        Array<BaseRenderNode<*>>(NODE_COUNT) { index ->
+            val node = if (model == EGLRenderMode.MOBILE) {
+                com.caijunlin.vlcdecoder.gles.mobile.RenderNode("VlcNode-Mobile-$index") { url, deadSurfaces ->
+                    onStreamOffline(index, url, deadSurfaces)
                 }
             } else {
-                com.caijunlin.vlcdecoder.gles.rk.RenderNode("VlcNode-RK-$index") { _, deadSurfaces ->
-                    deadSurfaces.forEach { surfaceRouteMap.remove(it) }
+                com.caijunlin.vlcdecoder.gles.rk.RenderNode("VlcNode-RK-$index") { url, deadSurfaces ->
+                    onStreamOffline(index, url, deadSurfaces)
                 }
             }
+            node.engineIndex = index
+            node.directRenderEnabled = directRenderModes.contains(model)
+            node.maxResolutionTier = maxResolutionTier
+            node.framePacer.maxFps = maxRenderFps
+            node.lingerPolicy = lingerPolicy
+            node.applyAffinity(renderAffinity.cpusFor(index))
+            node
         }
     }
 
+    private val renderNodes: Array<BaseRenderNode<*>> by renderNodesLazy
+
+    /** 负载感知的放置调度器，维护 url→节点 的粘性路由 */
+    private val scheduler: NodeScheduler by lazy { NodeScheduler(NODE_COUNT) }
+
     private val surfaceRouteMap = ConcurrentHashMap<Surface, String>()
     private val clientRouteMap =
         synchronizedMap(java.util.WeakHashMap<IVideoRenderClient, String>())
 
+    @Volatile
+    private var maxPreloadLimit = 4
+
+    @Volatile
+    private var lingerPolicy = LingerPolicy()
+
+    @Volatile
+    private var defaultReconnectPolicy = ReconnectPolicy()
+
+    /** 按地址单独配置的重连策略 */
+    private val reconnectPolicies = ConcurrentHashMap<String, ReconnectPolicy>()
+
+    /** 全局画质增强参数，默认关闭，由业务显式开启 */
+    @Volatile
+    private var defaultImageEnhancement = ImageEnhancement.OFF
+
+    /** 按地址单独配置的画质增强参数 */
+    private val imageEnhancements = ConcurrentHashMap<String, ImageEnhancement>()
+
+    /** 按地址配置的延迟档位，未配置的流使用 BALANCED */
+    private val latencyProfiles = ConcurrentHashMap<String, LatencyProfile>()
+
+    /** 预热流的 LRU 记录（访问顺序），超出预算或内存告急时从最久未用的开始淘汰 */
+    private val warmLru = LinkedHashMap<String, Long>(16, 0.75f, true)
+
+    /** 封面快照调度，运行在主线程，真正的截帧与编码分别在节点线程与 IO 线程 */
+    private val snapshotHandler = Handler(Looper.getMainLooper())
+
+    @Volatile
+    private var snapshotIntervalMs = 0L
+
+    @Volatile
+    private var snapshotMaxWidth = 320
+
+    private val snapshotTask = object : Runnable {
+        override fun run() {
+            if (snapshotIntervalMs <= 0L) return
+            if (renderNodesLazy.isInitialized()) {
+                val maxWidth = snapshotMaxWidth
+                renderNodes.forEach { node ->
+                    node.handler.post {
+                        node.handleSnapshot(maxWidth) { snapshots ->
+                            snapshots.forEach { (url, bitmap) -> if (bitmap != null) PosterCache.put(url, bitmap) }
+                        }
+                    }
+                }
+            }
+            snapshotHandler.postDelayed(this, snapshotIntervalMs)
+        }
+    }
+
+    /** 记录每路流绑定时的媒体参数，迁移节点时原样复用 */
+    private val urlOptionsMap = ConcurrentHashMap<String, ArrayList<String>>()
+
     fun setMaxStreamCount(maxCount: Int) {
         this.maxStreamLimit = maxCount
+        admission.maxStreams = maxCount
     }
 
-    private fun getNodeByUrl(url: String): IRenderNode {
-        return renderNodes[abs(url.hashCode()) % NODE_COUNT]
+    /**
+     * 设置全局解码预算。例如 RK3588 约可承受 16 路 1080p@30 即 ~1.0e9 像素/秒，RK3568 约为其四分之一
+     * @param pixelsPerSecond 所有节点合计每秒可解码的像素数
+     * @param assumedFps 估算开销时采用的源帧率
+     */
+    fun setDecodeBudget(pixelsPerSecond: Long, assumedFps: Float = AdmissionController.DEFAULT_ASSUMED_FPS) {
+        admission.budgetPixelsPerSecond = pixelsPerSecond.coerceAtLeast(0L)
+        admission.assumedFps = assumedFps.coerceAtLeast(1f)
     }
 
-    fun bindClient(
+    /**
+     * 设置全局显存预算：准入控制以各节点实际在用的 FBO 加上新流档位的估算值校验，超出时与解码预算一样先降档再抢占；
+     * 各节点的 FBO 复用池在总量超出预算时不再保留闲置缓冲
+     * @param bytes 预算字节数
+     */
+    fun setGpuMemoryBudget(bytes: Long) {
+        GpuMemoryBudget.budgetBytes = bytes.coerceAtLeast(0L)
+    }
+
+    /**
+     * 设置允许同时软解的最大路数，硬件会话耗尽后超出该路数的非聚焦新流将被拒绝
+     */
+    fun setMaxSoftwareDecodeCount(maxCount: Int) {
+        decodeLedger.maxSoftwareStreams = maxCount.coerceAtLeast(0)
+    }
+
+    /**
+     * 更新客户端的业务优先级，提升优先级可能让其被降档的流恢复清晰度
+     */
+    fun setClientPriority(client: IVideoRenderClient, priority: StreamPriority) {
+        val url = clientRouteMap[client] ?: return
+        applyRestoredTiers(admission.updatePriority(url, client, priority))
+        val x5Surface = client.getTargetSurface() ?: return
+        val node = getNodeByUrl(url) ?: return
+        node.handler.post { node.handleWindowPriority(x5Surface) }
+    }
+
+    /**
+     * 为指定渲染模式开启或关闭 OES 单拷贝直出。直出时单窗口流直接采样 OES 纹理上屏，
+     * 仅在多窗口复用或截图需要稳定拷贝时才回退到 FBO 中转。对之后新建的流生效。
+     * @param mode 渲染模式
+     * @param enabled 是否开启
+     */
+    fun setDirectRender(mode: EGLRenderMode, enabled: Boolean) {
+        if (enabled) directRenderModes.add(mode) else directRenderModes.remove(mode)
+        if (mode == model && renderNodesLazy.isInitialized()) {
+            renderNodes.forEach { it.directRenderEnabled = enabled }
+        }
+    }
+
+    /**
+     * 设置解码分辨率档位上限，流会跟随绑定窗口的最大尺寸在上限内自动升降档
+     * @param tier 档位上限
+     */
+    fun setMaxResolutionTier(tier: ResolutionTier) {
+        maxResolutionTier = tier
+        if (renderNodesLazy.isInitialized()) {
+            renderNodes.forEach { it.maxResolutionTier = tier }
+        }
+    }
+
+    /**
+     * 设置全局上屏帧率上限，所有窗口的目标帧率都不会超过该值
+     * @param fps 帧率上限，0 表示跟随源帧率不设上限
+     */
+    fun setMaxRenderFps(fps: Float) {
+        maxRenderFps = fps.coerceAtLeast(0f)
+        if (renderNodesLazy.isInitialized()) {
+            renderNodes.forEach { it.framePacer.maxFps = maxRenderFps }
+        }
+    }
+
+    /**
+     * 设置某一路流的目标上屏帧率，作用于该流当前与之后的所有窗口
+     * @param url 视频流地址
+     * @param fps 目标帧率，0 表示取消限制
+     */
+    fun setStreamTargetFps(url: String, fps: Float) {
+        if (fps > 0f) streamFpsMap[url] = fps else streamFpsMap.remove(url)
+        val node = getNodeByUrl(url) ?: return
+        node.handler.post { node.handleStreamTargetFps(url, fps.coerceAtLeast(0f)) }
+    }
+
+    /**
+     * 设置最近解绑流的闲置缓存策略，对之后进入闲置的流生效
+     * @param policy 闲置缓存策略
+     */
+    fun setLingerPolicy(policy: LingerPolicy) {
+        lingerPolicy = policy
+        admission.idleKeepsDecoding = policy.keepDecoding
+        if (renderNodesLazy.isInitialized()) {
+            renderNodes.forEach { it.lingerPolicy = policy }
+        }
+    }
+
+    /**
+     * 设置渲染节点线程的绑核策略，已创建的节点立即生效
+     */
+    fun setRenderAffinity(affinity: RenderAffinity) {
+        renderAffinity = affinity
+        if (renderNodesLazy.isInitialized()) {
+            renderNodes.forEachIndexed { index, node -> node.applyAffinity(affinity.cpusFor(index)) }
+        }
+    }
+
+    /**
+     * 设置全局断流重连策略，对之后发生的重连生效
+     */
+    fun setReconnectPolicy(policy: ReconnectPolicy) {
+        defaultReconnectPolicy = policy
+    }
+
+    /**
+     * 为指定地址单独设置重连策略，例如对关键的聚焦流使用更激进的退避参数
+     * @param policy 重连策略，传 null 恢复使用全局策略
+     */
+    fun setStreamReconnectPolicy(url: String, policy: ReconnectPolicy?) {
+        if (policy == null) reconnectPolicies.remove(url) else reconnectPolicies[url] = policy
+    }
+
+    internal fun reconnectPolicyFor(url: String): ReconnectPolicy = reconnectPolicies[url] ?: defaultReconnectPolicy
+
+    /**
+     * 设置某一路流的延迟档位，对之后拉起的流生效；流已在播放时就地重建 Media
+     * @param url 视频流地址
+     * @param profile 延迟档位
+     */
+    fun setLatencyProfile(url: String, profile: LatencyProfile) {
+        if (profile == LatencyProfile.BALANCED) latencyProfiles.remove(url) else latencyProfiles[url] = profile
+        val node = getNodeByUrl(url) ?: return
+        node.handler.post { node.handleStreamLatencyProfile(url, profile) }
+    }
+
+    internal fun latencyProfileOf(url: String): LatencyProfile = latencyProfiles[url] ?: LatencyProfile.BALANCED
+
+    /**
+     * 设置上屏画质增强参数，立即作用于已在播放的流
+     * @param enhancement 增强参数
+     * @param url 为 null 时设置全局默认值（传 null 恢复关闭），否则只作用于该地址；url 非空时传 null 清除该地址的单独配置
+     */
+    fun setImageEnhancement(enhancement: ImageEnhancement?, url: String? = null) {
+        if (url == null) {
+            defaultImageEnhancement = enhancement ?: ImageEnhancement.OFF
+        } else if (enhancement == null) {
+            imageEnhancements.remove(url)
+        } else {
+            imageEnhancements[url] = enhancement
+        }
+        if (renderNodesLazy.isInitialized()) {
+            renderNodes.forEach { node -> node.handler.post { node.handleImageEnhancement() } }
+        }
+    }
+
+    internal fun imageEnhancementOf(url: String): ImageEnhancement = imageEnhancements[url] ?: defaultImageEnhancement
+
+    /**
+     * 开启周期性封面快照：按间隔对每路已出画面的流截取缩小快照，写入内存与磁盘缓存，
+     * 之后同一地址重新绑定时在首帧到达前先展示封面
+     * @param intervalMs 快照间隔，传 0 关闭
+     * @param maxWidth 快照最大宽度，在 GPU 上完成缩放
+     */
+    fun startSnapshots(intervalMs: Long, maxWidth: Int = 320) {
+        snapshotHandler.removeCallbacks(snapshotTask)
+        snapshotIntervalMs = intervalMs
+        snapshotMaxWidth = maxWidth.coerceAtLeast(16)
+        if (intervalMs > 0L) snapshotHandler.postDelayed(snapshotTask, intervalMs)
+    }
+
+    fun stopSnapshots() {
+        snapshotIntervalMs = 0L
+        snapshotHandler.removeCallbacks(snapshotTask)
+    }
+
+    /**
+     * 设置预热池的独立预算，与 maxStreamLimit 互不占用
+     * @param maxCount 允许同时预热的最大流数量
+     */
+    fun setMaxPreloadCount(maxCount: Int) {
+        maxPreloadLimit = maxCount.coerceAtLeast(0)
+        trimWarm(maxPreloadLimit)
+    }
+
+    /**
+     * 预热即将播放的流（如巡检列表中的相邻通道），提前建连缓冲，
+     * 之后 bindClient / switchClientUrl 命中时直接接管播放器，跳过建连与首个关键帧等待
+     * @param urls 预测的下一批流地址
+     * @param mediaOptions 媒体配置参数
+     */
+    fun preload(urls: List<String>, mediaOptions: ArrayList<String> = defaultMediaArgs) {
+        if (VLCEngineManager.libVLC == null || maxPreloadLimit == 0) return
+        val activeUrls = synchronized(clientRouteMap) { clientRouteMap.values.toHashSet() }
+        urls.forEach { url ->
+            if (url.isEmpty() || activeUrls.contains(url)) return@forEach
+            synchronized(warmLru) { warmLru[url] = System.currentTimeMillis() }
+            urlOptionsMap.putIfAbsent(url, mediaOptions)
+            val (index, node) = acquireNode(url)
+            node.handler.post {
+                scheduler.confirm(url, index)
+                node.handlePreload(url, mediaOptions)
+            }
+        }
+        trimWarm(maxPreloadLimit)
+    }
+
+    /**
+     * 响应系统内存告警，按严重程度淘汰预热流
+     * @param level ComponentCallbacks2 的 TRIM_MEMORY_* 级别
+     */
+    fun trimMemory(level: Int) {
+        val keep = when {
+            level >= android.content.ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL -> 0
+            level >= android.content.ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW -> maxPreloadLimit / 2
+            else -> return
+        }
+        trimWarm(keep)
+        if (renderNodesLazy.isInitialized()) {
+            renderNodes.forEach { node -> node.handler.post { node.handleTrimFramebuffers() } }
+        }
+    }
+
+    /**
+     * 提前创建全部渲染节点，各节点在自己的线程上并行完成 EGL 初始化与着色器预编译，
+     * 首路流绑定时不再排队等待节点线程启动、建上下文与编译着色器。须在 model 确定之后调用
+     * @param onReady 全部节点就绪后回调，运行在最后一个完成的节点线程上，参数为节点数
+     */
+    fun warmUpNodes(onReady: (Int) -> Unit) {
+        val nodes = renderNodes
+        val remaining = AtomicInteger(nodes.size)
+        val enhancement = defaultImageEnhancement
+        nodes.forEach { node ->
+            node.handler.post {
+                node.handleWarmUp(enhancement)
+                if (remaining.decrementAndGet() == 0) onReady(nodes.size)
+            }
+        }
+    }
+
+    private fun trimWarm(keep: Int) {
+        val evicted = ArrayList<String>()
+        synchronized(warmLru) {
+            val iterator = warmLru.keys.iterator()
+            while (warmLru.size > keep && iterator.hasNext()) {
+                evicted.add(iterator.next())
+                iterator.remove()
+            }
+        }
+        evicted.forEach { url ->
+            val node = getNodeByUrl(url) ?: return@forEach
+            node.handler.post { node.handleEvictWarm(url) }
+        }
+    }
+
+    private fun markWarmConsumed(url: String) {
+        synchronized(warmLru) { warmLru.remove(url) }
+    }
+
+    private fun collectLoads(): List<NodeLoad> = renderNodes.map { it.getLoad() }
+
+    /**
+     * 查询流当前所在的节点（只读，不会新建路由）
+     */
+    private fun getNodeByUrl(url: String): IRenderNode? {
+        val index = scheduler.routeOf(url) ?: return null
+        return renderNodes[index]
+    }
+
+    /**
+     * 为流分配节点：已有路由的沿用原节点；合成模式下可定位的客户端固定到图层所在节点；
+     * 其余新流按实时负载挑选最空闲的节点
+     */
+    private fun acquireNode(url: String, client: IVideoRenderClient? = null): Pair<Int, IRenderNode> {
+        val layerIndex = compositorNodeIndex
+        val index = if (layerIndex >= 0 && client?.getLayoutRect() != null) {
+            scheduler.acquirePinned(url, layerIndex)
+        } else {
+            scheduler.acquire(url, collectLoads())
+        }
+        return Pair(index, renderNodes[index])
+    }
+
+    /**
+     * 节点上报流已下线（linger 到期、拒绝建流或重试耗尽）
+     */
+    private fun onStreamOffline(nodeIndex: Int, url: String, deadSurfaces: List<Surface>) {
+        deadSurfaces.forEach { surfaceRouteMap.remove(it) }
+        scheduler.release(url, nodeIndex)
+        if (scheduler.routeOf(url) == null) {
+            urlOptionsMap.remove(url)
+            applyRestoredTiers(admission.releaseStream(url))
+        }
+    }
+
+    /**
+     * 向准入控制申请额度并执行其决策：抢占的流整路解绑，降档的流下发档位上限
+     * @return 是否允许绑定
+     */
+    private fun admitClient(url: String, client: IVideoRenderClient): Boolean {
+        val tier = ResolutionTier.fit(client.getTargetWidth(), client.getTargetHeight(), maxResolutionTier)
+        if (scheduler.routeOf(url) == null && client.getPriority() < StreamPriority.FOCUSED && !decodeLedger.canStart(tier)) {
+            // 硬件会话与软解路数都已用尽，再建流只会让所有流一起掉帧
+            Log.w("VLCDecoder", "Decoder sessions exhausted, reject $url")
+            client.onAdmissionChanged(url, AdmissionState.REJECTED)
+            return false
+        }
+        val decision = admission.admit(url, client, tier)
+        if (decision.state == AdmissionState.REJECTED) {
+            Log.w("VLCDecoder", "Admission rejected ${client.getPriority()} $url")
+            client.onAdmissionChanged(url, AdmissionState.REJECTED)
+            return false
+        }
+        decision.preempted.forEach { (victimUrl, victims) ->
+            Log.w("VLCDecoder", "Admission preempted ${victims.size} clients: $victimUrl")
+            val node = getNodeByUrl(victimUrl)
+            victims.forEach { victim ->
+                clientRouteMap.remove(victim)
+                val surface = victim.getTargetSurface()
+                if (node != null && surface != null) node.handler.post { node.handleUnbind(victimUrl, surface) }
+                victim.onAdmissionChanged(victimUrl, AdmissionState.PREEMPTED)
+            }
+            // 被抢占的流已不再计入额度，不能留在闲置缓存里继续解码
+            node?.let { it.handler.post { it.handleEvictIdle(victimUrl) } }
+        }
+        decision.reclaimed.forEach { idleUrl ->
+            Log.i("VLCDecoder", "Admission reclaimed idle stream: $idleUrl")
+            getNodeByUrl(idleUrl)?.let { node -> node.handler.post { node.handleEvictIdle(idleUrl) } }
+        }
+        decision.tierCaps.forEach { (capUrl, cap) ->
+            postTierCap(capUrl, cap)
+            if (capUrl != url) admission.clientsOf(capUrl).forEach { it.onAdmissionChanged(capUrl, AdmissionState.DOWNGRADED) }
+        }
+        if (decision.state == AdmissionState.DOWNGRADED) client.onAdmissionChanged(url, AdmissionState.DOWNGRADED)
+        return true
+    }
+
+    private fun releaseAdmission(url: String, client: IVideoRenderClient) {
+        // 会进入闲置缓存的流保留额度，直到节点上报下线或被新流回收
+        val policy = lingerPolicy
+        val retainIdle = policy.ttlMs > 0L && policy.maxIdle > 0 && getNodeByUrl(url) != null
+        applyRestoredTiers(admission.release(url, client, retainIdle))
+    }
+
+    private fun applyRestoredTiers(urls: List<String>) {
+        urls.forEach { url ->
+            postTierCap(url, null)
+            admission.clientsOf(url).forEach { it.onAdmissionChanged(url, AdmissionState.ADMITTED) }
+        }
+    }
+
+    private fun postTierCap(url: String, cap: ResolutionTier?) {
+        val node = getNodeByUrl(url) ?: return
+        node.handler.post { node.handleStreamTierCap(url, cap) }
+    }
+
+    private fun prefetchPoster(url: String, node: IRenderNode) {
+        PosterCache.prefetch(url) {
+            node.handler.post { node.handlePosterReady(url) }
+        }
+    }
+
+    private fun postBind(
+        nodeIndex: Int,
+        node: IRenderNode,
         url: String,
+        x5Surface: Surface,
         client: IVideoRenderClient,
-        mediaOptions: ArrayList<String> = defaultMediaArgs
+        mediaOptions: ArrayList<String>,
+        onBound: ((IRenderNode, Surface) -> Unit)? = null
     ) {
-        if (url.isEmpty() || VLCEngineManager.libVLC == null) return
-        val x5Surface = client.getTargetSurface() ?: return
-        clientRouteMap[client] = url
-        val node = getNodeByUrl(url)
         node.handler.post {
+            scheduler.confirm(url, nodeIndex)
             node.handleBind(url, x5Surface, client, mediaOptions, maxStreamLimit)
+            streamFpsMap[url]?.let { node.handleStreamTargetFps(url, it) }
+            admission.tierCapOf(url)?.let { node.handleStreamTierCap(url, it) }
+            onBound?.invoke(node, x5Surface)
+        }
+    }
+
+    /** 负载采样任务，周期性检查节点失衡，稳态下的失衡也能得到纠正 */
+    private val rebalanceHandler = Handler(Looper.getMainLooper())
+    private val isRebalancing = AtomicBoolean(false)
+
+    /** 负载采样间隔，与调度器的迁移冷却时间配合，失衡持续时大约每十秒搬迁一路 */
+    private const val REBALANCE_INTERVAL_MS = 2_000L
+
+    /** 指标采集等待节点上报的最长时间 */
+    private const val METRICS_TIMEOUT_MS = 100L
+
+    private val rebalanceTask = object : Runnable {
+        override fun run() {
+            rebalance()
+            if (isRebalancing.get()) rebalanceHandler.postDelayed(this, REBALANCE_INTERVAL_MS)
+        }
+    }
+
+    private fun startLoadSampling() {
+        if (isRebalancing.compareAndSet(false, true)) rebalanceHandler.postDelayed(rebalanceTask, REBALANCE_INTERVAL_MS)
+    }
+
+    private fun stopLoadSampling() {
+        isRebalancing.set(false)
+        rebalanceHandler.removeCallbacks(rebalanceTask)
+    }
+
+    /**
+     * 节点负载严重失衡时将最忙节点上的一路活跃流整体搬到最闲节点，由负载采样周期触发。
+     * 迁移会让该流在新节点重新拉流，因此调度器内部自带冷却时间
+     */
+    fun rebalance() {
+        if (VLCEngineManager.libVLC == null) return
+        // 合成模式下的瓦片必须留在图层所在节点，迁移会让其退回独立画布
+        if (compositorNodeIndex >= 0) return
+        val (url, sourceIndex, targetIndex) = scheduler.findMigration(collectLoads()) ?: return
+        val oldNode = renderNodes[sourceIndex]
+        val newNode = renderNodes[targetIndex]
+        val opts = urlOptionsMap[url] ?: defaultMediaArgs
+        val clients = synchronized(clientRouteMap) {
+            clientRouteMap.filterValues { it == url }.keys.toList()
+        }
+        Log.i("VLCDecoder", "Migrate stream to node-$targetIndex ${clients.size} clients: $url")
+        oldNode.handler.post {
+            oldNode.handleMigrateOut(url)
+            clients.forEach { client ->
+                val x5Surface = client.getTargetSurface() ?: return@forEach
+                postBind(targetIndex, newNode, url, x5Surface, client, opts)
+            }
+        }
+    }
+
+    /**
+     * 绑定客户端到视频流，操作投递到节点线程后立即返回
+     * @param onBound 在节点线程上紧随绑定执行的回调，用于查询绑定结果
+     * @return 是否成功投递
+     */
+    fun bindClient(
+        url: String,
+        client: IVideoRenderClient,
+        mediaOptions: ArrayList<String> = defaultMediaArgs,
+        onBound: ((IRenderNode, Surface) -> Unit)? = null
+    ): Boolean = requestBind(url, client, mediaOptions, onBound) == BindStatus.ACCEPTED
+
+    private fun requestBind(
+        url: String,
+        client: IVideoRenderClient,
+        mediaOptions: ArrayList<String>,
+        onBound: ((IRenderNode, Surface) -> Unit)?
+    ): BindStatus {
+        if (url.isEmpty() || VLCEngineManager.libVLC == null) return BindStatus.NOT_BOUND
+        val x5Surface = client.getTargetSurface() ?: return BindStatus.NOT_BOUND
+        clientRouteMap[client]?.takeIf { it != url }?.let { releaseAdmission(it, client) }
+        if (!admitClient(url, client)) return BindStatus.REJECTED_BY_LIMIT
+        clientRouteMap[client] = url
+        urlOptionsMap[url] = mediaOptions
+        markWarmConsumed(url)
+        val (index, node) = acquireNode(url, client)
+        postBind(index, node, url, x5Surface, client, mediaOptions, onBound)
+        prefetchPoster(url, node)
+        startLoadSampling()
+        return BindStatus.ACCEPTED
+    }
+
+    /**
+     * 异步绑定，返回的 Future 在节点落地绑定后完成，不阻塞任何线程
+     * @param awaitFirstFrame 为 true 时等到首帧上屏（或流死亡）才完成
+     * @return 绑定结果，回调运行在节点线程
+     */
+    fun bindClientAsync(
+        url: String,
+        client: IVideoRenderClient,
+        mediaOptions: ArrayList<String> = defaultMediaArgs,
+        awaitFirstFrame: Boolean = false
+    ): CompletableFuture<BindResult> {
+        val future = CompletableFuture<BindResult>()
+        val status = requestBind(url, client, mediaOptions) { node, x5Surface ->
+            node.handleBindResult(url, x5Surface, awaitFirstFrame) { future.complete(it) }
         }
+        if (status != BindStatus.ACCEPTED) future.complete(BindResult(url, status))
+        return future
     }
 
     fun unbindClient(url: String, client: IVideoRenderClient) {
+        unbindClientAsync(url, client)
+    }
+
+    /**
+     * 异步解绑，Future 在节点线程完成解绑后完成
+     * @return 是否真的执行了解绑
+     */
+    fun unbindClientAsync(url: String, client: IVideoRenderClient): CompletableFuture<Boolean> {
+        val future = CompletableFuture<Boolean>()
         clientRouteMap.remove(client)
-        val x5Surface = client.getTargetSurface() ?: return
+        releaseAdmission(url, client)
+        postUnbind(url, client, future)
+        return future
+    }
+
+    /**
+     * 把画布从流上摘下，不触碰准入额度
+     */
+    private fun postUnbind(url: String, client: IVideoRenderClient, future: CompletableFuture<Boolean>? = null) {
+        val x5Surface = client.getTargetSurface()
         val node = getNodeByUrl(url)
+        if (x5Surface == null || node == null) {
+            future?.complete(false)
+            return
+        }
         node.handler.post {
             node.handleUnbind(url, x5Surface)
+            future?.complete(true)
         }
     }
 
@@ -92,72 +683,407 @@ object VLCRenderPool {
         oldUrl: String,
         newUrl: String,
         client: IVideoRenderClient,
-        mediaOptions: ArrayList<String> = defaultMediaArgs
-    ) {
-        if (newUrl.isEmpty() || VLCEngineManager.libVLC == null) return
-        val x5Surface = client.getTargetSurface() ?: return
+        mediaOptions: ArrayList<String> = defaultMediaArgs,
+        onBound: ((IRenderNode, Surface) -> Unit)? = null
+    ): Boolean = requestSwitch(oldUrl, newUrl, client, mediaOptions, onBound) == BindStatus.ACCEPTED
+
+    private fun requestSwitch(
+        oldUrl: String,
+        newUrl: String,
+        client: IVideoRenderClient,
+        mediaOptions: ArrayList<String>,
+        onBound: ((IRenderNode, Surface) -> Unit)?
+    ): BindStatus {
+        if (newUrl.isEmpty() || VLCEngineManager.libVLC == null) return BindStatus.NOT_BOUND
+        val x5Surface = client.getTargetSurface() ?: return BindStatus.NOT_BOUND
 
+        if (oldUrl.isNotEmpty()) releaseAdmission(oldUrl, client)
+        if (!admitClient(newUrl, client)) {
+            // 新地址未获准入时旧画面也不再保留，避免画布停留在切换前的流上；旧额度在上面已经归还
+            if (oldUrl.isNotEmpty()) {
+                clientRouteMap.remove(client)
+                postUnbind(oldUrl, client)
+            }
+            return BindStatus.REJECTED_BY_LIMIT
+        }
         clientRouteMap[client] = newUrl
+        urlOptionsMap[newUrl] = mediaOptions
+        markWarmConsumed(newUrl)
         val oldNode = if (oldUrl.isNotEmpty()) getNodeByUrl(oldUrl) else null
-        val newNode = getNodeByUrl(newUrl)
+        val (newIndex, newNode) = acquireNode(newUrl, client)
         if (oldNode != null && oldNode !== newNode) {
             oldNode.handler.post {
                 oldNode.handleUnbind(oldUrl, x5Surface)
-                newNode.handler.post {
-                    newNode.handleBind(newUrl, x5Surface, client, mediaOptions, maxStreamLimit)
-                }
+                postBind(newIndex, newNode, newUrl, x5Surface, client, mediaOptions, onBound)
             }
         } else {
             newNode.handler.post {
                 if (oldNode != null) {
                     newNode.handleUnbind(oldUrl, x5Surface)
                 }
+                scheduler.confirm(newUrl, newIndex)
                 newNode.handleBind(newUrl, x5Surface, client, mediaOptions, maxStreamLimit)
+                streamFpsMap[newUrl]?.let { newNode.handleStreamTargetFps(newUrl, it) }
+                admission.tierCapOf(newUrl)?.let { newNode.handleStreamTierCap(newUrl, it) }
+                onBound?.invoke(newNode, x5Surface)
+            }
+        }
+        prefetchPoster(newUrl, newNode)
+        return BindStatus.ACCEPTED
+    }
+
+    /**
+     * 异步切换客户端的视频源，Future 在新地址绑定落地后完成
+     */
+    fun switchClientUrlAsync(
+        oldUrl: String,
+        newUrl: String,
+        client: IVideoRenderClient,
+        mediaOptions: ArrayList<String> = defaultMediaArgs,
+        awaitFirstFrame: Boolean = false
+    ): CompletableFuture<BindResult> {
+        val future = CompletableFuture<BindResult>()
+        val status = requestSwitch(oldUrl, newUrl, client, mediaOptions) { node, x5Surface ->
+            node.handleBindResult(newUrl, x5Surface, awaitFirstFrame) { future.complete(it) }
+        }
+        if (status != BindStatus.ACCEPTED) future.complete(BindResult(newUrl, status))
+        return future
+    }
+
+    /**
+     * 整体提交一次页面切换的全部操作：先投递全部解绑腾出名额，再投递切换与绑定
+     * @param batch 操作集合
+     * @param awaitFirstFrame 是否等待每一路都出首帧
+     * @return 按 switches、binds 顺序排列的绑定结果
+     */
+    fun submitBatch(batch: RenderBatch, awaitFirstFrame: Boolean = false): CompletableFuture<List<BindResult>> {
+        batch.unbinds.forEach { (url, client) -> unbindClientAsync(url, client) }
+        val futures = ArrayList<CompletableFuture<BindResult>>(batch.switches.size + batch.binds.size)
+        batch.switches.forEach { (oldUrl, newUrl, client) ->
+            futures.add(switchClientUrlAsync(oldUrl, newUrl, client, awaitFirstFrame = awaitFirstFrame))
+        }
+        batch.binds.forEach { (url, client) ->
+            futures.add(bindClientAsync(url, client, awaitFirstFrame = awaitFirstFrame))
+        }
+        return CompletableFuture.allOf(*futures.toTypedArray()).thenApply { futures.map { it.join() } }
+    }
+
+    /**
+     * 以事务方式整体应用一次布局切换（如九宫格切到十六宫格）：
+     * 计算 url↔画布 的差异，地址不变的组件只同步尺寸，两种布局都出现的流原样保留不重建，
+     * 即将被重新绑定的画布不清屏。执行分两个阶段：所有节点先完成摘窗，随后每个节点在一次投递内
+     * 完成全部绑定、尺寸调整与暂留流的收尾，渲染循环只会看到切换前或切换后的完整状态。
+     * @param entries 参与切换的组件及其目标地址
+     * @return 按 entries 顺序排列的绑定结果，解绑项为 NOT_BOUND
+     */
+    fun applyLayout(
+        entries: List<LayoutEntry>,
+        mediaOptions: ArrayList<String> = defaultMediaArgs
+    ): CompletableFuture<List<BindResult>> {
+        val results = arrayOfNulls<BindResult>(entries.size)
+        val future = CompletableFuture<List<BindResult>>()
+        if (VLCEngineManager.libVLC == null) {
+            future.complete(entries.map { BindResult(it.url, BindStatus.NOT_BOUND) })
+            return future
+        }
+
+        class BindOp(val index: Int, val nodeIndex: Int, val url: String, val surface: Surface, val client: IVideoRenderClient)
+
+        val detaches = HashMap<IRenderNode, MutableList<Triple<String, Surface, Boolean>>>()
+        val resizes = HashMap<IRenderNode, MutableList<IVideoRenderClient>>()
+        val binds = HashMap<IRenderNode, MutableList<BindOp>>()
+        // 先归还旧布局的额度，新布局的流才能整体按优先级准入
+        entries.forEach { entry ->
+            clientRouteMap[entry.client]?.takeIf { it != entry.url }?.let { releaseAdmission(it, entry.client) }
+        }
+        entries.forEachIndexed { index, entry ->
+            val client = entry.client
+            val surface = client.getTargetSurface()
+            if (surface == null) {
+                results[index] = BindResult(entry.url, BindStatus.NOT_BOUND)
+                return@forEachIndexed
+            }
+            val oldUrl = clientRouteMap[client]
+            val oldNode = oldUrl?.let { getNodeByUrl(it) }
+            if (oldUrl != null && oldUrl == entry.url && oldNode != null) {
+                resizes.getOrPut(oldNode) { ArrayList() }.add(client)
+                binds.getOrPut(oldNode) { ArrayList() }
+                    .add(BindOp(index, -1, entry.url, surface, client))
+                return@forEachIndexed
+            }
+            val admitted = entry.url.isNotEmpty() && admitClient(entry.url, client)
+            if (oldUrl != null && oldNode != null) {
+                detaches.getOrPut(oldNode) { ArrayList() }.add(Triple(oldUrl, surface, !admitted))
+            }
+            if (!admitted) {
+                clientRouteMap.remove(client)
+                val status = if (entry.url.isEmpty()) BindStatus.NOT_BOUND else BindStatus.REJECTED_BY_LIMIT
+                results[index] = BindResult(entry.url, status)
+                return@forEachIndexed
+            }
+            clientRouteMap[client] = entry.url
+            urlOptionsMap[entry.url] = mediaOptions
+            markWarmConsumed(entry.url)
+            val (nodeIndex, node) = acquireNode(entry.url, client)
+            binds.getOrPut(node) { ArrayList() }.add(BindOp(index, nodeIndex, entry.url, surface, client))
+            prefetchPoster(entry.url, node)
+        }
+
+        val commitNodes = LinkedHashSet<IRenderNode>().apply {
+            addAll(detaches.keys)
+            addAll(resizes.keys)
+            addAll(binds.keys)
+        }
+        val pendingResults = AtomicInteger(binds.values.sumOf { it.size })
+        val completeIfDone = {
+            if (pendingResults.get() == 0) future.complete(results.map { it ?: BindResult("", BindStatus.NOT_BOUND) })
+        }
+
+        val commit = {
+            commitNodes.forEach { node ->
+                node.handler.post {
+                    val nodeBinds = binds[node].orEmpty()
+                    nodeBinds.forEach { op ->
+                        if (op.nodeIndex < 0) return@forEach
+                        scheduler.confirm(op.url, op.nodeIndex)
+                        node.handleBind(op.url, op.surface, op.client, mediaOptions, maxStreamLimit)
+                        streamFpsMap[op.url]?.let { node.handleStreamTargetFps(op.url, it) }
+                        admission.tierCapOf(op.url)?.let { node.handleStreamTierCap(op.url, it) }
+                    }
+                    resizes[node]?.forEach { client ->
+                        client.getTargetSurface()?.let { node.handleResize(it, client.getTargetWidth(), client.getTargetHeight()) }
+                    }
+                    node.handleLayoutSettle()
+                    nodeBinds.forEach { op ->
+                        node.handleBindResult(op.url, op.surface, false) { result ->
+                            results[op.index] = result
+                            pendingResults.decrementAndGet()
+                            completeIfDone()
+                        }
+                    }
+                }
+            }
+            completeIfDone()
+        }
+
+        // 跨节点搬迁的画布必须先在旧节点释放 EGL 表面，才能在新节点重新创建，因此提交阶段等待所有摘窗完成
+        if (detaches.isEmpty()) {
+            commit()
+        } else {
+            val pendingDetaches = AtomicInteger(detaches.size)
+            detaches.forEach { (node, ops) ->
+                node.handler.post {
+                    ops.forEach { (url, surface, clear) -> node.handleLayoutDetach(url, surface, clear) }
+                    if (pendingDetaches.decrementAndGet() == 0) commit()
+                }
             }
         }
+        return future
     }
 
     fun resizeClient(client: IVideoRenderClient) {
         val url = clientRouteMap[client] ?: return
         val x5Surface = client.getTargetSurface() ?: return
-        val node = getNodeByUrl(url)
+        val node = getNodeByUrl(url) ?: return
         node.handler.post {
             node.handleResize(x5Surface, client.getTargetWidth(), client.getTargetHeight())
         }
     }
 
+    /**
+     * 同步客户端在合成图层中的布局矩形，未开启合成模式时忽略
+     */
+    fun updateClientLayout(client: IVideoRenderClient) {
+        if (compositorNodeIndex < 0) return
+        val url = clientRouteMap[client] ?: return
+        val x5Surface = client.getTargetSurface() ?: return
+        val rect = client.getLayoutRect() ?: return
+        val node = getNodeByUrl(url) ?: return
+        node.handler.post { node.handleLayoutRect(x5Surface, rect) }
+    }
+
+    /**
+     * 开启合成模式：传入一张置于 WebView 之下、覆盖其全部区域的原生画布，
+     * 之后新绑定的可定位窗口都会作为瓦片绘制到这张画布上，每轮只需一次交换
+     * @param surface 图层画布
+     * @param width 图层物理宽度
+     * @param height 图层物理高度
+     */
+    fun attachCompositorLayer(surface: Surface, width: Int, height: Int) {
+        val current = compositorNodeIndex
+        val index = if (current >= 0) current else collectLoads().withIndex().minByOrNull { it.value.activeStreams }?.index ?: 0
+        compositorNodeIndex = index
+        val node = renderNodes[index]
+        node.handler.post { node.handleAttachLayer(surface, width, height) }
+    }
+
+    fun resizeCompositorLayer(width: Int, height: Int) {
+        val index = compositorNodeIndex
+        if (index < 0) return
+        val node = renderNodes[index]
+        node.handler.post { node.handleResizeLayer(width, height) }
+    }
+
+    /**
+     * 关闭合成模式，图层上的瓦片全部退回各自的独立画布
+     */
+    fun detachCompositorLayer() {
+        val index = compositorNodeIndex
+        if (index < 0) return
+        compositorNodeIndex = -1
+        val node = renderNodes[index]
+        node.handler.post { node.handleDetachLayer() }
+    }
+
+    fun setClientScaleMode(client: IVideoRenderClient, mode: ScaleMode) {
+        val url = clientRouteMap[client] ?: return
+        val x5Surface = client.getTargetSurface() ?: return
+        val node = getNodeByUrl(url) ?: return
+        node.handler.post { node.handleScaleMode(x5Surface, mode) }
+    }
+
+    fun setClientTargetFps(client: IVideoRenderClient, fps: Float) {
+        val url = clientRouteMap[client] ?: return
+        val x5Surface = client.getTargetSurface() ?: return
+        val node = getNodeByUrl(url) ?: return
+        node.handler.post { node.handleTargetFps(x5Surface, fps.coerceAtLeast(0f)) }
+    }
+
+    /**
+     * 挂起或恢复客户端：挂起时保持绑定与准入名额，窗口不再绘制；
+     * 流的全部窗口都挂起后暂停解码但保留网络会话，恢复可见时免去重新握手
+     * @param parked true 挂起，false 恢复
+     */
+    fun setClientParked(client: IVideoRenderClient, parked: Boolean) {
+        val url = clientRouteMap[client] ?: return
+        val x5Surface = client.getTargetSurface() ?: return
+        val node = getNodeByUrl(url) ?: return
+        node.handler.post { node.handleParkWindow(x5Surface, parked) }
+    }
+
     fun captureClientFrame(client: IVideoRenderClient, callback: (Bitmap?) -> Unit) {
         val url = clientRouteMap[client]
         if (url == null) {
             Handler(Looper.getMainLooper()).post { callback(null) }
             return
         }
-        val x5Surface = client.getTargetSurface() ?: return
+        val x5Surface = client.getTargetSurface()
         val node = getNodeByUrl(url)
+        if (node == null || x5Surface == null) {
+            Handler(Looper.getMainLooper()).post { callback(null) }
+            return
+        }
         node.handler.post { node.handleCapture(x5Surface, callback) }
     }
 
-    fun captureClientFrameSync(client: IVideoRenderClient): Bitmap? {
-        val url = clientRouteMap[client] ?: return null
-        val x5Surface = client.getTargetSurface() ?: return null
-        val node = getNodeByUrl(url)
-        var result: Bitmap? = null
-        val latch = CountDownLatch(1)
+    /**
+     * 异步截帧，调用方无需阻塞等待，可在协程中配合 awaitResult() 使用
+     * @return 截帧结果，失败时为 null
+     */
+    @JvmOverloads
+    fun captureClientFrameAsync(client: IVideoRenderClient, targetW: Int = 0, targetH: Int = 0): CompletableFuture<Bitmap?> {
+        return captureFrameOnNode(client, targetW, targetH, hardware = false)
+    }
+
+    /**
+     * 零拷贝异步截帧：Android 10 及以上由 GPU 直接缩放绘制到池化的 ImageReader，返回 HARDWARE 位图，低版本退回软件截帧。
+     * HARDWARE 位图不可读写像素，且与 ImageReader 共享显存，同尺寸连续截帧两次后最早的内容会被覆盖，
+     * 适合拖拽阴影这类即用即弃的场景，需要长期持有时请自行 copy
+     * @return 截帧结果，失败时为 null
+     */
+    @JvmOverloads
+    fun captureClientFrameHardwareAsync(client: IVideoRenderClient, targetW: Int = 0, targetH: Int = 0): CompletableFuture<Bitmap?> {
+        return captureFrameOnNode(client, targetW, targetH, hardware = true)
+    }
+
+    private fun captureFrameOnNode(
+        client: IVideoRenderClient,
+        targetW: Int,
+        targetH: Int,
+        hardware: Boolean
+    ): CompletableFuture<Bitmap?> {
+        val future = CompletableFuture<Bitmap?>()
+        val url = clientRouteMap[client]
+        val x5Surface = client.getTargetSurface()
+        val node = url?.let { getNodeByUrl(it) }
+        if (node == null || x5Surface == null) {
+            future.complete(null)
+            return future
+        }
         node.handler.post {
             try {
-                result = node.handleCaptureSync(x5Surface)
-            } finally {
-                latch.countDown()
+                val bitmap = node.handleCaptureSync(x5Surface, targetW, targetH, hardware)
+                // 调用方已超时取消时位图无人接收，就地回收
+                if (!future.complete(bitmap)) bitmap?.recycle()
+            } catch (e: Exception) {
+                future.completeExceptionally(e)
+            }
+        }
+        return future
+    }
+
+    /**
+     * 批量异步截帧：按节点分组后每个节点一次性读回，适合周期性的多路缩略图采集
+     * @param clients 待截帧的客户端
+     * @param callback 主线程回调，未绑定或失败的客户端对应 null
+     */
+    fun captureFrames(clients: List<IVideoRenderClient>, callback: (Map<IVideoRenderClient, Bitmap?>) -> Unit) {
+        val mainHandler = Handler(Looper.getMainLooper())
+        val results = HashMap<IVideoRenderClient, Bitmap?>()
+        val groups = HashMap<IRenderNode, MutableList<Pair<IVideoRenderClient, Surface>>>()
+        clients.forEach { client ->
+            val url = clientRouteMap[client]
+            val x5Surface = client.getTargetSurface()
+            val node = url?.let { getNodeByUrl(it) }
+            if (node == null || x5Surface == null) {
+                results[client] = null
+            } else {
+                groups.getOrPut(node) { ArrayList() }.add(Pair(client, x5Surface))
+            }
+        }
+        if (groups.isEmpty()) {
+            mainHandler.post { callback(results) }
+            return
+        }
+        var pendingNodes = groups.size
+        groups.forEach { (node, entries) ->
+            node.handler.post {
+                node.handleCaptureBatch(entries.map { it.second }) { bitmaps ->
+                    entries.forEachIndexed { index, entry -> results[entry.first] = bitmaps[index] }
+                    pendingNodes--
+                    if (pendingNodes == 0) callback(results)
+                }
             }
         }
-        latch.await(200, TimeUnit.MILLISECONDS)
-        return result
+    }
+
+    /**
+     * 归还用完的截帧位图，供后续同尺寸的异步截帧复用
+     * @param bitmap 不再使用的截帧位图
+     */
+    fun recycleFrame(bitmap: Bitmap) {
+        CaptureBitmapPool.release(bitmap)
+    }
+
+    /**
+     * 同步截取客户端画布当前画面，返回软件位图，会阻塞调用线程最多 200ms，新代码请使用 captureClientFrameAsync
+     * @param client 渲染客户端
+     * @param targetW 期望输出宽度，传 0 使用解码分辨率；拖拽阴影等场景可直接请求缩小尺寸
+     * @param targetH 期望输出高度
+     */
+    @JvmOverloads
+    fun captureClientFrameSync(client: IVideoRenderClient, targetW: Int = 0, targetH: Int = 0): Bitmap? {
+        return try {
+            captureClientFrameAsync(client, targetW, targetH).get(200, TimeUnit.MILLISECONDS)
+        } catch (e: Exception) {
+            null
+        }
     }
 
     fun clearClient(client: IVideoRenderClient) {
         val x5Surface = client.getTargetSurface() ?: return
         val url = clientRouteMap[client]
-        val node = if (url != null) getNodeByUrl(url) else renderNodes[0]
+        val node = url?.let { getNodeByUrl(it) } ?: renderNodes[0]
         node.handler.post { node.handleClearSurface(x5Surface) }
     }
 
@@ -166,23 +1092,116 @@ object VLCRenderPool {
         var totalStreams = 0
         renderNodes.forEach { totalStreams += it.getActiveStreamCount() }
         Log.w("VLCDecoder", "Total Active Decoders $totalStreams Limit $maxStreamLimit")
+        Log.w(
+            "VLCDecoder",
+            "Admission ${admission.admittedStreams()} streams ${admission.usedPixelsPerSecond()}/${admission.budgetPixelsPerSecond} px/s"
+        )
 
         renderNodes.forEachIndexed { index, node ->
             node.printNodeDiagnostics(index)
         }
     }
 
+    private val metricsHandler = Handler(Looper.getMainLooper())
+
+    /** 最近一次采集完成的指标快照 */
+    @Volatile
+    private var lastMetrics: EngineMetrics? = null
+
+    /**
+     * 返回最近一次采集完成的指标快照，同时在后台发起下一次采集，调用线程不等待节点线程。
+     * 适合每秒轮询一次，每次拿到的是上一轮采集的区间值；首次调用时还没有节点数据
+     * @return 引擎指标快照
+     */
+    fun getMetrics(): EngineMetrics {
+        val last = lastMetrics
+        getMetricsAsync()
+        return last ?: buildMetrics(emptyList())
+    }
+
+    /**
+     * 异步采集全部节点的运行指标，每个节点在自己的线程上完成采样。
+     * 全部节点上报后完成；最多等待 100ms，超时未返回的节点本次不计入
+     * @return 主线程或最后上报的节点线程上完成的指标快照
+     */
+    fun getMetricsAsync(): CompletableFuture<EngineMetrics> {
+        val future = CompletableFuture<EngineMetrics>()
+        if (!renderNodesLazy.isInitialized()) {
+            future.complete(buildMetrics(emptyList()))
+            return future
+        }
+        val results = arrayOfNulls<NodeMetrics>(renderNodes.size)
+        val remaining = AtomicInteger(renderNodes.size)
+        val finish = object : Runnable {
+            override fun run() {
+                metricsHandler.removeCallbacks(this)
+                val metrics = buildMetrics(synchronized(results) { results.filterNotNull() })
+                if (future.complete(metrics)) lastMetrics = metrics
+            }
+        }
+        renderNodes.forEachIndexed { index, node ->
+            node.handler.post {
+                try {
+                    val nodeMetrics = node.collectMetrics(index)
+                    synchronized(results) { results[index] = nodeMetrics }
+                } finally {
+                    if (remaining.decrementAndGet() == 0) finish.run()
+                }
+            }
+        }
+        metricsHandler.postDelayed(finish, METRICS_TIMEOUT_MS)
+        return future
+    }
+
+    private fun buildMetrics(nodes: List<NodeMetrics>): EngineMetrics {
+        val decoders = JSONObject()
+            .put("capabilities", DecoderCapabilities.toJson())
+            .put("sessions", decodeLedger.toJson())
+            .put("quarantinedPlayers", PlayerLifecycleExecutor.quarantinedCount)
+        return EngineMetrics.of(model.name, nodes, decoders, CpuTopology.toJson())
+    }
+
     fun releaseWorkspace() {
         surfaceRouteMap.clear()
+        synchronized(warmLru) { warmLru.clear() }
+        scheduler.clear()
+        urlOptionsMap.clear()
+        streamFpsMap.clear()
+        admission.clear()
         renderNodes.forEach { node ->
             node.handler.post { node.clearWorkspace() }
         }
     }
 
-    fun release() {
+    /**
+     * 销毁全部节点
+     * @param onReleased 所有节点的播放器释放完毕后回调，基于全局引擎创建的播放器此时已全部释放，运行在最后完成的节点线程上
+     */
+    fun release(onReleased: () -> Unit = {}) {
+        stopSnapshots()
+        stopLoadSampling()
+        compositorNodeIndex = -1
+        PosterCache.clearMemory()
         surfaceRouteMap.clear()
+        synchronized(warmLru) { warmLru.clear() }
+        scheduler.clear()
+        urlOptionsMap.clear()
+        admission.clear()
+        decodeLedger.clear()
+        reconnectPolicies.clear()
+        latencyProfiles.clear()
+        imageEnhancements.clear()
+        HostCircuitBreaker.clear()
+        lastMetrics = null
+        if (!renderNodesLazy.isInitialized()) {
+            onReleased()
+            return
+        }
+        val remaining = AtomicInteger(renderNodes.size)
         renderNodes.forEach { node ->
-            node.destroyNode()
+            node.destroyNode {
+                if (remaining.decrementAndGet() == 0) onReleased()
+            }
         }
     }
 }
\ No newline at end of file
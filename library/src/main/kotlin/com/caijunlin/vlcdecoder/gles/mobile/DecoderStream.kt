@@ -19,7 +19,6 @@ class DecoderStream(
     onStreamDead: (String) -> Unit
 ) : BaseDecoderStream(url, eglCore, renderHandler, mediaOptions, onStreamDead) {
 
-    @Volatile var hasNewFboData = false
     @Volatile private var lastWatchdogTimeMs: Long = 0L
 
     override val watchdogRunnable = object : Runnable {
@@ -29,14 +28,14 @@ class DecoderStream(
                     val waitFirstFrameTime = System.currentTimeMillis() - startPlayTimeMs
                     if (waitFirstFrameTime > 15000L) {
                         Log.e("VLCDecoder", "Watchdog Bite! 15s timeout waiting for FIRST frame: $url")
-                        retryPlay()
+                        scheduleReconnect("first frame timeout")
                         return
                     }
                 } else {
                     val idleTime = System.currentTimeMillis() - lastWatchdogTimeMs
                     if (idleTime > 5000L) {
                         Log.e("VLCDecoder", "Watchdog Bite! Video completely frozen for 5s: $url")
-                        retryPlay()
+                        scheduleReconnect("frozen")
                         return
                     }
                 }
@@ -55,21 +54,22 @@ class DecoderStream(
 
     override fun onFrameAvailable(st: SurfaceTexture) {
         lastWatchdogTimeMs = System.currentTimeMillis()
+        frameArrivalNs = System.nanoTime()
+        if (consumesInBackground) {
+            consumeBackgroundFrame(st)
+            return
+        }
         try {
             eglCore.makeCurrentMain()
-            st.updateTexImage()
-            st.getTransformMatrix(transformMatrix)
+            latchFrame(st)
 
-            if (!hasFirstFrame) {
-                checkAndUpdateResolution()
-                hasFirstFrame = true
+            if (onFrameLatched()) {
                 displayWindows.forEach { window ->
-                    window.clientRef.get()?.onFirstFrameRendered(url)
+                    window.notifyFirstFrame(url)
                 }
             }
 
-            eglCore.drawOESToFBO(fboId, oesTextureId, transformMatrix, videoWidth, videoHeight)
-            hasNewFboData = true
+            commitFrame()
         } catch (e: Exception) {
             Log.e("VLCDecoder", "OES Fast Consume failed: ${e.message}")
         }
@@ -1,6 +1,5 @@
 package com.caijunlin.vlcdecoder.gles.mobile
 
-import android.opengl.Matrix
 import android.util.Log
 import android.view.Choreographer
 import android.view.Surface
@@ -8,11 +7,12 @@ import com.caijunlin.vlcdecoder.gles.BaseRenderNode
 import com.caijunlin.vlcdecoder.gles.DisplayWindow
 import com.caijunlin.vlcdecoder.gles.EGLCore
 import com.caijunlin.vlcdecoder.gles.IVideoRenderClient
+import com.caijunlin.vlcdecoder.gles.ResolutionTier
 
 /**
  * @author caijunlin
  * @date   2026/3/10
- * @description 手机端专属渲染管线：挂载系统 Choreographer 进行锁 30fps 的等分分发，让位系统 UI。
+ * @description 手机端专属渲染管线：挂载系统 Choreographer 逐 VSync 检查，由 FramePacer 按源帧率与窗口目标帧率做 PTS 感知的上屏决策，全局上限让位系统 UI。
  */
 class RenderNode(
     nodeName: String,
@@ -21,11 +21,10 @@ class RenderNode(
 
     private var choreographer: Choreographer? = null
     private var isTicking = false
-    private var frameCounter = 0
 
     private val frameCallback = object : Choreographer.FrameCallback {
         override fun doFrame(frameTimeNanos: Long) {
-            doThrottledRender()
+            doPacedRender()
             if (isTicking && streams.isNotEmpty()) {
                 choreographer?.postFrameCallback(this)
             } else {
@@ -48,6 +47,12 @@ class RenderNode(
         }
     }
 
+    override fun createStream(url: String, opts: ArrayList<String>): DecoderStream {
+        return DecoderStream(url, eglCore, handler, opts) { deadUrl -> handleStreamDead(deadUrl) }.apply {
+            engineIndex = this@RenderNode.engineIndex
+        }
+    }
+
     override fun handleBind(
         url: String,
         x5Surface: Surface,
@@ -56,60 +61,95 @@ class RenderNode(
         limit: Int
     ) {
         if (displayMap.containsKey(x5Surface)) return
-        pendingReleaseTasks.remove(url)?.let { handler.removeCallbacks(it) }
 
         var stream = streams[url]
+        var isNewWindowOnExisting = false
+        if (stream == null && !hasBindSlot(url, limit)) {
+            handleStreamRejected(url)
+            return
+        }
         if (stream == null) {
-            if (streams.size >= limit) return
-            stream = DecoderStream(url, eglCore, handler, opts) { deadUrl -> handleStreamDead(deadUrl) }
+            stream = reviveIdleStream(url) ?: promoteWarmStream(url)
+        }
+        if (stream == null) {
+            recordLingerMiss()
+            stream = createStream(url, opts)
+            stream.directRender = directRenderEnabled
+            stream.updateResolutionTier(
+                ResolutionTier.fit(client.getTargetWidth(), client.getTargetHeight(), maxResolutionTier)
+            )
             stream.start()
-            streams[url] = stream
+            addActiveStream(url, stream)
+        } else {
+            isNewWindowOnExisting = true
         }
 
         val window = DisplayWindow(x5Surface, client)
-        window.initEGLSurface(eglCore)
+        attachWindowTarget(window, client)
         window.physicalW = client.getTargetWidth()
         window.physicalH = client.getTargetHeight()
         window.isDirty = true
 
-        stream.displayWindows.add(window)
-        displayMap[x5Surface] = window
+        attachWindow(stream, window)
+        if (isNewWindowOnExisting) {
+            scheduleTierUpdate(stream)
+            if (stream.hasFirstFrame) window.notifyFirstFrame(url)
+        }
+        if (!stream.hasFirstFrame) handlePosterReady(url)
 
         startTicking()
     }
 
-    private fun doThrottledRender() {
-        frameCounter++
-        if (frameCounter % 2 != 0) return
-
+    private fun doPacedRender() {
+        val tickStartNs = System.nanoTime()
         var hasActiveDraws = false
-        for (stream in streams.values) {
-            val needsRender = stream.hasNewFboData
-            stream.hasNewFboData = false
-
-            for (window in stream.displayWindows) {
-                if (!window.x5Surface.isValid) continue
-
-                if (needsRender || window.isDirty) {
+        // 主窗口先交换，副窗口排在其后，拥塞时副窗口先被降频
+        for (pass in 0..1) {
+            val isPrimaryPass = pass == 0
+            for (i in 0 until activeStreams.size) {
+                val stream = activeStreams[i]
+                val pts = stream.lastPts
+                val windows = stream.displayWindows
+
+                for (j in 0 until windows.size) {
+                    val window = windows[j]
+                    if (window.isPrimary != isPrimaryPass) continue
+                    if (window.isComposited || window.isParked || !window.x5Surface.isValid) continue
+
+                    val hasPendingFrame = stream.hasFirstFrame && window.presentedPts != pts
+                    if (!shouldPresentFrame(window, stream, hasPendingFrame, pts)) continue
                     try {
                         if (eglCore.makeCurrent(window.eglSurface, eglCore.eglContext)) {
                             eglCore.setSwapInterval(0)
-                            Matrix.setIdentityM(window.mvpMatrix, 0)
-                            eglCore.drawTex2DScreen(stream.tex2DId, window.mvpMatrix, window.physicalW, window.physicalH)
+                            if (stream.presentationTimeNs > 0L) {
+                                eglCore.setPresentationTime(window.eglSurface, stream.presentationTimeNs)
+                            }
+                            stream.drawToWindow(window, window.physicalW, window.physicalH)
+                            val swapStartNs = System.nanoTime()
                             eglCore.swapBuffers(window.eglSurface)
+                            val swapCostNs = System.nanoTime() - swapStartNs
+                            stream.counters.swap.record(swapCostNs)
+                            stream.recordPresented()
+                            framePacer.onSwapped(window, stream, swapCostNs / 1_000_000f)
 
+                            window.presentedPts = pts
                             window.isDirty = false
                             hasActiveDraws = true
                         }
                     } catch (e: Exception) {
-                        Log.e("VLCDecoder", "Throttled Swap failed: ${e.message}")
+                        Log.e("VLCDecoder", "Paced Swap failed: ${e.message}")
                     }
                 }
             }
         }
 
+        if (composeLayer()) hasActiveDraws = true
+
         if (hasActiveDraws) {
             eglCore.makeCurrentMain()
+            recordTickCost(System.nanoTime() - tickStartNs)
+        } else if (streams.isEmpty()) {
+            resetTickCost()
         }
     }
 
@@ -119,13 +159,20 @@ class RenderNode(
                 window.physicalW = width
                 window.physicalH = height
 
-                val targetStream = streams.values.find { it.displayWindows.contains(window) }
+                val targetStream = streamOf(window)
+                targetStream?.let {
+                    updateFanOut(it)
+                    scheduleTierUpdate(it)
+                }
+                if (window.isComposited) {
+                    window.isDirty = true
+                    return
+                }
                 if (targetStream != null && targetStream.hasFirstFrame) {
                     if (!window.x5Surface.isValid) return
                     try {
                         if (eglCore.makeCurrent(window.eglSurface, eglCore.eglContext)) {
-                            Matrix.setIdentityM(window.mvpMatrix, 0)
-                            eglCore.drawTex2DScreen(targetStream.tex2DId, window.mvpMatrix, width, height)
+                            targetStream.drawToWindow(window, width, height)
                             eglCore.swapBuffers(window.eglSurface)
                         }
                     } catch (e: Exception) {
@@ -10,7 +10,7 @@ import java.util.concurrent.atomic.AtomicBoolean
 /**
  * @author caijunlin
  * @date   2026/3/10
- * @description RK 专属解码流。采用异步立标结合主循环 Polling 模式消费图像数据。
+ * @description RK 专属解码流。新帧到达时立标并唤醒节点的渲染循环，由渲染循环合批消费图像数据。
  */
 class DecoderStream(
     url: String,
@@ -22,7 +22,12 @@ class DecoderStream(
 
     val frameAvailable = AtomicBoolean(false)
 
-    @Volatile var lastPts: Long = 0L
+    /** 本轮渲染循环是否锁定了新帧，仅在节点线程读写 */
+    var hasNewFrame = false
+
+    /** 新帧到达时唤醒渲染循环，由所属节点注入，在节点线程回调 */
+    var onFrameSignal: (() -> Unit)? = null
+
     @Volatile private var lastWatchdogPts: Long = 0L
 
     override val watchdogRunnable = object : Runnable {
@@ -32,13 +37,13 @@ class DecoderStream(
                     val waitFirstFrameTime = System.currentTimeMillis() - startPlayTimeMs
                     if (waitFirstFrameTime > 15000L) {
                         Log.e("VLCDecoder", "Watchdog Bite! 15s timeout waiting for FIRST frame: $url")
-                        retryPlay()
+                        scheduleReconnect("first frame timeout")
                         return
                     }
                 } else {
                     if (lastPts != 0L && lastPts == lastWatchdogPts) {
                         Log.e("VLCDecoder", "Watchdog Bite! Video PTS completely frozen at $lastPts: $url")
-                        retryPlay()
+                        scheduleReconnect("frozen")
                         return
                     }
                     lastWatchdogPts = lastPts
@@ -57,6 +62,12 @@ class DecoderStream(
     }
 
     override fun onFrameAvailable(st: SurfaceTexture) {
+        frameArrivalNs = System.nanoTime()
+        if (consumesInBackground) {
+            consumeBackgroundFrame(st)
+            return
+        }
         frameAvailable.set(true)
+        onFrameSignal?.invoke()
     }
 }
\ No newline at end of file
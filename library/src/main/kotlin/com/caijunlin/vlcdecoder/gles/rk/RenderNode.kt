@@ -1,30 +1,37 @@
 package com.caijunlin.vlcdecoder.gles.rk
 
 import android.opengl.GLES30
-import android.opengl.Matrix
+import android.os.SystemClock
 import android.util.Log
 import android.view.Surface
 import com.caijunlin.vlcdecoder.gles.BaseRenderNode
 import com.caijunlin.vlcdecoder.gles.DisplayWindow
 import com.caijunlin.vlcdecoder.gles.EGLCore
+import com.caijunlin.vlcdecoder.gles.FramePacer
 import com.caijunlin.vlcdecoder.gles.IVideoRenderClient
-import java.util.concurrent.ConcurrentHashMap
+import com.caijunlin.vlcdecoder.gles.ResolutionTier
 
 /**
  * @author caijunlin
  * @date   2026/3/10
- * @description RK 专属渲染管线：脱离系统编排机制，内部轮询严格控制 25FPS 与动态拥堵检测惩罚机制。
+ * @description RK 专属渲染管线：脱离系统编排机制，渲染循环由新帧信号驱动，没有新帧时完全休眠；
+ * 短时间内到达的多路新帧合并为一轮渲染，按源帧率推算的轮询周期只作为两轮之间的最短间隔。
+ * 由 FramePacer 逐窗口做 PTS 感知的上屏决策，并保留动态拥堵检测惩罚机制。
  */
 class RenderNode(
     nodeName: String,
     onStreamDeadCleanup: (String, List<Surface>) -> Unit
 ) : BaseRenderNode<DecoderStream>(nodeName, onStreamDeadCleanup) {
 
-    private val congestedWindows = ConcurrentHashMap<Surface, Boolean>()
+    /** 是否已有一轮渲染被排期或正在执行 */
     private var isTicking = false
     private val tickRunnable = Runnable { doTick() }
-    private val streamsToRender = ArrayList<DecoderStream>(8)
-    private val farmerMs = 40L
+
+    /** 上一轮渲染开始的时刻 */
+    private var lastTickStartMs = 0L
+
+    /** 两轮渲染之间的最短间隔 */
+    private var pacingIntervalMs = 0L
 
     init {
         handler.post {
@@ -32,6 +39,9 @@ class RenderNode(
         }
     }
 
+    /**
+     * 窗口变更等需要立即重绘的场景，跳过合批直接排期一轮渲染
+     */
     private fun startTicking() {
         if (!isTicking) {
             isTicking = true
@@ -39,6 +49,24 @@ class RenderNode(
         }
     }
 
+    /**
+     * 新帧信号：等待一个合批窗口再渲染，且不早于上一轮开始后的最短间隔
+     */
+    private fun onFrameSignal() {
+        if (isTicking) return
+        isTicking = true
+        val sinceLastMs = SystemClock.uptimeMillis() - lastTickStartMs
+        val delayMs = maxOf(FramePacer.FRAME_COALESCE_MS, pacingIntervalMs - sinceLastMs)
+        handler.postDelayed(tickRunnable, delayMs)
+    }
+
+    override fun createStream(url: String, opts: ArrayList<String>): DecoderStream {
+        return DecoderStream(url, eglCore, handler, opts) { deadUrl -> handleStreamDead(deadUrl) }.apply {
+            engineIndex = this@RenderNode.engineIndex
+            onFrameSignal = { this@RenderNode.onFrameSignal() }
+        }
+    }
+
     override fun handleBind(
         url: String,
         x5Surface: Surface,
@@ -47,41 +75,61 @@ class RenderNode(
         limit: Int
     ) {
         if (displayMap.containsKey(x5Surface)) return
-        pendingReleaseTasks.remove(url)?.let { handler.removeCallbacks(it) }
 
         var stream = streams[url]
+        var isNewWindowOnExisting = false
+        if (stream == null && !hasBindSlot(url, limit)) {
+            handleStreamRejected(url)
+            return
+        }
         if (stream == null) {
-            if (streams.size >= limit) return
-            stream = DecoderStream(url, eglCore, handler, opts) { deadUrl -> handleStreamDead(deadUrl) }
+            stream = reviveIdleStream(url) ?: promoteWarmStream(url)
+        }
+        if (stream == null) {
+            recordLingerMiss()
+            stream = createStream(url, opts)
+            stream.directRender = directRenderEnabled
+            stream.updateResolutionTier(
+                ResolutionTier.fit(client.getTargetWidth(), client.getTargetHeight(), maxResolutionTier)
+            )
             stream.start()
-            streams[url] = stream
+            addActiveStream(url, stream)
+        } else {
+            isNewWindowOnExisting = true
         }
 
         val window = DisplayWindow(x5Surface, client)
-        window.initEGLSurface(eglCore)
+        attachWindowTarget(window, client)
         window.physicalW = client.getTargetWidth()
         window.physicalH = client.getTargetHeight()
         window.isDirty = true
 
-        if (eglCore.makeCurrent(window.eglSurface, eglCore.eglContext)) {
+        if (!window.isComposited && eglCore.makeCurrent(window.eglSurface, eglCore.eglContext)) {
             eglCore.setSwapInterval(0)
             eglCore.makeCurrentMain()
         }
 
-        stream.displayWindows.add(window)
-        displayMap[x5Surface] = window
+        attachWindow(stream, window)
+        if (isNewWindowOnExisting) {
+            scheduleTierUpdate(stream)
+            if (stream.hasFirstFrame) window.notifyFirstFrame(url)
+        }
+        if (!stream.hasFirstFrame) handlePosterReady(url)
 
         startTicking()
     }
 
     private fun doTick() {
         val tickStartNs = System.nanoTime()
+        lastTickStartMs = SystemClock.uptimeMillis()
         var hasActiveDraws = false
         var isDummyCurrent = false
-        streamsToRender.clear()
+        val streamCount = activeStreams.size
 
-        for (stream in streams.values) {
-            if (stream.displayWindows.isEmpty()) continue
+        for (i in 0 until streamCount) {
+            val stream = activeStreams[i]
+            stream.hasNewFrame = false
+            if (stream.displayWindows.isEmpty() || stream.isParked) continue
             hasActiveDraws = true
 
             if (stream.frameAvailable.getAndSet(false)) {
@@ -90,20 +138,16 @@ class RenderNode(
                     isDummyCurrent = true
                 }
                 try {
-                    stream.surfaceTexture?.updateTexImage()
-                    stream.lastPts = stream.surfaceTexture?.timestamp ?: 0L
-                    stream.surfaceTexture?.getTransformMatrix(stream.transformMatrix)
+                    stream.surfaceTexture?.let { stream.latchFrame(it) }
 
-                    if (!stream.hasFirstFrame) {
-                        stream.checkAndUpdateResolution()
-                        stream.hasFirstFrame = true
+                    if (stream.onFrameLatched()) {
                         stream.displayWindows.forEach { window ->
-                            window.clientRef.get()?.onFirstFrameRendered(stream.url)
+                            window.notifyFirstFrame(stream.url)
                         }
                     }
 
-                    eglCore.drawOESToFBO(stream.fboId, stream.oesTextureId, stream.transformMatrix, stream.videoWidth, stream.videoHeight)
-                    streamsToRender.add(stream)
+                    stream.commitFrame()
+                    stream.hasNewFrame = true
                 } catch (e: Exception) {
                     Log.e("VLCDecoder", "OES mapping failed: ${e.message}")
                 }
@@ -114,43 +158,39 @@ class RenderNode(
             GLES30.glFlush()
         }
 
-        for (stream in streams.values) {
-            val windows = stream.displayWindows
-            if (windows.isEmpty()) continue
+        // 先交换各路流的主窗口，副窗口排在其后：副窗口的交换即使阻塞在缓冲队列上，也不会推迟主画面
+        for (pass in 0..1) {
+            val isPrimaryPass = pass == 0
+            for (i in 0 until streamCount) {
+                val stream = activeStreams[i]
+                val windows = stream.displayWindows
+                if (windows.isEmpty() || stream.isParked) continue
 
-            val hasNewFrame = streamsToRender.contains(stream)
-            for (j in 0 until windows.size) {
-                val window = windows[j]
-                val pw = window.physicalW
-                val ph = window.physicalH
-                if (pw == 0 || ph == 0) continue
-
-                if (hasNewFrame || window.isDirty) {
-                    val isCongested = congestedWindows[window.x5Surface] ?: false
-                    if (isCongested) {
-                        congestedWindows[window.x5Surface] = false
-                        window.isDirty = false
-                        continue
-                    }
+                val hasNewFrame = stream.hasNewFrame
+                for (j in 0 until windows.size) {
+                    val window = windows[j]
+                    if (window.isPrimary != isPrimaryPass || window.isComposited || window.isParked) continue
+                    val pw = window.physicalW
+                    val ph = window.physicalH
+                    if (pw == 0 || ph == 0) continue
+                    if (!shouldPresentFrame(window, stream, hasNewFrame, stream.lastPts)) continue
 
                     try {
                         if (eglCore.makeCurrent(window.eglSurface, eglCore.eglContext)) {
                             eglCore.setSwapInterval(0)
-                            if (stream.lastPts > 0L) {
-                                eglCore.setPresentationTime(window.eglSurface, stream.lastPts)
+                            if (stream.presentationTimeNs > 0L) {
+                                eglCore.setPresentationTime(window.eglSurface, stream.presentationTimeNs)
                             }
-                            Matrix.setIdentityM(window.mvpMatrix, 0)
-                            eglCore.drawTex2DScreen(stream.tex2DId, window.mvpMatrix, pw, ph)
+                            stream.drawToWindow(window, pw, ph)
 
                             val swapStartNs = System.nanoTime()
                             eglCore.swapBuffers(window.eglSurface)
-                            val swapCostMs = (System.nanoTime() - swapStartNs) / 1_000_000f
+                            val swapCostNs = System.nanoTime() - swapStartNs
+                            stream.counters.swap.record(swapCostNs)
+                            stream.recordPresented()
+                            framePacer.onSwapped(window, stream, swapCostNs / 1_000_000f)
 
-                            if (swapCostMs > 25f) {
-                                congestedWindows[window.x5Surface] = true
-                            } else {
-                                congestedWindows[window.x5Surface] = false
-                            }
+                            window.presentedPts = stream.lastPts
                             window.isDirty = false
                         }
                     } catch (e: Exception) {
@@ -160,27 +200,61 @@ class RenderNode(
             }
         }
 
+        composeLayer()
+
         if (hasActiveDraws) {
-            val costMs = (System.nanoTime() - tickStartNs) / 1_000_000L
-            val delayMs = if (costMs < farmerMs) farmerMs - costMs else 5L
-            handler.postDelayed(tickRunnable, delayMs)
+            val costNs = System.nanoTime() - tickStartNs
+            recordTickCost(costNs)
+            pacingIntervalMs = framePacer.pacingIntervalMs(activeStreams)
+            if (hasPendingWork()) {
+                handler.postDelayed(tickRunnable, framePacer.nextPollDelayMs(activeStreams, costNs / 1_000_000L))
+            } else {
+                // 没有待处理的帧与重绘，休眠到下一个新帧信号
+                isTicking = false
+            }
         } else {
             isTicking = false
+            resetTickCost()
             eglCore.makeCurrentMain()
         }
     }
 
+    /**
+     * 本轮结束后是否仍有工作：渲染期间又到达了新帧，或有窗口仍待重绘
+     */
+    private fun hasPendingWork(): Boolean {
+        for (i in 0 until activeStreams.size) {
+            val stream = activeStreams[i]
+            val windows = stream.displayWindows
+            if (windows.isEmpty()) continue
+            if (stream.frameAvailable.get()) return true
+            for (j in 0 until windows.size) {
+                val window = windows[j]
+                if (window.isDirty && !window.isParked && window.physicalW > 0 && window.physicalH > 0) return true
+            }
+        }
+        return false
+    }
+
     override fun handleResize(x5Surface: Surface, width: Int, height: Int) {
-        displayMap[x5Surface]?.let {
-            if (it.physicalW != width || it.physicalH != height) {
-                it.physicalW = width
-                it.physicalH = height
-                it.isDirty = true
+        displayMap[x5Surface]?.let { window ->
+            if (window.physicalW != width || window.physicalH != height) {
+                window.physicalW = width
+                window.physicalH = height
+                window.isDirty = true
+                streamOf(window)?.let {
+                    updateFanOut(it)
+                    scheduleTierUpdate(it)
+                }
                 startTicking()
             }
         }
     }
 
+    override fun requestRender() {
+        startTicking()
+    }
+
     override fun clearWorkspace() {
         handler.removeCallbacks(tickRunnable)
         isTicking = false
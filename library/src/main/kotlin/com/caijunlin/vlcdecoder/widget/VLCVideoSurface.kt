@@ -10,14 +10,21 @@ import android.view.MotionEvent
 import android.view.Surface
 import com.caijunlin.vlcdecoder.core.StreamWebView
 import com.caijunlin.vlcdecoder.gesture.VideoGestureHelper
+import com.caijunlin.vlcdecoder.gles.AdmissionState
+import com.caijunlin.vlcdecoder.gles.BindResult
 import com.caijunlin.vlcdecoder.gles.IVideoRenderClient
+import com.caijunlin.vlcdecoder.gles.LayoutEntry
+import com.caijunlin.vlcdecoder.gles.ScaleMode
+import com.caijunlin.vlcdecoder.gles.LatencyProfile
+import com.caijunlin.vlcdecoder.gles.StreamPriority
 import com.caijunlin.vlcdecoder.gles.VLCRenderPool
 import com.tencent.smtt.export.external.embeddedwidget.interfaces.IEmbeddedWidgetClient
 import kotlin.math.ceil
+import kotlin.math.roundToInt
 
 class VLCVideoSurface(
     var webView: StreamWebView,
-    private val tagName: String,
+    val tagName: String,
     attributes: Map<String, String>,
     private val displayMetrics: DisplayMetrics
 ) : IEmbeddedWidgetClient, IVideoRenderClient {
@@ -33,6 +40,14 @@ class VLCVideoSurface(
         get() = _attributes["videoData".lowercase()] ?: ""
     private val draggable: Int
         get() = _attributes["_draggable".lowercase()]?.toIntOrNull() ?: 0
+    private val videoScaleMode: ScaleMode
+        get() = ScaleMode.fromAttribute(_attributes["scaleMode".lowercase()])
+    private val videoTargetFps: Float
+        get() = _attributes["targetFps".lowercase()]?.toFloatOrNull() ?: 0f
+    private val videoPriority: StreamPriority
+        get() = StreamPriority.fromAttribute(_attributes["priority"])
+    private val videoLatency: LatencyProfile?
+        get() = _attributes["latency"]?.let { LatencyProfile.fromAttribute(it) }
 
     private var rect: Rect? = null
     private var surfaceWidth: Int = 0
@@ -44,10 +59,26 @@ class VLCVideoSurface(
 
     // 真实的业务状态确认
     private var isActuallyPlaying = false
+
+    // 不可见时挂起而不解绑，恢复可见时免去重连
+    private var isParked = false
     override fun getElementId(): String = id
     override fun getTargetSurface(): Surface? = x5Surface
     override fun getTargetWidth(): Int = surfaceWidth
     override fun getTargetHeight(): Int = surfaceHeight
+    override fun getScaleMode(): ScaleMode = videoScaleMode
+    override fun getTargetFps(): Float = videoTargetFps
+    override fun getPriority(): StreamPriority = videoPriority
+    /** 最近一次上报的布局矩形(CSS 像素)，供组件索引在登记时补齐 */
+    internal fun currentRect(): Rect? = rect
+
+    override fun getLayoutRect(): Rect? {
+        val r = rect ?: return null
+        val density = displayMetrics.density
+        val left = (r.left * density).roundToInt()
+        val top = (r.top * density).roundToInt()
+        return Rect(left, top, left + surfaceWidth, top + surfaceHeight)
+    }
     private var gestureHelper: VideoGestureHelper = VideoGestureHelper(
         client = this,
         webView = webView,
@@ -95,7 +126,8 @@ class VLCVideoSurface(
                     pendingBoundUrl = videoSrc
                     isActuallyPlaying = false
                     Log.i("VLCDecoder", "bindClient $id $videoSrc")
-                    VLCRenderPool.bindClient(videoSrc, this)
+                    videoLatency?.let { VLCRenderPool.setLatencyProfile(videoSrc, it) }
+                    VLCRenderPool.bindClientAsync(videoSrc, this).thenAccept { onBindResult(it) }
                 }
             } else {
                 if (pendingBoundUrl != null) {
@@ -108,6 +140,7 @@ class VLCVideoSurface(
     }
 
     private fun unbind() {
+        isParked = false
         if (pendingBoundUrl != null) {
             val unbindUrl = pendingBoundUrl!!
             pendingBoundUrl = null
@@ -117,6 +150,29 @@ class VLCVideoSurface(
         }
     }
 
+    /**
+     * 挂起：保留绑定与网络会话，停止解码与绘制
+     */
+    private fun park() {
+        if (pendingBoundUrl == null || isParked) return
+        isParked = true
+        Log.i("VLCDecoder", "parkClient $id $videoSrc")
+        VLCRenderPool.setClientParked(this, true)
+    }
+
+    /**
+     * 从挂起中恢复，未挂起时按常规流程绑定
+     */
+    private fun resume() {
+        if (!isParked) {
+            bind()
+            return
+        }
+        isParked = false
+        Log.i("VLCDecoder", "unparkClient $id $videoSrc")
+        VLCRenderPool.setClientParked(this, false)
+    }
+
     override fun onSurfaceCreated(surface: Surface?) {
 //        Log.i("VLCDecoder", "onSurfaceCreated $id $videoSrc $videoType $videoData")
         if (surface == null) return
@@ -152,7 +208,9 @@ class VLCVideoSurface(
 
     override fun onRectChanged(rect: Rect?) {
         if (rect == null) return
+        val isMoved = this.rect?.left != rect.left || this.rect?.top != rect.top
         this.rect = rect
+        WidgetManager.updateRect(id, rect)
         val physicalW = dip2px(rect.width().toFloat())
         val physicalH = dip2px(rect.height().toFloat())
         if (physicalW != surfaceWidth || physicalH != surfaceHeight) {
@@ -160,18 +218,23 @@ class VLCVideoSurface(
             surfaceHeight = physicalH
             if (x5Surface?.isValid == true && pendingBoundUrl != null) {
                 VLCRenderPool.resizeClient(this)
+                VLCRenderPool.updateClientLayout(this)
             }
+        } else if (isMoved && pendingBoundUrl != null) {
+            VLCRenderPool.updateClientLayout(this)
         }
     }
 
     override fun onActive() {
 //        Log.i("VLCDecoder", "onActive $id")
-        bind()
+        WidgetManager.setWidgetVisible(id, true)
+        resume()
     }
 
     override fun onDeactive() {
 //        Log.i("VLCDecoder", "onDeactivate $id")
-        unbind()
+        WidgetManager.setWidgetVisible(id, false)
+        park()
     }
 
     override fun onDestroy() {
@@ -187,12 +250,30 @@ class VLCVideoSurface(
     override fun onSetAttribute(p0: String?, p1: String?): Boolean {
 //        Log.i("VLCDecoder", "onSetAttribute $p0 $p1 $id")
         _attributes[p0!!] = p1!!
-        if (p0 == "src") {
-            if (pendingBoundUrl != null && p1.isNotEmpty() && pendingBoundUrl != p1) {
+        if (p0.equals("scaleMode", ignoreCase = true)) {
+            if (pendingBoundUrl != null) {
+                VLCRenderPool.setClientScaleMode(this, videoScaleMode)
+            }
+        } else if (p0.equals("targetFps", ignoreCase = true)) {
+            if (pendingBoundUrl != null) {
+                VLCRenderPool.setClientTargetFps(this, videoTargetFps)
+            }
+        } else if (p0.equals("priority", ignoreCase = true)) {
+            if (pendingBoundUrl != null) {
+                VLCRenderPool.setClientPriority(this, videoPriority)
+            }
+        } else if (p0.equals("latency", ignoreCase = true)) {
+            pendingBoundUrl?.let { url -> videoLatency?.let { VLCRenderPool.setLatencyProfile(url, it) } }
+        } else if (p0 == "src") {
+            if (isParked && pendingBoundUrl != p1) {
+                // 挂起期间换源：旧流直接释放，新地址等恢复可见时再绑定
+                unbind()
+            } else if (pendingBoundUrl != null && p1.isNotEmpty() && pendingBoundUrl != p1) {
                 val oldUrl = pendingBoundUrl!!
                 pendingBoundUrl = p1
                 isActuallyPlaying = false
-                VLCRenderPool.switchClientUrl(oldUrl, p1, this)
+                videoLatency?.let { VLCRenderPool.setLatencyProfile(p1, it) }
+                VLCRenderPool.switchClientUrlAsync(oldUrl, p1, this).thenAccept { onBindResult(it) }
             } else if (p1.isNotEmpty() && pendingBoundUrl != p1) {
                 bind()
             } else if (p1.isEmpty() && pendingBoundUrl != null) {
@@ -204,7 +285,46 @@ class VLCVideoSurface(
 
     override fun onVisibilityChanged(v: Boolean) {
 //        Log.i("VLCDecoder", "onVisibilityChanged $v $id")
-        if (v) bind() else unbind()
+        WidgetManager.setWidgetVisible(id, v)
+        if (v) resume() else park()
+    }
+
+    /**
+     * 为布局事务登记本组件的目标状态，由事务统一提交，不再单独发起绑定/切流
+     * @param url 新布局中的视频流地址，空字符串表示不再播放
+     * @param widthDp 新布局中的宽度(dp)，为 null 时沿用当前尺寸
+     * @param heightDp 新布局中的高度(dp)，为 null 时沿用当前尺寸
+     * @return 画布尚未就绪时返回 null，该组件等待画布创建后按常规流程绑定
+     */
+    fun prepareLayout(url: String, widthDp: Float?, heightDp: Float?): LayoutEntry? {
+        _attributes["src"] = url
+        if (widthDp != null && heightDp != null) {
+            surfaceWidth = dip2px(widthDp)
+            surfaceHeight = dip2px(heightDp)
+        }
+        if (x5Surface?.isValid != true) return null
+        if (pendingBoundUrl != url) {
+            pendingBoundUrl = url.ifEmpty { null }
+            isActuallyPlaying = false
+            isParked = false
+        }
+        return LayoutEntry(this, url)
+    }
+
+    /**
+     * 绑定落空（超限拒绝或未能落地）时撤销防抖标记，下一次激活或可见性变化会重新发起绑定
+     */
+    fun onBindResult(result: BindResult) {
+        if (result.isAccepted) return
+        Handler(Looper.getMainLooper()).post {
+            if (result.url == pendingBoundUrl) {
+                Log.w("VLCDecoder", "bind ${result.status} $id ${result.url}")
+                pendingBoundUrl = null
+                isActuallyPlaying = false
+                isParked = false
+                VLCRenderPool.unbindClient(result.url, this)
+            }
+        }
     }
 
     override fun onFirstFrameRendered(url: String) {
@@ -216,6 +336,18 @@ class VLCVideoSurface(
         }
     }
 
+    override fun onAdmissionChanged(url: String, state: AdmissionState) {
+        if (state != AdmissionState.PREEMPTED) return
+        // 被抢占时调度池已完成解绑，只需撤销防抖标记，等待下一次可见性变化重新申请
+        Handler(Looper.getMainLooper()).post {
+            if (url == pendingBoundUrl) {
+                Log.w("VLCDecoder", "preempted $id $url")
+                pendingBoundUrl = null
+                isActuallyPlaying = false
+            }
+        }
+    }
+
     override fun onPlaybackFailed(url: String) {
         Handler(Looper.getMainLooper()).post {
             if (url == pendingBoundUrl) {
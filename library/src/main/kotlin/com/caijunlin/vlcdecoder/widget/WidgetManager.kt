@@ -1,9 +1,10 @@
 package com.caijunlin.vlcdecoder.widget
 
+import android.graphics.Rect
 import android.util.Log
 import com.tencent.smtt.sdk.WebView
 import org.json.JSONObject
-import java.util.concurrent.CopyOnWriteArrayList
+import java.util.WeakHashMap
 
 /**
  * VLCVideoWidget 统一管理工具类
@@ -11,7 +12,19 @@ import java.util.concurrent.CopyOnWriteArrayList
  */
 object WidgetManager {
 
-    private val widgetCache = CopyOnWriteArrayList<VLCVideoSurface>()
+    /** 组件的 id 索引与矩形空间索引，所有访问都在该锁内 */
+    private val index = WidgetSpatialIndex<VLCVideoSurface>({ it.tagName })
+
+    /**
+     * 页面视口的换算参数：CSS 视口宽高与测得时 WebView 的物理宽高，WebView 尺寸变化后作废
+     */
+    private class PageViewport(val physicalW: Int, val physicalH: Int, val cssW: Float, val cssH: Float)
+
+    /** 各 WebView 最近一次经 JS 测得的视口，在 index 锁内访问 */
+    private val viewports = WeakHashMap<WebView, PageViewport>()
+
+    /** 当前有浮层(弹窗、菜单等)盖在页面上的 WebView，浮层期间命中测试一律交给 DOM */
+    private val overlayPages = WeakHashMap<WebView, Boolean>()
 
     /**
      * 缓存 Widget
@@ -24,8 +37,10 @@ object WidgetManager {
             Log.e("VLCDecoder", "Cannot cache widget: id is empty!")
             return
         }
-        widgetCache.removeAll { it.id == id }
-        widgetCache.add(widget)
+        synchronized(index) {
+            index.put(id, widget)
+            widget.currentRect()?.let { index.updateRect(id, it.left, it.top, it.right, it.bottom) }
+        }
         Log.d("VLCDecoder", "Cached widget with id: $id")
     }
 
@@ -36,7 +51,7 @@ object WidgetManager {
      */
     fun removeWidget(id: String?) {
         if (id.isNullOrEmpty()) return
-        val removed = widgetCache.removeAll { it.id == id }
+        val removed = synchronized(index) { index.remove(id) }
         if (removed) {
             Log.d(
                 "VLCDecoder", "Removed widget with id: $id"
@@ -44,20 +59,63 @@ object WidgetManager {
         }
     }
 
+    /**
+     * 同步组件的布局矩形，由 onRectChanged 调用
+     * @param id 标签的唯一标识
+     * @param rect 布局矩形(CSS 像素，相对 WebView 视口)
+     */
+    fun updateRect(id: String, rect: Rect) {
+        if (id.isEmpty()) return
+        synchronized(index) { index.updateRect(id, rect.left, rect.top, rect.right, rect.bottom) }
+    }
+
+    /**
+     * 同步组件的可见性，隐藏或挂起的组件不参与原生命中测试
+     * @param id 标签的唯一标识
+     * @param visible 组件画面是否显示在页面上
+     */
+    fun setWidgetVisible(id: String, visible: Boolean) {
+        if (id.isEmpty()) return
+        synchronized(index) { index.setHidden(id, !visible) }
+    }
+
+    /**
+     * 标记页面上是否有浮层盖住组件。原生索引不知道非组件元素的层叠关系，浮层期间命中测试全部经 DOM 判定
+     * @param webView 承载的 X5 WebView
+     * @param active 是否存在浮层
+     */
+    fun setOverlayActive(webView: WebView, active: Boolean) {
+        synchronized(index) {
+            if (active) overlayPages[webView] = true else overlayPages.remove(webView)
+        }
+    }
+
+    /**
+     * 按标签 id 查找已缓存的 Widget
+     */
+    fun getWidget(id: String): VLCVideoSurface? = synchronized(index) { index[id]?.widget }
+
     /**
      * 清空所有缓存 (在 WebView 销毁或页面刷新时按需调用)
      */
     fun clearAll() {
-        widgetCache.clear()
+        synchronized(index) {
+            index.clear()
+            viewports.clear()
+            overlayPages.clear()
+        }
         Log.d("VLCDecoder", "Cleared all widget caches.")
     }
 
     /**
-     * 通过 x, y 获取最顶层的 VLCVideoWidget
+     * 通过 x, y 获取最顶层的 VLCVideoWidget。
+     * 优先由原生矩形索引就地作答，物理坐标按 JS 测得的 CSS 视口换算，与 DOM 查询的换算方式一致；
+     * 视口尚未测得或 WebView 尺寸已变、页面有浮层、索引里还有未上报矩形的组件，
+     * 或触点下有多个组件重叠需要 DOM 判断层叠顺序时，才退回 elementFromPoint 查询
      * @param webView 承载的 X5 WebView
      * @param x Android 触摸事件的物理 X 坐标 (绝对不能是除过 dpr 的值，传最原始的 MotionEvent.x)
      * @param y Android 触摸事件的物理 Y 坐标
-     * @param callback 异步回调
+     * @param callback 回调，原生命中时同步回调
      */
     fun getWidgetAt(
         webView: WebView,
@@ -65,6 +123,39 @@ object WidgetManager {
         x: Float,
         y: Float,
         callback: (VLCVideoSurface?) -> Unit
+    ) {
+        var isResolved = false
+        var hit: VLCVideoSurface? = null
+        synchronized(index) {
+            val viewport = viewports[webView]
+            if (viewport != null && viewport.physicalW == webView.width && viewport.physicalH == webView.height &&
+                overlayPages[webView] != true
+            ) {
+                val cssX = (x * viewport.cssW / viewport.physicalW).toInt()
+                val cssY = (y * viewport.cssH / viewport.physicalH).toInt()
+                val hits = index.hitTest(cssX, cssY, tagName)
+                if (hits.size == 1 || (hits.isEmpty() && index.unplacedCount == 0)) {
+                    isResolved = true
+                    hit = hits.firstOrNull()?.widget
+                }
+            }
+        }
+        if (isResolved) {
+            callback(hit)
+            return
+        }
+        queryWidgetAt(webView, tagName, x, y, callback)
+    }
+
+    /**
+     * 经 DOM elementFromPoint 判定触点下的组件，顺带记下 CSS 视口尺寸供之后的原生命中测试换算
+     */
+    private fun queryWidgetAt(
+        webView: WebView,
+        tagName: String,
+        x: Float,
+        y: Float,
+        callback: (VLCVideoSurface?) -> Unit
     ) {
         // 拿到 Android 端 WebView 的真实物理宽高
         val androidW = webView.width
@@ -92,26 +183,33 @@ object WidgetManager {
                 var cssY = aY * scaleY;
                 
                 // 使用转换后的 CSS 坐标去获取 DOM 元素
+                var hitId = null;
                 var element = document.elementFromPoint(cssX, cssY);
                 while(element && element !== document.body && element !== document.documentElement) {
                     if (element.tagName.toLowerCase() === '$tagName') {
-                        return element.id; 
+                        hitId = element.id;
+                        break;
                     }
                     element = element.parentElement;
                 }
-                return null;
+                return JSON.stringify({ id: hitId, webW: webW, webH: webH });
             })($x, $y, $androidW, $androidH);
         """.trimIndent()
-        Log.d("VLCDecoder", "JS Code: $jsCode")
         webView.evaluateJavascript(jsCode) { result ->
-            Log.d("VLCDecoder", "JS Result: $result")
-            if (!result.isNullOrEmpty() && result != "null") {
-                val videId = result.replace("\"", "")
-                val targetWidget = widgetCache.find { it.id == videId }
-                callback(targetWidget)
-            } else {
-                callback(null)
+            Log.d("VLCDecoder", "Hit test result: $result")
+            val hitId = try {
+                val hitStr = result.removeSurrounding("\"").replace("\\\"", "\"")
+                val hit = JSONObject(hitStr)
+                val webW = hit.optDouble("webW", 0.0).toFloat()
+                val webH = hit.optDouble("webH", 0.0).toFloat()
+                if (webW > 0f && webH > 0f) {
+                    synchronized(index) { viewports[webView] = PageViewport(androidW, androidH, webW, webH) }
+                }
+                if (hit.isNull("id")) null else hit.optString("id")
+            } catch (e: Exception) {
+                null
             }
+            callback(hitId?.takeIf { it.isNotEmpty() }?.let { getWidget(it) })
         }
     }
 
@@ -138,9 +236,7 @@ object WidgetManager {
                 }
             })();
         """.trimIndent()
-        Log.d("VLCDecoder", "JS Code: $jsCode")
         webView.evaluateJavascript(jsCode) { result ->
-            Log.d("VLCDecoder", "JS Result: $result")
             val isSuccess = result?.replace("\"", "")?.replace("'", "") == "true"
             onComplete?.invoke(isSuccess)
         }
@@ -171,12 +267,34 @@ object WidgetManager {
     }
 
     /**
-     * 通过 id 获取标签的真实宽高，并计算拖拽滑动的缩放比
+     * 通过 id 获取标签的真实宽高，并计算拖拽滑动的缩放比。
+     * 矩形取自原生索引；元素的 CSS 缩放只在首次查询或尺寸变化后经 JS 取一次并缓存，之后同步回调
      */
     fun getBoundingClientRect(
         webView: WebView,
         elementId: String,
         callback: (Int, Int, Float, Float) -> Unit
+    ) {
+        val cached = synchronized(index) {
+            val entry = index[elementId]
+            if (entry != null && entry.isPlaced && entry.webScaleX > 0f && entry.webScaleY > 0f) {
+                floatArrayOf(entry.width.toFloat(), entry.height.toFloat(), entry.webScaleX, entry.webScaleY)
+            } else {
+                null
+            }
+        }
+        if (cached != null) {
+            val density = webView.context.resources.displayMetrics.density
+            callback(cached[0].toInt(), cached[1].toInt(), density / cached[2], density / cached[3])
+            return
+        }
+        queryBoundingClientRect(webView, elementId, callback)
+    }
+
+    private fun queryBoundingClientRect(
+        webView: WebView,
+        elementId: String,
+        callback: (Int, Int, Float, Float) -> Unit
     ) {
         val jsCode = """
         (function() {
@@ -205,6 +323,14 @@ object WidgetManager {
 
                 val webScaleX = physicalWidth / offsetW
                 val webScaleY = physicalHeight / offsetH
+                if (webScaleX > 0f && webScaleY > 0f) {
+                    synchronized(index) {
+                        index[elementId]?.let { entry ->
+                            entry.webScaleX = webScaleX
+                            entry.webScaleY = webScaleY
+                        }
+                    }
+                }
 
                 val density = webView.context.resources.displayMetrics.density
                 val touchScaleX = if (webScaleX > 0) density / webScaleX else 1f
@@ -0,0 +1,177 @@
+package com.caijunlin.vlcdecoder.widget
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 组件矩形的原生空间索引。以 onRectChanged 上报的布局矩形(CSS 像素，相对 WebView 视口)
+ * 建立均匀网格，命中测试只扫描触点所在格子里的少数组件；同时按 id 哈希直查组件，
+ * 拖拽与投放不再需要经 evaluateJavascript 往返一次才能知道触点下是哪个组件。
+ * 隐藏或挂起的组件不参与命中测试。索引只做纯计算，不依赖 Android 类型，并发访问由调用方加锁。
+ * @param tagOf 取组件的标签名，命中测试据此过滤
+ * @param cellSize 网格边长(CSS 像素)
+ */
+internal class WidgetSpatialIndex<W>(
+    private val tagOf: (W) -> String,
+    private val cellSize: Int = 128
+) {
+
+    class Entry<W>(val widget: W, val order: Long) {
+        /** 是否已上报过布局矩形 */
+        var isPlaced = false
+            internal set
+        var left = 0
+            internal set
+        var top = 0
+            internal set
+        var right = 0
+            internal set
+        var bottom = 0
+            internal set
+
+        /** 组件被隐藏或挂起，画面不在页面上，不参与命中测试 */
+        var isHidden = false
+            internal set
+
+        /** 前端元素 CSS 缩放(getBoundingClientRect 与 offsetWidth 之比)的缓存，0 表示未知 */
+        var webScaleX = 0f
+        var webScaleY = 0f
+
+        /** 当前登记的网格键，矩形变化时据此从旧格子中摘除 */
+        internal var cells: LongArray = EMPTY_CELLS
+
+        val width: Int get() = right - left
+        val height: Int get() = bottom - top
+
+        /** 右下边界为开区间，与 android.graphics.Rect.contains 一致 */
+        fun contains(x: Int, y: Int): Boolean = isPlaced && left < right && top < bottom &&
+            x >= left && x < right && y >= top && y < bottom
+    }
+
+    private val byId = HashMap<String, Entry<W>>()
+    private val grid = HashMap<Long, ArrayList<Entry<W>>>()
+    private var nextOrder = 0L
+
+    /** 可见但尚未上报矩形的组件数，不为 0 时索引无法给出完整的命中结论 */
+    var unplacedCount = 0
+        private set
+
+    val size: Int get() = byId.size
+
+    operator fun get(id: String): Entry<W>? = byId[id]
+
+    /**
+     * 登记组件，同 id 的旧组件被替换
+     */
+    fun put(id: String, widget: W) {
+        remove(id)
+        byId[id] = Entry(widget, nextOrder++)
+        unplacedCount++
+    }
+
+    fun remove(id: String): Boolean {
+        val entry = byId.remove(id) ?: return false
+        unlink(entry)
+        if (!entry.isPlaced && !entry.isHidden) unplacedCount--
+        return true
+    }
+
+    /**
+     * 更新组件的布局矩形，尺寸变化时丢弃缓存的 CSS 缩放
+     */
+    fun updateRect(id: String, left: Int, top: Int, right: Int, bottom: Int) {
+        val entry = byId[id] ?: return
+        if (entry.isPlaced) {
+            if (entry.left == left && entry.top == top && entry.right == right && entry.bottom == bottom) return
+            if (entry.width != right - left || entry.height != bottom - top) {
+                entry.webScaleX = 0f
+                entry.webScaleY = 0f
+            }
+        } else if (!entry.isHidden) {
+            unplacedCount--
+        }
+        unlink(entry)
+        entry.isPlaced = true
+        entry.left = left
+        entry.top = top
+        entry.right = right
+        entry.bottom = bottom
+        if (!entry.isHidden) link(entry)
+    }
+
+    /**
+     * 隐藏或恢复组件：隐藏期间从网格中摘除，也不计入未上报矩形的组件数
+     */
+    fun setHidden(id: String, hidden: Boolean) {
+        val entry = byId[id] ?: return
+        if (entry.isHidden == hidden) return
+        entry.isHidden = hidden
+        if (hidden) {
+            unlink(entry)
+            if (!entry.isPlaced) unplacedCount--
+        } else if (entry.isPlaced) {
+            link(entry)
+        } else {
+            unplacedCount++
+        }
+    }
+
+    /**
+     * 查询包含触点的全部可见组件，结果按登记先后倒序排列(后创建的 DOM 元素通常位于上层)
+     * @param cssX 触点 X(CSS 像素)
+     * @param cssY 触点 Y(CSS 像素)
+     * @param tagName 只匹配该标签名的组件
+     */
+    fun hitTest(cssX: Int, cssY: Int, tagName: String): List<Entry<W>> {
+        val bucket = grid[keyOf(Math.floorDiv(cssX, cellSize), Math.floorDiv(cssY, cellSize))] ?: return emptyList()
+        var hits: ArrayList<Entry<W>>? = null
+        for (i in 0 until bucket.size) {
+            val entry = bucket[i]
+            if (!entry.contains(cssX, cssY) || tagOf(entry.widget) != tagName) continue
+            if (hits == null) hits = ArrayList(2)
+            hits.add(entry)
+        }
+        if (hits == null) return emptyList()
+        if (hits.size > 1) hits.sortByDescending { it.order }
+        return hits
+    }
+
+    fun clear() {
+        byId.clear()
+        grid.clear()
+        unplacedCount = 0
+    }
+
+    private fun link(entry: Entry<W>) {
+        if (entry.left >= entry.right || entry.top >= entry.bottom) return
+        val left = Math.floorDiv(entry.left, cellSize)
+        val top = Math.floorDiv(entry.top, cellSize)
+        // 右下边界是开区间，减一后再取格，避免恰好落在格线上的矩形多占一列
+        val right = Math.floorDiv(entry.right - 1, cellSize)
+        val bottom = Math.floorDiv(entry.bottom - 1, cellSize)
+        val cells = LongArray((right - left + 1) * (bottom - top + 1))
+        var index = 0
+        for (cy in top..bottom) {
+            for (cx in left..right) {
+                val key = keyOf(cx, cy)
+                grid.getOrPut(key) { ArrayList(4) }.add(entry)
+                cells[index++] = key
+            }
+        }
+        entry.cells = cells
+    }
+
+    private fun unlink(entry: Entry<W>) {
+        entry.cells.forEach { key ->
+            val bucket = grid[key] ?: return@forEach
+            bucket.remove(entry)
+            if (bucket.isEmpty()) grid.remove(key)
+        }
+        entry.cells = EMPTY_CELLS
+    }
+
+    private fun keyOf(cx: Int, cy: Int): Long = (cx.toLong() shl 32) or (cy.toLong() and 0xFFFFFFFFL)
+
+    private companion object {
+        val EMPTY_CELLS = LongArray(0)
+    }
+}
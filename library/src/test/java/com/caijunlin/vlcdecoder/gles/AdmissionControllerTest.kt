@@ -0,0 +1,182 @@
+package com.caijunlin.vlcdecoder.gles
+
+import android.view.Surface
+import org.junit.After
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNull
+import org.junit.Assert.assertTrue
+import org.junit.Before
+import org.junit.Test
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 准入控制的决策顺序：回收闲置流 → 降档低优先级 → 抢占低优先级 → 降档自身 → 拒绝。
+ * 估算帧率固定为 1，预算直接以档位像素数表达。
+ */
+class AdmissionControllerTest {
+
+    private val controller = AdmissionController()
+    private var savedGpuBudget = 0L
+
+    @Before
+    fun setUp() {
+        savedGpuBudget = GpuMemoryBudget.budgetBytes
+        GpuMemoryBudget.budgetBytes = Long.MAX_VALUE / 2
+        controller.assumedFps = 1f
+    }
+
+    @After
+    fun tearDown() {
+        GpuMemoryBudget.addLive(-GpuMemoryBudget.usedBytes)
+        GpuMemoryBudget.budgetBytes = savedGpuBudget
+    }
+
+    @Test
+    fun admitsWithinBudget() {
+        controller.budgetPixelsPerSecond = cost(ResolutionTier.P720) * 2
+
+        assertEquals(AdmissionState.ADMITTED, controller.admit("a", client("a"), ResolutionTier.P720).state)
+        assertEquals(AdmissionState.ADMITTED, controller.admit("b", client("b"), ResolutionTier.P720).state)
+        assertEquals(cost(ResolutionTier.P720) * 2, controller.usedPixelsPerSecond())
+        assertEquals(2, controller.admittedStreams())
+    }
+
+    @Test
+    fun downgradesLowerPriorityFirst() {
+        controller.budgetPixelsPerSecond = cost(ResolutionTier.P720) + cost(ResolutionTier.P360)
+        controller.admit("thumb", client("thumb", StreamPriority.THUMBNAIL), ResolutionTier.P720)
+
+        val decision = controller.admit("main", client("main"), ResolutionTier.P720)
+
+        assertEquals(AdmissionState.ADMITTED, decision.state)
+        assertEquals(listOf(Pair("thumb", ResolutionTier.P360)), decision.tierCaps)
+        assertTrue(decision.preempted.isEmpty())
+        assertEquals(ResolutionTier.P360, controller.tierCapOf("thumb"))
+        assertNull(controller.tierCapOf("main"))
+    }
+
+    @Test
+    fun preemptsWhenDowngradeIsNotEnough() {
+        controller.budgetPixelsPerSecond = cost(ResolutionTier.P720)
+        val thumb = client("thumb", StreamPriority.THUMBNAIL)
+        controller.admit("thumb", thumb, ResolutionTier.P720)
+
+        val decision = controller.admit("main", client("main"), ResolutionTier.P720)
+
+        assertEquals(AdmissionState.ADMITTED, decision.state)
+        assertEquals(listOf(Pair("thumb", listOf<IVideoRenderClient>(thumb))), decision.preempted)
+        // 被抢占的流不再单独下发降档
+        assertTrue(decision.tierCaps.isEmpty())
+        assertEquals(1, controller.admittedStreams())
+        assertTrue(controller.clientsOf("thumb").isEmpty())
+    }
+
+    @Test
+    fun downgradesSelfWithoutLowerPriorityVictims() {
+        controller.budgetPixelsPerSecond = cost(ResolutionTier.P720) + cost(ResolutionTier.P360)
+        controller.admit("a", client("a"), ResolutionTier.P720)
+
+        val decision = controller.admit("b", client("b"), ResolutionTier.P720)
+
+        assertEquals(AdmissionState.DOWNGRADED, decision.state)
+        assertEquals(listOf(Pair("b", ResolutionTier.P360)), decision.tierCaps)
+        assertNull(controller.tierCapOf("a"))
+        assertEquals(ResolutionTier.P360, controller.tierCapOf("b"))
+    }
+
+    @Test
+    fun rejectsWhenNothingCanBeFreed() {
+        controller.budgetPixelsPerSecond = cost(ResolutionTier.P720)
+        controller.admit("a", client("a", StreamPriority.FOCUSED), ResolutionTier.P720)
+
+        val decision = controller.admit("b", client("b"), ResolutionTier.P720)
+
+        assertEquals(AdmissionState.REJECTED, decision.state)
+        assertEquals(1, controller.admittedStreams())
+        assertEquals(cost(ResolutionTier.P720), controller.usedPixelsPerSecond())
+    }
+
+    @Test
+    fun rejectsBeyondMaxStreams() {
+        controller.maxStreams = 1
+        controller.admit("a", client("a"), ResolutionTier.P360)
+
+        assertEquals(AdmissionState.REJECTED, controller.admit("b", client("b"), ResolutionTier.P360).state)
+    }
+
+    @Test
+    fun releaseRestoresDowngradedStreams() {
+        controller.budgetPixelsPerSecond = cost(ResolutionTier.P720) + cost(ResolutionTier.P360)
+        controller.admit("thumb", client("thumb", StreamPriority.THUMBNAIL), ResolutionTier.P720)
+        val main = client("main")
+        controller.admit("main", main, ResolutionTier.P720)
+
+        assertEquals(listOf("thumb"), controller.release("main", main))
+        assertNull(controller.tierCapOf("thumb"))
+        assertEquals(cost(ResolutionTier.P720), controller.usedPixelsPerSecond())
+    }
+
+    @Test
+    fun reclaimsIdleStreamsBeforeTouchingLiveOnes() {
+        controller.budgetPixelsPerSecond = cost(ResolutionTier.P720) * 2
+        val idle = client("idle", StreamPriority.FOCUSED)
+        controller.admit("idle", idle, ResolutionTier.P720)
+        controller.admit("live", client("live", StreamPriority.THUMBNAIL), ResolutionTier.P720)
+        controller.release("idle", idle, retainIdle = true)
+        assertEquals(2, controller.admittedStreams())
+
+        val decision = controller.admit("new", client("new", StreamPriority.THUMBNAIL), ResolutionTier.P720)
+
+        assertEquals(AdmissionState.ADMITTED, decision.state)
+        assertEquals(listOf("idle"), decision.reclaimed)
+        assertTrue(decision.tierCaps.isEmpty())
+        assertTrue(decision.preempted.isEmpty())
+        assertNull(controller.tierCapOf("live"))
+    }
+
+    @Test
+    fun pausedIdleStreamsCostNoDecodeBudget() {
+        controller.idleKeepsDecoding = false
+        controller.budgetPixelsPerSecond = cost(ResolutionTier.P720)
+        val idle = client("idle")
+        controller.admit("idle", idle, ResolutionTier.P720)
+        controller.release("idle", idle, retainIdle = true)
+
+        val decision = controller.admit("new", client("new"), ResolutionTier.P720)
+
+        assertEquals(AdmissionState.ADMITTED, decision.state)
+        assertTrue(decision.reclaimed.isEmpty())
+        assertEquals(2, controller.admittedStreams())
+    }
+
+    @Test
+    fun gpuBudgetCountsLiveBuffers() {
+        GpuMemoryBudget.budgetBytes = bytes(ResolutionTier.P720) + bytes(ResolutionTier.P360)
+        val thumb = client("thumb", StreamPriority.THUMBNAIL)
+        controller.admit("thumb", thumb, ResolutionTier.P720)
+        // 模拟节点为该流分配了 FBO
+        GpuMemoryBudget.addLive(bytes(ResolutionTier.P720))
+
+        val decision = controller.admit("main", client("main"), ResolutionTier.P720)
+
+        assertEquals(AdmissionState.ADMITTED, decision.state)
+        assertEquals(listOf(Pair("thumb", ResolutionTier.P360)), decision.tierCaps)
+        assertTrue(decision.preempted.isEmpty())
+    }
+
+    private fun cost(tier: ResolutionTier): Long = tier.width.toLong() * tier.height
+
+    private fun bytes(tier: ResolutionTier): Long = GpuMemoryBudget.bytesOf(tier.width, tier.height)
+
+    private fun client(id: String, priority: StreamPriority = StreamPriority.VISIBLE): IVideoRenderClient =
+        object : IVideoRenderClient {
+            override fun getElementId(): String = id
+            override fun getTargetSurface(): Surface? = null
+            override fun getTargetWidth(): Int = 0
+            override fun getTargetHeight(): Int = 0
+            override fun getPriority(): StreamPriority = priority
+            override fun onFirstFrameRendered(url: String) {}
+            override fun onPlaybackFailed(url: String) {}
+        }
+}
@@ -0,0 +1,203 @@
+package com.caijunlin.vlcdecoder.gles
+
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertTrue
+import org.junit.Test
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 帧节奏调度：按 PTS 相位抽帧、拥塞降频与恢复、节点压力以及轮询间隔
+ */
+class FramePacerTest {
+
+    private class Window(
+        override var targetFps: Float = 0f,
+        override var isPrimary: Boolean = true,
+        override var isParked: Boolean = false
+    ) : PacedWindow {
+        override var nextPresentPtsNs = 0L
+        override var congestionLevel = 0
+        override var throttleTick = 0
+        override var cleanSwaps = 0
+    }
+
+    private class Stream(
+        override var sourceFps: Float,
+        override var targetFps: Float = 0f
+    ) : PacedStream {
+        override val displayWindows = ArrayList<Window>()
+    }
+
+    private val pacer = FramePacer()
+
+    @Test
+    fun effectiveFpsTakesSmallestPositiveLimit() {
+        val stream = Stream(sourceFps = 50f)
+
+        assertEquals(FramePacer.DEFAULT_MAX_FPS, pacer.effectiveFps(Window(), stream), 0f)
+        assertEquals(15f, pacer.effectiveFps(Window(targetFps = 15f), stream), 0f)
+        stream.targetFps = 10f
+        assertEquals(10f, pacer.effectiveFps(Window(targetFps = 15f), stream), 0f)
+        pacer.maxFps = 0f
+        stream.targetFps = 0f
+        assertEquals(0f, pacer.effectiveFps(Window(), stream), 0f)
+    }
+
+    @Test
+    fun presentsEveryFrameWhenSourceIsNotFaster() {
+        val window = Window()
+        val stream = Stream(sourceFps = 25f)
+
+        val presented = presentRun(window, stream, frames = 50)
+
+        assertEquals(50, presented.count { it })
+        assertEquals(0L, window.nextPresentPtsNs)
+    }
+
+    @Test
+    fun halvesFiftyFpsSourceEvenly() {
+        val window = Window(targetFps = 25f)
+        val presented = presentRun(window, Stream(sourceFps = 50f), frames = 50)
+
+        assertEquals(25, presented.count { it })
+        presented.forEachIndexed { index, shown -> assertEquals("frame $index", index % 2 == 0, shown) }
+    }
+
+    @Test
+    fun thirtyToTwentyDropsOneFrameInThree() {
+        val presented = presentRun(Window(targetFps = 20f), Stream(sourceFps = 30f), frames = 90)
+
+        assertEquals(60, presented.count { it })
+        // 抽帧均匀，不会连续丢两帧
+        for (i in 1 until presented.size) assertTrue("frame $i", presented[i] || presented[i - 1])
+    }
+
+    @Test
+    fun realignsAfterTimestampJump() {
+        val window = Window(targetFps = 10f)
+        val stream = Stream(sourceFps = 50f)
+        assertTrue(pacer.shouldPresent(window, stream, SECOND_NS))
+        assertFalse(pacer.shouldPresent(window, stream, SECOND_NS + 20_000_000L))
+
+        val jumped = 60 * SECOND_NS
+        assertTrue(pacer.shouldPresent(window, stream, jumped))
+        assertEquals(jumped + 100_000_000L, window.nextPresentPtsNs)
+    }
+
+    @Test
+    fun throttleSkipsByCongestionLevel() {
+        val window = Window()
+        assertEquals(8, (0 until 8).count { pacer.passesThrottle(window) })
+
+        window.congestionLevel = 2
+        assertEquals(2, (0 until 8).count { pacer.passesThrottle(window) })
+    }
+
+    @Test
+    fun nodePressureOnlyThrottlesSecondaryWindows() {
+        pacer.updatePressure(costMs = 50f, intervalMs = 40L)
+        assertEquals(1, pacer.nodePressure)
+
+        val primary = Window()
+        val secondary = Window(isPrimary = false)
+        assertEquals(8, (0 until 8).count { pacer.passesThrottle(primary) })
+        assertEquals(4, (0 until 8).count { pacer.passesThrottle(secondary) })
+    }
+
+    @Test
+    fun pressureHoldsBetweenAdjustments() {
+        pacer.updatePressure(costMs = 50f, intervalMs = 40L)
+        repeat(PRESSURE_HOLD_TICKS) { pacer.updatePressure(costMs = 50f, intervalMs = 40L) }
+        assertEquals(1, pacer.nodePressure)
+
+        pacer.updatePressure(costMs = 50f, intervalMs = 40L)
+        assertEquals(2, pacer.nodePressure)
+
+        repeat(PRESSURE_HOLD_TICKS) { pacer.updatePressure(costMs = 1f, intervalMs = 40L) }
+        pacer.updatePressure(costMs = 1f, intervalMs = 40L)
+        assertEquals(1, pacer.nodePressure)
+    }
+
+    @Test
+    fun congestedPrimarySwapThrottlesLeastThrottledSecondary() {
+        val stream = Stream(sourceFps = 25f)
+        val primary = Window()
+        val first = Window(isPrimary = false).apply { congestionLevel = 1 }
+        val second = Window(isPrimary = false)
+        val parked = Window(isPrimary = false, isParked = true)
+        stream.displayWindows.addAll(listOf(primary, first, second, parked))
+
+        pacer.onSwapped(primary, stream, CONGESTED_MS)
+        assertEquals(0, primary.congestionLevel)
+        assertEquals(1, first.congestionLevel)
+        assertEquals(1, second.congestionLevel)
+        assertEquals(0, parked.congestionLevel)
+
+        repeat(4) { pacer.onSwapped(primary, stream, CONGESTED_MS) }
+        assertEquals(MAX_CONGESTION_LEVEL, first.congestionLevel)
+        assertEquals(MAX_CONGESTION_LEVEL, second.congestionLevel)
+        assertEquals(0, primary.congestionLevel)
+
+        // 副窗口都已降到底，主窗口才降自己
+        pacer.onSwapped(primary, stream, CONGESTED_MS)
+        assertEquals(1, primary.congestionLevel)
+    }
+
+    @Test
+    fun congestedSecondaryThrottlesItselfAndRecovers() {
+        val stream = Stream(sourceFps = 25f)
+        val primary = Window()
+        val secondary = Window(isPrimary = false)
+        stream.displayWindows.addAll(listOf(primary, secondary))
+
+        repeat(5) { pacer.onSwapped(secondary, stream, CONGESTED_MS) }
+        assertEquals(MAX_CONGESTION_LEVEL, secondary.congestionLevel)
+        assertEquals(0, primary.congestionLevel)
+
+        repeat(RECOVER_SWAPS - 1) { pacer.onSwapped(secondary, stream, 1f) }
+        assertEquals(MAX_CONGESTION_LEVEL, secondary.congestionLevel)
+        pacer.onSwapped(secondary, stream, 1f)
+        assertEquals(MAX_CONGESTION_LEVEL - 1, secondary.congestionLevel)
+
+        // 中途再次超标会清零恢复计数
+        repeat(RECOVER_SWAPS - 1) { pacer.onSwapped(secondary, stream, 1f) }
+        pacer.onSwapped(secondary, stream, CONGESTED_MS)
+        pacer.onSwapped(secondary, stream, 1f)
+        assertEquals(MAX_CONGESTION_LEVEL, secondary.congestionLevel)
+    }
+
+    @Test
+    fun pacingFollowsFastestStreamWithWindows() {
+        assertEquals(40L, pacer.pacingIntervalMs(emptyList()))
+
+        val watched = Stream(sourceFps = 25f).apply { displayWindows.add(Window()) }
+        val unwatched = Stream(sourceFps = 60f)
+        assertEquals(32L, pacer.pacingIntervalMs(listOf(watched, unwatched)))
+
+        val fast = Stream(sourceFps = 200f).apply { displayWindows.add(Window()) }
+        assertEquals(8L, pacer.pacingIntervalMs(listOf(watched, fast)))
+
+        assertEquals(22L, pacer.nextPollDelayMs(listOf(watched), costMs = 10L))
+        assertEquals(5L, pacer.nextPollDelayMs(listOf(watched), costMs = 40L))
+    }
+
+    /**
+     * 以源帧率的理想时间戳连续喂帧，返回每一帧是否上屏
+     */
+    private fun presentRun(window: Window, stream: Stream, frames: Int): List<Boolean> {
+        val fps = stream.sourceFps.toLong()
+        return (1..frames).map { k -> pacer.shouldPresent(window, stream, k * SECOND_NS / fps) }
+    }
+
+    private companion object {
+        const val SECOND_NS = 1_000_000_000L
+        const val CONGESTED_MS = 40f
+
+        /** 与 FramePacer 内部常量一致 */
+        const val MAX_CONGESTION_LEVEL = 3
+        const val RECOVER_SWAPS = 30
+        const val PRESSURE_HOLD_TICKS = 15
+    }
+}
@@ -0,0 +1,186 @@
+package com.caijunlin.vlcdecoder.gles
+
+import android.os.Handler
+import android.os.Looper
+import org.junit.After
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertTrue
+import org.junit.Before
+import org.junit.Test
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 重连退避间隔与按主机熔断的放行规则。熔断器的时钟替换为手动推进，
+ * 唤醒排期替换为记录，校验放行结果与等待者是否被排期唤醒。
+ */
+class ReconnectPolicyTest {
+
+    private val policy = ReconnectPolicy(breakerThreshold = 3, breakerCooldownMs = 10_000L, maxDelayMs = 30_000L)
+    private val handler = Handler(Looper.getMainLooper())
+    private val wakeUp = Runnable { }
+    private var now = 1_000L
+
+    /** 最近一次排期的唤醒任务与延时，同一任务只保留最后一次 */
+    private val wakeUps = LinkedHashMap<Runnable, Long>()
+    private val wakeUpB = Runnable { }
+    private val wakeUpC = Runnable { }
+
+    @Before
+    fun setUp() {
+        HostCircuitBreaker.clear()
+        HostCircuitBreaker.clock = { now }
+        HostCircuitBreaker.scheduler = { _, task, delayMs -> wakeUps[task] = delayMs }
+    }
+
+    @After
+    fun tearDown() {
+        HostCircuitBreaker.clear()
+    }
+
+    @Test
+    fun delayGrowsExponentiallyUpToCap() {
+        val exact = ReconnectPolicy(baseDelayMs = 1000L, maxDelayMs = 5000L, jitter = 0f)
+
+        assertEquals(1000L, exact.delayFor(0))
+        assertEquals(2000L, exact.delayFor(1))
+        assertEquals(4000L, exact.delayFor(2))
+        assertEquals(5000L, exact.delayFor(3))
+        assertEquals(5000L, exact.delayFor(30))
+        assertEquals(1000L, exact.delayFor(-1))
+    }
+
+    @Test
+    fun jitterStaysWithinSpread() {
+        repeat(200) {
+            val first = policy.delayFor(0)
+            assertTrue("delay $first", first in 700L..1300L)
+            val capped = policy.delayFor(20)
+            assertTrue("delay $capped", capped in 21_000L..39_000L)
+        }
+    }
+
+    @Test
+    fun staysClosedBelowThreshold() {
+        repeat(policy.breakerThreshold - 1) { HostCircuitBreaker.onFailure(HOST, "a", policy) }
+
+        assertTrue(HostCircuitBreaker.tryAcquire(HOST, "b", handler, wakeUp))
+    }
+
+    @Test
+    fun opensAtThresholdAndAdmitsSingleProbe() {
+        repeat(policy.breakerThreshold) { HostCircuitBreaker.onFailure(HOST, "a", policy) }
+
+        assertFalse(HostCircuitBreaker.tryAcquire(HOST, "a", handler, wakeUp))
+        assertFalse(HostCircuitBreaker.tryAcquire(HOST, "b", handler, wakeUp))
+        // 其他主机不受影响
+        assertTrue(HostCircuitBreaker.tryAcquire("10.0.0.2", "c", handler, wakeUp))
+
+        now += policy.breakerCooldownMs
+        assertTrue(HostCircuitBreaker.tryAcquire(HOST, "b", handler, wakeUp))
+        assertFalse(HostCircuitBreaker.tryAcquire(HOST, "a", handler, wakeUp))
+        assertTrue(HostCircuitBreaker.tryAcquire(HOST, "b", handler, wakeUp))
+    }
+
+    @Test
+    fun probeFailureDoublesCooldown() {
+        repeat(policy.breakerThreshold) { HostCircuitBreaker.onFailure(HOST, "a", policy) }
+        now += policy.breakerCooldownMs
+        assertTrue(HostCircuitBreaker.tryAcquire(HOST, "a", handler, wakeUp))
+
+        HostCircuitBreaker.onFailure(HOST, "a", policy)
+
+        now += policy.breakerCooldownMs
+        assertFalse(HostCircuitBreaker.tryAcquire(HOST, "b", handler, wakeUp))
+        now += policy.breakerCooldownMs
+        assertTrue(HostCircuitBreaker.tryAcquire(HOST, "b", handler, wakeUp))
+    }
+
+    @Test
+    fun successClosesCircuit() {
+        repeat(policy.breakerThreshold) { HostCircuitBreaker.onFailure(HOST, "a", policy) }
+        assertFalse(HostCircuitBreaker.tryAcquire(HOST, "b", handler, wakeUp))
+        now += policy.breakerCooldownMs
+        assertTrue(HostCircuitBreaker.tryAcquire(HOST, "a", handler, wakeUp))
+
+        HostCircuitBreaker.onSuccess(HOST, policy)
+
+        assertTrue(HostCircuitBreaker.tryAcquire(HOST, "b", handler, wakeUp))
+        assertTrue(HostCircuitBreaker.tryAcquire(HOST, "c", handler, wakeUp))
+    }
+
+    @Test
+    fun anotherStreamTakesOverAbandonedProbe() {
+        repeat(policy.breakerThreshold) { HostCircuitBreaker.onFailure(HOST, "a", policy) }
+        now += policy.breakerCooldownMs
+        assertTrue(HostCircuitBreaker.tryAcquire(HOST, "a", handler, wakeUp))
+        assertFalse(HostCircuitBreaker.tryAcquire(HOST, "b", handler, wakeUp))
+
+        HostCircuitBreaker.forget(HOST, "a")
+
+        assertTrue(HostCircuitBreaker.tryAcquire(HOST, "b", handler, wakeUp))
+    }
+
+    @Test
+    fun stalledProbeExpires() {
+        repeat(policy.breakerThreshold) { HostCircuitBreaker.onFailure(HOST, "a", policy) }
+        now += policy.breakerCooldownMs
+        assertTrue(HostCircuitBreaker.tryAcquire(HOST, "a", handler, wakeUp))
+        assertFalse(HostCircuitBreaker.tryAcquire(HOST, "b", handler, wakeUp))
+
+        now += PROBE_TIMEOUT_MS + 1
+        assertTrue(HostCircuitBreaker.tryAcquire(HOST, "b", handler, wakeUp))
+    }
+
+    @Test
+    fun waiterDuringProbeIsWokenAtProbeTimeout() {
+        repeat(policy.breakerThreshold) { HostCircuitBreaker.onFailure(HOST, "a", policy) }
+        now += policy.breakerCooldownMs
+        assertTrue(HostCircuitBreaker.tryAcquire(HOST, "a", handler, wakeUp))
+
+        assertFalse(HostCircuitBreaker.tryAcquire(HOST, "b", handler, wakeUpB))
+
+        assertEquals(PROBE_TIMEOUT_MS + 1, wakeUps[wakeUpB])
+    }
+
+    @Test
+    fun failedProbeThatGivesUpStillWakesWaiter() {
+        repeat(policy.breakerThreshold) { HostCircuitBreaker.onFailure(HOST, "a", policy) }
+        now += policy.breakerCooldownMs
+        assertTrue(HostCircuitBreaker.tryAcquire(HOST, "a", handler, wakeUp))
+        assertFalse(HostCircuitBreaker.tryAcquire(HOST, "b", handler, wakeUpB))
+        wakeUps.clear()
+
+        // 探测失败，随后探测流重试耗尽离场
+        HostCircuitBreaker.onFailure(HOST, "a", policy)
+        HostCircuitBreaker.forget(HOST, "a")
+
+        val cooldownMs = policy.breakerCooldownMs * 2
+        assertEquals(mapOf(wakeUpB to cooldownMs), wakeUps)
+        now += cooldownMs
+        assertTrue(HostCircuitBreaker.tryAcquire(HOST, "b", handler, wakeUpB))
+    }
+
+    @Test
+    fun departingWakerHandsOffToNextWaiter() {
+        repeat(policy.breakerThreshold) { HostCircuitBreaker.onFailure(HOST, "a", policy) }
+        now += policy.breakerCooldownMs
+        assertTrue(HostCircuitBreaker.tryAcquire(HOST, "a", handler, wakeUp))
+        assertFalse(HostCircuitBreaker.tryAcquire(HOST, "b", handler, wakeUpB))
+        assertFalse(HostCircuitBreaker.tryAcquire(HOST, "c", handler, wakeUpC))
+        HostCircuitBreaker.onFailure(HOST, "a", policy)
+        wakeUps.clear()
+
+        HostCircuitBreaker.forget(HOST, "b")
+
+        assertEquals(mapOf(wakeUpC to policy.breakerCooldownMs * 2), wakeUps)
+    }
+
+    private companion object {
+        const val HOST = "10.0.0.1:554"
+
+        /** 与 HostCircuitBreaker 内部的探测超时一致 */
+        const val PROBE_TIMEOUT_MS = 20_000L
+    }
+}
@@ -0,0 +1,164 @@
+package com.caijunlin.vlcdecoder.widget
+
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertFalse
+import org.junit.Assert.assertNull
+import org.junit.Assert.assertTrue
+import org.junit.Test
+
+/**
+ * @author caijunlin
+ * @date   2026/3/10
+ * @description 组件空间索引的登记、矩形更新、隐藏与命中测试
+ */
+class WidgetSpatialIndexTest {
+
+    private class Widget(val id: String, val tag: String = TAG)
+
+    private val index = WidgetSpatialIndex<Widget>({ it.tag }, cellSize = 100)
+
+    @Test
+    fun hitTestMatchesContainedPointOnly() {
+        put("a", 10, 10, 60, 40)
+
+        assertEquals(listOf("a"), hitIds(10, 10))
+        assertEquals(listOf("a"), hitIds(59, 39))
+        // 右下边界为开区间
+        assertTrue(hitIds(60, 20).isEmpty())
+        assertTrue(hitIds(20, 40).isEmpty())
+        assertTrue(hitIds(9, 20).isEmpty())
+    }
+
+    @Test
+    fun overlappingWidgetsReturnNewestFirst() {
+        put("bottom", 0, 0, 300, 300)
+        put("middle", 50, 50, 250, 250)
+        put("top", 100, 100, 200, 200)
+
+        assertEquals(listOf("top", "middle", "bottom"), hitIds(150, 150))
+        assertEquals(listOf("middle", "bottom"), hitIds(60, 60))
+    }
+
+    @Test
+    fun rectSpanningCellsIsFoundInEveryCell() {
+        put("wide", 50, 50, 350, 250)
+
+        listOf(Pair(60, 60), Pair(150, 150), Pair(349, 249), Pair(250, 100)).forEach { (x, y) ->
+            assertEquals("($x, $y)", listOf("wide"), hitIds(x, y))
+        }
+    }
+
+    @Test
+    fun negativeCoordinatesAreIndexed() {
+        put("offscreen", -150, -80, 20, 20)
+
+        assertEquals(listOf("offscreen"), hitIds(-120, -10))
+        assertEquals(listOf("offscreen"), hitIds(0, 0))
+    }
+
+    @Test
+    fun filtersByTagName() {
+        index.put("a", Widget("a", tag = "other-widget"))
+        index.updateRect("a", 0, 0, 100, 100)
+
+        assertTrue(hitIds(50, 50).isEmpty())
+        assertEquals("a", index.hitTest(50, 50, "other-widget").single().widget.id)
+    }
+
+    @Test
+    fun updateRectMovesWidgetBetweenCells() {
+        put("a", 0, 0, 50, 50)
+        index.updateRect("a", 400, 400, 450, 450)
+
+        assertTrue(hitIds(10, 10).isEmpty())
+        assertEquals(listOf("a"), hitIds(420, 420))
+    }
+
+    @Test
+    fun resizeDropsCachedWebScale() {
+        put("a", 0, 0, 100, 100)
+        val entry = index["a"]!!
+        entry.webScaleX = 2f
+        entry.webScaleY = 2f
+
+        index.updateRect("a", 10, 10, 110, 110)
+        assertEquals(2f, entry.webScaleX, 0f)
+
+        index.updateRect("a", 10, 10, 60, 60)
+        assertEquals(0f, entry.webScaleX, 0f)
+        assertEquals(0f, entry.webScaleY, 0f)
+    }
+
+    @Test
+    fun emptyRectIsNeverHit() {
+        put("a", 50, 50, 50, 80)
+
+        assertTrue(hitIds(50, 60).isEmpty())
+        assertEquals(0, index.unplacedCount)
+    }
+
+    @Test
+    fun hiddenWidgetsAreSkipped() {
+        put("a", 0, 0, 100, 100)
+        put("b", 0, 0, 100, 100)
+
+        index.setHidden("b", true)
+        assertEquals(listOf("a"), hitIds(50, 50))
+
+        // 隐藏期间的矩形更新在恢复后生效
+        index.updateRect("b", 200, 200, 300, 300)
+        assertTrue(hitIds(250, 250).isEmpty())
+        index.setHidden("b", false)
+        assertEquals(listOf("b"), hitIds(250, 250))
+        assertEquals(listOf("a"), hitIds(50, 50))
+    }
+
+    @Test
+    fun unplacedCountTracksVisibleWidgetsWithoutRect() {
+        index.put("a", Widget("a"))
+        index.put("b", Widget("b"))
+        assertEquals(2, index.unplacedCount)
+
+        index.updateRect("a", 0, 0, 10, 10)
+        assertEquals(1, index.unplacedCount)
+
+        index.setHidden("b", true)
+        assertEquals(0, index.unplacedCount)
+        index.setHidden("b", false)
+        assertEquals(1, index.unplacedCount)
+
+        index.remove("b")
+        assertEquals(0, index.unplacedCount)
+        // 重复登记同 id 视为替换，新组件需要重新上报矩形
+        index.put("a", Widget("a"))
+        assertEquals(1, index.unplacedCount)
+        assertEquals(1, index.size)
+        assertTrue(hitIds(5, 5).isEmpty())
+    }
+
+    @Test
+    fun removeAndClearDropWidgets() {
+        put("a", 0, 0, 100, 100)
+        put("b", 0, 0, 100, 100)
+
+        assertTrue(index.remove("a"))
+        assertFalse(index.remove("a"))
+        assertNull(index["a"])
+        assertEquals(listOf("b"), hitIds(50, 50))
+
+        index.clear()
+        assertEquals(0, index.size)
+        assertTrue(hitIds(50, 50).isEmpty())
+    }
+
+    private fun put(id: String, left: Int, top: Int, right: Int, bottom: Int) {
+        index.put(id, Widget(id))
+        index.updateRect(id, left, top, right, bottom)
+    }
+
+    private fun hitIds(x: Int, y: Int): List<String> = index.hitTest(x, y, TAG).map { it.widget.id }
+
+    private companion object {
+        const val TAG = "video-widget"
+    }
+}